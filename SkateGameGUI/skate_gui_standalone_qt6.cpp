@@ -15,63 +15,127 @@
 #include <QGroupBox>
 #include <QFont>
 #include <QTimer>
+#include <QListWidget>
+#include <QColor>
+#include <QBrush>
+#include <QMetaObject>
+#include <QEvent>
+#include <QKeyEvent>
+#include <algorithm>
 #include <random>
 #include <ctime>
 #include <string>
 #include <vector>
+#include <fstream>
+#ifdef SKATE_GUI_BENCH
+#include <QMouseEvent>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#endif
 
-// Trick class
-class Trick {
-public:
-    std::string name;
-    int difficulty; // 1-10 scale
-
-    Trick(std::string n, int d) : name(n), difficulty(d) {}
-};
+#include "skate_core.h"
+#include "skate_skill.h"
+#include "skate_rules.h"
+#include "skate_odds.h"
+#include "skate_trace.h"
+#include "skate_latency.h"
+#ifdef SKATE_GUI_BENCH
+#include "skate_allocs.h" // counts what each click allocates
+#endif
 
 // Player class
 class Player {
 public:
     std::string name;
     std::string letters;
+    std::string word; // spelling all of it loses the game
+    int skillRow; // row in the skill model, or -1 to use the difficulty formula
+    QString label; // name as shown in messages, converted once per game
 
-    Player(std::string n) : name(n), letters("") {}
+    Player(std::string n, std::string w = RuleSet().word())
+        : name(n), letters(""), word(w), skillRow(-1), label(QString::fromStdString(n)) {}
+
+    // Ready the slot for a new match, keeping the memory of the old name and letters
+    void reset(const std::string &n, const std::string &w) {
+        name = n;
+        word = w;
+        letters.clear();
+        skillRow = -1;
+        label = QString::fromStdString(n);
+    }
 
     void addLetter() {
-        std::string skate = "SKATE";
-        if (letters.length() < 5) {
-            letters += skate[letters.length()];
+        if (letters.length() < word.length()) {
+            letters += word[letters.length()];
         }
     }
 
     bool hasLost() {
-        return letters == "SKATE";
+        return letters == word;
     }
     
     std::string getStatus() {
         if (letters.empty()) {
             return "No letters";
         } else {
-            return letters + " (" + std::to_string(letters.length()) + "/5)";
+            return letters + " (" + std::to_string(letters.length()) + "/" + std::to_string(word.length()) + ")";
         }
     }
 };
 
+// A row of the odds panel. Rows sort by the setter's chance, equal chances in trick order.
+class OddsItem : public QListWidgetItem {
+public:
+    OddsItem(TrickId t, QListWidget *list) : QListWidgetItem(list), trick(t), chance(-1.0) {}
+
+    bool operator<(const QListWidgetItem &other) const override {
+        const OddsItem &that = static_cast<const OddsItem &>(other);
+        return chance != that.chance ? chance < that.chance : trick > that.trick;
+    }
+
+    TrickId trick;
+    double chance; // -1 until it arrives
+};
+
+// How often the rows are re-sorted while a big catalog fills the panel in
+const int kOddsSortMs = 100;
+
 // Main window class
 class SkateGameWindow : public QMainWindow {
     Q_OBJECT
 
 private:
     // Game state
-    std::vector<Trick> tricks;
+    std::shared_ptr<const TrickCatalog> catalog; // shared, never copied
+    TrickCatalog tricks;                         // view of *catalog
+    std::vector<int> thresholds; // landing threshold of every trick under the current rules
+    QStringList trickNames;      // display name of every trick, by TrickId
+    Player playerSlots[2]; // reused by every game
     Player *player1;
     Player *player2;
     Player *currentSetter;
     Player *currentResponder;
     std::mt19937 rng;
     bool gameInProgress;
+    const SkillModel *skill; // fitted success chances, or nullptr for the difficulty formula
+    RuleSet rules;
+    bool secondTryUsed;      // the responder already missed once this round on their last letter
+    TrickOddsWorker odds;    // works out the odds panel off the UI thread
+    long oddsRequest;        // latest position asked for
+    long oddsShown;          // position the panel shows
+    std::vector<OddsItem *> oddsItems; // the row of each trick, owned by the panel
+    size_t oddsArrived;      // tricks of the shown position with their odds in
+    int oddsBest;            // trick in bold, or -1
+    int oddsSelected;        // trick highlighted, or -1
+    QTimer *oddsSort;        // puts the rows back in order while chunks arrive
+    LatencyMonitor latency;  // click-to-paint latency and event loop stalls
+    bool measuring;          // latency is being measured
+    QTimer *heartbeat;       // late ticks are stalls
     
     // UI elements
+    QLabel *titleLabel;
     QLineEdit *player1NameEdit;
     QLineEdit *player2NameEdit;
     QPushButton *startGameButton;
@@ -82,13 +146,23 @@ private:
     QLabel *player2StatusLabel;
     QLabel *gameStatusLabel;
     QLabel *currentTrickLabel;
+    QListWidget *oddsList;
+    QLabel *latencyOverlay;
     QGroupBox *setupGroup;
     QGroupBox *gameplayGroup;
     QGroupBox *player1Box;
     QGroupBox *player2Box;
 
 public:
-    SkateGameWindow(QWidget *parent = nullptr) : QMainWindow(parent) {
+    SkateGameWindow(QWidget *parent = nullptr)
+        : QMainWindow(parent), playerSlots{Player(""), Player("")},
+          odds([this](long request, size_t first, const std::vector<double> &chances) {
+              // Runs on the worker thread; the panel is only touched on the UI thread
+              QMetaObject::invokeMethod(this, [this, request, first, chances]() { showOdds(request, first, chances); },
+                                        Qt::QueuedConnection);
+          }),
+          oddsRequest(0), oddsShown(0), oddsArrived(0), oddsBest(-1), oddsSelected(-1), oddsSort(nullptr),
+          measuring(false), heartbeat(nullptr) {
         // Initialize window properties
         setWindowTitle("Game of SKATE");
         setMinimumSize(600, 500);
@@ -99,46 +173,65 @@ public:
         currentSetter = nullptr;
         currentResponder = nullptr;
         gameInProgress = false;
+        skill = nullptr;
+        secondTryUsed = false;
         
         // Seed random number generator
         rng.seed(static_cast<unsigned int>(time(nullptr)));
         
-        // Initialize trick library
-        initializeTricks();
+        // Built-in tricks
+        catalog = sharedDefaultCatalog();
+        tricks = *catalog;
+        for (const auto &trick : tricks) {
+            trickNames.append(QString::fromUtf8(trick.name));
+        }
+        updateThresholds();
         
         // Setup UI
         setupUI();
     }
 
-    ~SkateGameWindow() {
-        delete player1;
-        delete player2;
-    }
-
-    void initializeTricks() {
-        tricks.clear();
-        
-        // Add tricks one by one
-        tricks.push_back(Trick("Ollie", 1));
-        tricks.push_back(Trick("Kickflip", 3));
-        tricks.push_back(Trick("Heelflip", 3));
-        tricks.push_back(Trick("Pop Shove-it", 2));
-        tricks.push_back(Trick("360 Flip", 5));
-        tricks.push_back(Trick("Hardflip", 6));
-        tricks.push_back(Trick("Varial Kickflip", 4));
-        tricks.push_back(Trick("Varial Heelflip", 4));
-        tricks.push_back(Trick("Backside 180", 2));
-        tricks.push_back(Trick("Frontside 180", 2));
-        tricks.push_back(Trick("Backside 360", 5));
-        tricks.push_back(Trick("Frontside 360", 5));
-        tricks.push_back(Trick("Impossible", 7));
-        tricks.push_back(Trick("Casper Flip", 7));
-        tricks.push_back(Trick("Nollie", 2));
-        tricks.push_back(Trick("Switch Ollie", 3));
-        tricks.push_back(Trick("Kickflip to Manual", 6));
-        tricks.push_back(Trick("Impossible Late Flip", 9));
-        tricks.push_back(Trick("Dolphin Flip", 8));
-        tricks.push_back(Trick("Double Kickflip", 6));
+    // Use fitted per-player chances instead of the difficulty formula.
+    // Players the model does not know keep using the formula.
+    void useSkillModel(const SkillModel *model) {
+        skill = model;
+    }
+
+    // Play for another word and/or with two tries on the last letter; applies from the next game
+    void useRules(const RuleSet &ruleSet) {
+        rules = ruleSet;
+        updateThresholds();
+        QString title = QString("Game of %1").arg(QString::fromStdString(rules.word()));
+        setWindowTitle(title);
+        titleLabel->setText(title);
+    }
+
+    // Measure how long clicks take to show and how long the event loop stalls, writing every
+    // sample to `log` (if not null) and showing the figures over the window if `overlay`
+    void measureLatency(std::ostream *log, bool overlay) {
+        measuring = true;
+        latency.logTo(log);
+        qApp->installEventFilter(this);
+        heartbeat = new QTimer(this);
+        connect(heartbeat, &QTimer::timeout, this, [this]() {
+            if (latency.heartbeat(LatencyMonitor::Clock::now())) {
+                updateLatencyOverlay();
+            }
+        });
+        heartbeat->start(kHeartbeatMs);
+        latencyOverlay->setVisible(overlay);
+        updateLatencyOverlay();
+    }
+
+    const LatencyMonitor &latencyMonitor() const {
+        return latency;
+    }
+
+    void updateThresholds() {
+        thresholds.clear();
+        for (const auto& trick : tricks) {
+            thresholds.push_back(trickThreshold(trick, rules.info().curve));
+        }
     }
 
     void setupUI() {
@@ -148,7 +241,7 @@ public:
         QVBoxLayout *mainLayout = new QVBoxLayout(centralWidget);
         
         // Title
-        QLabel *titleLabel = new QLabel("Game of SKATE", this);
+        titleLabel = new QLabel("Game of SKATE", this);
         QFont titleFont = titleLabel->font();
         titleFont.setPointSize(20);
         titleFont.setBold(true);
@@ -162,13 +255,16 @@ public:
         
         QLabel *player1Label = new QLabel("Player 1 Name:", this);
         player1NameEdit = new QLineEdit(this);
+        player1NameEdit->setObjectName("player1Name");
         player1NameEdit->setPlaceholderText("Enter name");
         
         QLabel *player2Label = new QLabel("Player 2 Name:", this);
         player2NameEdit = new QLineEdit(this);
+        player2NameEdit->setObjectName("player2Name");
         player2NameEdit->setPlaceholderText("Enter name");
         
         startGameButton = new QPushButton("Start Game", this);
+        startGameButton->setObjectName("startGame");
         
         setupLayout->addWidget(player1Label, 0, 0);
         setupLayout->addWidget(player1NameEdit, 0, 1);
@@ -216,21 +312,33 @@ public:
         QHBoxLayout *trickLayout = new QHBoxLayout();
         QLabel *selectTrickLabel = new QLabel("Select Trick:", this);
         trickSelector = new QComboBox(this);
+        trickSelector->setObjectName("trickSelector");
         
         // Populate the trick selector
-        for (const auto& trick : tricks) {
-            trickSelector->addItem(QString::fromStdString(trick.name + " (Difficulty: " + 
-                                   std::to_string(trick.difficulty) + ")"));
+        for (size_t i = 0; i < tricks.size(); i++) {
+            trickSelector->addItem(QString("%1 (Difficulty: %2)").arg(trickNames[i]).arg(tricks[i].difficulty));
         }
         
         trickLayout->addWidget(selectTrickLabel);
         trickLayout->addWidget(trickSelector);
         gameplayLayout->addLayout(trickLayout);
         
+        // The setter's chance of winning the game with each trick, best first
+        QGroupBox *oddsGroup = new QGroupBox("Win Odds for the Setter", this);
+        QVBoxLayout *oddsLayout = new QVBoxLayout(oddsGroup);
+        oddsList = new QListWidget(this);
+        oddsLayout->addWidget(oddsList);
+        gameplayLayout->addWidget(oddsGroup);
+        oddsSort = new QTimer(this);
+        oddsSort->setSingleShot(true);
+        oddsSort->setInterval(kOddsSortMs);
+        
         // Action buttons
         QHBoxLayout *actionLayout = new QHBoxLayout();
         attemptTrickButton = new QPushButton("Attempt Trick", this);
         matchTrickButton = new QPushButton("Match Trick", this);
+        attemptTrickButton->setObjectName("attemptTrick");
+        matchTrickButton->setObjectName("matchTrick");
         matchTrickButton->setEnabled(false);
         
         actionLayout->addWidget(attemptTrickButton);
@@ -239,31 +347,94 @@ public:
         
         mainLayout->addWidget(gameplayGroup);
         
+        // Latency figures over the top left corner, out of the layout and of the mouse's way
+        latencyOverlay = new QLabel(this);
+        latencyOverlay->setStyleSheet("background: rgba(0, 0, 0, 160); color: white; padding: 4px;");
+        latencyOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+        latencyOverlay->move(8, 8);
+        latencyOverlay->setVisible(false);
+        
         // Connect signals to slots
         connect(startGameButton, &QPushButton::clicked, this, &SkateGameWindow::startGame);
         connect(attemptTrickButton, &QPushButton::clicked, this, &SkateGameWindow::attemptSetterTrick);
         connect(matchTrickButton, &QPushButton::clicked, this, &SkateGameWindow::attemptResponderTrick);
+        connect(trickSelector, &QComboBox::currentIndexChanged, this, [this]() { highlightSelected(); });
+        connect(oddsList, &QListWidget::itemClicked, this, [this](QListWidgetItem *item) {
+            trickSelector->setCurrentIndex(static_cast<OddsItem *>(item)->trick);
+        });
+        connect(oddsSort, &QTimer::timeout, this, [this]() { oddsList->sortItems(Qt::DescendingOrder); });
     }
 
+protected:
+    // Input for any widget of the application starts a latency measurement. A click acts on its
+    // release, so the press is not counted, and a held key counts once, not every repeat.
+    bool eventFilter(QObject *watched, QEvent *event) override {
+        QEvent::Type type = event->type();
+        bool keyDown = type == QEvent::KeyPress && !static_cast<QKeyEvent *>(event)->isAutoRepeat();
+        if (type == QEvent::MouseButtonRelease || keyDown) {
+            latency.input(LatencyMonitor::Clock::now());
+        }
+        return QMainWindow::eventFilter(watched, event);
+    }
+    
+    // The window paints all its widgets on an update request, so once it returns the frame is done
+    bool event(QEvent *event) override {
+        bool handled = QMainWindow::event(event);
+        if (measuring && event->type() == QEvent::UpdateRequest && latency.painted(LatencyMonitor::Clock::now())) {
+            updateLatencyOverlay();
+        }
+        return handled;
+    }
+    
+private:
+    void updateLatencyOverlay() {
+        if (latencyOverlay->isHidden()) {
+            return;
+        }
+        LatencySummary clicks = latency.inputLatency();
+        LatencySummary stalls = latency.stallLength();
+        latencyOverlay->setText(
+            QString("Click to paint: last %1 ms, median %2, p95 %3, max %4 (%5 clicks)\n"
+                    "Stalls over %6 ms: %7, longest %8 ms")
+                .arg(clicks.last, 0, 'f', 1).arg(clicks.median, 0, 'f', 1).arg(clicks.p95, 0, 'f', 1)
+                .arg(clicks.max, 0, 'f', 1).arg(static_cast<qulonglong>(clicks.count)).arg(kStallMs, 0, 'f', 0)
+                .arg(static_cast<qulonglong>(stalls.count)).arg(stalls.max, 0, 'f', 1));
+        latencyOverlay->adjustSize();
+        latencyOverlay->raise();
+    }
+    
+    // A message that leaves the event loop running: open() instead of exec()
+    QMessageBox *openMessage(const QString &title, const QString &text) {
+        QMessageBox *box = new QMessageBox(this);
+        box->setAttribute(Qt::WA_DeleteOnClose);
+        box->setWindowTitle(title);
+        box->setText(text);
+        box->open();
+        return box;
+    }
+    
 private slots:
     void startGame() {
+        SKATE_TRACE_SCOPE("start game");
         // Get player names
         std::string name1 = player1NameEdit->text().toStdString();
         std::string name2 = player2NameEdit->text().toStdString();
         
         // Validate names
         if (name1.empty() || name2.empty()) {
-            QMessageBox::warning(this, "Invalid Names", "Please enter names for both players.");
+            openMessage("Invalid Names", "Please enter names for both players.");
             return;
         }
         
-        // Clean up previous game if any
-        delete player1;
-        delete player2;
-        
-        // Initialize new game
-        player1 = new Player(name1);
-        player2 = new Player(name2);
+        // Initialize new game in the player slots of the last one
+        player1 = &playerSlots[0];
+        player2 = &playerSlots[1];
+        player1->reset(name1, rules.word());
+        player2->reset(name2, rules.word());
+        if (skill) {
+            player1->skillRow = skill->playerRow(name1);
+            player2->skillRow = skill->playerRow(name2);
+        }
         currentSetter = player1;
         currentResponder = player2;
         gameInProgress = true;
@@ -273,20 +444,121 @@ private slots:
         gameplayGroup->setVisible(true);
         
         // Update player box titles
-        player1Box->setTitle(QString::fromStdString(player1->name));
-        player2Box->setTitle(QString::fromStdString(player2->name));
+        player1Box->setTitle(player1->label);
+        player2Box->setTitle(player2->label);
         
         // Update player status
         updatePlayerStatus();
         
         // Update game status
-        QString message = QString("Game started! %1 sets the first trick.").arg(
-            QString::fromStdString(currentSetter->name));
+        QString message = QString("Game started! %1 sets the first trick.").arg(currentSetter->label);
         gameStatusLabel->setText(message);
         
         // Enable/disable buttons
         attemptTrickButton->setEnabled(true);
         matchTrickButton->setEnabled(false);
+        
+        // Both players' chances are fixed for the game, so the matchup is solved once
+        std::vector<std::vector<int>> chances(2);
+        for (size_t i = 0; i < tricks.size(); i++) {
+            chances[0].push_back(trickChance(player1, static_cast<TrickId>(i)));
+            chances[1].push_back(trickChance(player2, static_cast<TrickId>(i)));
+        }
+        odds.setMatchup(chances, rules, true);
+        requestOdds();
+    }
+    
+    // Ask for the odds of the position on the table
+    void requestOdds() {
+        BotState state = {{static_cast<int>(player1->letters.length()), static_cast<int>(player2->letters.length())},
+                          currentSetter == player1 ? 0 : 1};
+        oddsRequest = odds.request(state);
+    }
+    
+    // A chunk of the odds arrived; anything for an older position is dropped. Only the chunk's
+    // rows change; the order is put right once every trick is in, or every kOddsSortMs until then.
+    void showOdds(long request, size_t first, const std::vector<double> &chances) {
+        SKATE_TRACE_SCOPE("show odds");
+        if (request != oddsRequest) {
+            return;
+        }
+        if (request != oddsShown) {
+            oddsShown = request;
+            clearOdds();
+        }
+        int best = oddsBest;
+        for (size_t i = 0; i < chances.size(); i++) {
+            TrickId trick = static_cast<TrickId>(first + i);
+            OddsItem *item = oddsItems[trick];
+            item->chance = chances[i];
+            item->setText(QString("%1%  %2 (Difficulty: %3)").arg(chances[i] * 100.0, 5, 'f', 1).arg(trickNames[trick]).arg(tricks[trick].difficulty));
+            item->setHidden(false);
+            if (best < 0 || *oddsItems[best] < *item) {
+                best = trick;
+            }
+        }
+        oddsArrived += chances.size();
+        showBest(best);
+        if (oddsArrived >= oddsItems.size()) {
+            oddsSort->stop();
+            oddsList->sortItems(Qt::DescendingOrder);
+        } else if (!oddsSort->isActive()) {
+            oddsSort->start();
+        }
+    }
+    
+    // A new position: every row is hidden until its odds arrive. The rows themselves are kept.
+    void clearOdds() {
+        if (oddsItems.size() != tricks.size()) {
+            oddsList->clear();
+            oddsItems.clear();
+            for (size_t i = 0; i < tricks.size(); i++) {
+                oddsItems.push_back(new OddsItem(static_cast<TrickId>(i), oddsList));
+            }
+            oddsBest = -1;
+            oddsSelected = -1;
+        }
+        for (OddsItem *item : oddsItems) {
+            item->chance = -1.0;
+            item->setHidden(true);
+        }
+        oddsArrived = 0;
+        showBest(-1);
+        highlightSelected();
+    }
+    
+    // The best trick so far in bold
+    void showBest(int trick) {
+        if (trick == oddsBest) {
+            return;
+        }
+        QFont font;
+        if (oddsBest >= 0) {
+            font = oddsItems[oddsBest]->font();
+            font.setBold(false);
+            oddsItems[oddsBest]->setFont(font);
+        }
+        oddsBest = trick;
+        if (oddsBest >= 0) {
+            font = oddsItems[oddsBest]->font();
+            font.setBold(true);
+            oddsItems[oddsBest]->setFont(font);
+        }
+    }
+    
+    // The selected trick's row highlighted; only the old and the new row change
+    void highlightSelected() {
+        int selected = trickSelector->currentIndex();
+        if (selected == oddsSelected) {
+            return;
+        }
+        if (oddsSelected >= 0) {
+            oddsItems[oddsSelected]->setBackground(QBrush());
+        }
+        oddsSelected = selected >= 0 && selected < static_cast<int>(oddsItems.size()) ? selected : -1;
+        if (oddsSelected >= 0) {
+            oddsItems[oddsSelected]->setBackground(QColor(255, 236, 179));
+        }
     }
     
     void updatePlayerStatus() {
@@ -298,33 +570,31 @@ private slots:
     }
     
     void attemptSetterTrick() {
+        SKATE_TRACE_SCOPE("setter attempt");
         // Get selected trick
-        int trickIndex = trickSelector->currentIndex();
-        Trick selectedTrick = tricks[trickIndex];
+        TrickId trick = static_cast<TrickId>(trickSelector->currentIndex());
         
         // Update current trick label
-        currentTrickLabel->setText(QString("Current trick: %1").arg(
-            QString::fromStdString(selectedTrick.name)));
+        currentTrickLabel->setText(QString("Current trick: %1").arg(trickNames[trick]));
         
         // Attempt the trick
-        bool success = attemptTrick(selectedTrick);
+        bool success = attemptTrick(currentSetter, trick);
         
         // Update game status
         if (success) {
             // Setter landed the trick
             QString message = QString("%1 landed the %2!").arg(
-                QString::fromStdString(currentSetter->name),
-                QString::fromStdString(selectedTrick.name));
+                currentSetter->label, trickNames[trick]);
             gameStatusLabel->setText(message);
             
             // Enable responder to match
+            secondTryUsed = false;
             attemptTrickButton->setEnabled(false);
             matchTrickButton->setEnabled(true);
         } else {
             // Setter failed the trick
             QString message = QString("%1 failed to land the %2! Switching roles...").arg(
-                QString::fromStdString(currentSetter->name),
-                QString::fromStdString(selectedTrick.name));
+                currentSetter->label, trickNames[trick]);
             gameStatusLabel->setText(message);
             
             // Switch roles
@@ -333,35 +603,40 @@ private slots:
     }
     
     void attemptResponderTrick() {
+        SKATE_TRACE_SCOPE("responder attempt");
         // Get the currently selected trick
-        int trickIndex = trickSelector->currentIndex();
-        Trick selectedTrick = tricks[trickIndex];
+        TrickId trick = static_cast<TrickId>(trickSelector->currentIndex());
         
         // Attempt the trick
-        bool success = attemptTrick(selectedTrick);
+        bool success = attemptTrick(currentResponder, trick);
         
         // Update game status
         if (success) {
             // Responder landed the trick
             QString message = QString("%1 successfully landed the %2! Switching roles...").arg(
-                QString::fromStdString(currentResponder->name),
-                QString::fromStdString(selectedTrick.name));
+                currentResponder->label, trickNames[trick]);
             gameStatusLabel->setText(message);
             
             // Switch roles
             switchRoles();
+        } else if (!secondTryUsed && rules.secondTry(static_cast<int>(currentResponder->letters.length()))) {
+            // One more try before the last letter
+            secondTryUsed = true;
+            QString message = QString("%1 missed the %2 - one more try on the last letter!").arg(
+                currentResponder->label, trickNames[trick]);
+            gameStatusLabel->setText(message);
         } else {
             // Responder failed the trick
             QString message = QString("%1 failed to land the %2!").arg(
-                QString::fromStdString(currentResponder->name),
-                QString::fromStdString(selectedTrick.name));
+                currentResponder->label, trickNames[trick]);
             gameStatusLabel->setText(message);
             
             // Add a letter to responder
-            currentResponder->addLetter();
-            
-            // Update player status
-            updatePlayerStatus();
+            {
+                SKATE_TRACE_SCOPE("letter award");
+                currentResponder->addLetter();
+                updatePlayerStatus();
+            }
             
             // Check if game is over
             if (isGameOver()) {
@@ -373,18 +648,28 @@ private slots:
         }
     }
     
-    bool attemptTrick(const Trick& trick) {
-        // Calculate success probability based on trick difficulty
-        int successChance = 95 - (trick.difficulty * 8);
+    // Chance (in percent) that the player lands the trick
+    int trickChance(const Player *player, TrickId trick) const {
+        // Use the player's fitted chance if we have one, otherwise the difficulty formula
+        if (skill && player->skillRow >= 0 && trick < skill->trickCount()) {
+            return skill->successChance(player->skillRow, trick);
+        }
+        return thresholds[trick];
+    }
+    
+    bool attemptTrick(const Player *player, TrickId trick) {
+        SKATE_TRACE_SCOPE("attempt");
+        int chance = trickChance(player, trick);
         
         // Random number between 1-100
         std::uniform_int_distribution<int> dist(1, 100);
         int roll = dist(rng);
         
-        return roll <= successChance;
+        return roll <= chance;
     }
     
     void switchRoles() {
+        SKATE_TRACE_SCOPE("role switch");
         // Switch setter and responder
         if (currentSetter == player1) {
             currentSetter = player2;
@@ -395,13 +680,14 @@ private slots:
         }
         
         // Update game status
-        QString message = QString("%1 is now setting tricks.").arg(
-            QString::fromStdString(currentSetter->name));
+        QString message = QString("%1 is now setting tricks.").arg(currentSetter->label);
         gameStatusLabel->setText(message);
         
         // Enable/disable buttons
         attemptTrickButton->setEnabled(true);
         matchTrickButton->setEnabled(false);
+        
+        requestOdds();
     }
     
     bool isGameOver() {
@@ -410,30 +696,31 @@ private slots:
     
     void gameOver() {
         // Determine winner
-        std::string winnerName;
-        if (player1->hasLost()) {
-            winnerName = player2->name;
-        } else {
-            winnerName = player1->name;
-        }
-        
-        // Show game over message
-        QString message = QString("%1 WINS THE GAME!").arg(QString::fromStdString(winnerName));
-        QMessageBox::information(this, "Game Over", message);
+        const Player *winner = player1->hasLost() ? player2 : player1;
+        QString message = QString("%1 WINS THE GAME!").arg(winner->label);
+        gameStatusLabel->setText(message);
         
         // Disable trick buttons
         attemptTrickButton->setEnabled(false);
         matchTrickButton->setEnabled(false);
         
-        // Show option to play again
-        QMessageBox playAgainBox;
-        playAgainBox.setText("Do you want to play again?");
-        QPushButton *yesButton = playAgainBox.addButton("Yes", QMessageBox::AcceptRole);
-        playAgainBox.addButton("No", QMessageBox::RejectRole);
-        
-        playAgainBox.exec();
-        
-        if (playAgainBox.clickedButton() == yesButton) {
+        // Ask about another game without waiting for the answer here; the window keeps painting
+        QMessageBox *playAgainBox = new QMessageBox(this);
+        playAgainBox->setObjectName("playAgain");
+        playAgainBox->setAttribute(Qt::WA_DeleteOnClose);
+        playAgainBox->setWindowTitle("Game Over");
+        playAgainBox->setText(message);
+        playAgainBox->setInformativeText("Do you want to play again?");
+        QPushButton *yesButton = playAgainBox->addButton("Yes", QMessageBox::AcceptRole);
+        playAgainBox->addButton("No", QMessageBox::RejectRole);
+        connect(playAgainBox, &QMessageBox::finished, this, [this, playAgainBox, yesButton]() {
+            playAgain(playAgainBox->clickedButton() == yesButton);
+        });
+        playAgainBox->open();
+    }
+    
+    void playAgain(bool again) {
+        if (again) {
             // Reset to setup screen
             gameplayGroup->setVisible(false);
             setupGroup->setVisible(true);
@@ -445,14 +732,221 @@ private slots:
     }
 };
 
+#ifdef SKATE_GUI_BENCH
+// Headless benchmark (the SkateGameGUIBench target): plays whole games in the real window under
+// Qt's offscreen platform, sending the mouse clicks a player would, and reports how long each
+// kind of click spends in its slot, how much it allocates on the UI thread and how long it takes
+// to show. The next click only comes once the last one is on screen.
+//
+// Usage: SkateGameGUIBench [games] (default 1000)
+
+struct ClickStats {
+    const char *name;
+    long clicks;
+    double seconds;   // in the slot, from press to the end of the release
+    long allocations; // on the UI thread in that time
+};
+
+class GuiBench {
+public:
+    GuiBench(SkateGameWindow &w, int gameCount)
+        : window(w), games(gameCount), finished(0), unpainted(0), rng(1),
+          starts{"Start Game", 0, 0.0, 0}, attempts{"Attempt Trick", 0, 0.0, 0},
+          matches{"Match Trick", 0, 0.0, 0}, answers{"Play Again", 0, 0.0, 0} {
+        start = window.findChild<QPushButton *>("startGame");
+        attempt = window.findChild<QPushButton *>("attemptTrick");
+        match = window.findChild<QPushButton *>("matchTrick");
+        tricks = window.findChild<QComboBox *>("trickSelector");
+        window.findChild<QLineEdit *>("player1Name")->setText("Alice");
+        window.findChild<QLineEdit *>("player2Name")->setText("Bob");
+    }
+
+    // One click, then back to the event loop for the next
+    void step() {
+        // Wait (a little) for the last click to be painted
+        const double kPaintWaitMs = 100.0;
+        if (window.latencyMonitor().waiting()) {
+            double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - clickedAt).count();
+            if (waited < kPaintWaitMs) {
+                next();
+                return;
+            }
+            unpainted++;
+        }
+
+        QMessageBox *box = nullptr;
+        for (QMessageBox *candidate : window.findChildren<QMessageBox *>("playAgain")) {
+            box = candidate->isVisible() ? candidate : box;
+        }
+        if (box) {
+            // "No" after the last game quits the application
+            finished++;
+            bool more = finished < games;
+            for (QAbstractButton *button : box->buttons()) {
+                if ((box->buttonRole(button) == QMessageBox::AcceptRole) == more) {
+                    click(button, answers);
+                    break;
+                }
+            }
+            if (!more) {
+                return;
+            }
+        } else if (start->isVisible()) {
+            click(start, starts);
+        } else if (attempt->isEnabled()) {
+            tricks->setCurrentIndex(std::uniform_int_distribution<int>(0, tricks->count() - 1)(rng));
+            click(attempt, attempts);
+        } else {
+            click(match, matches);
+        }
+        next();
+    }
+
+    void report(double seconds) const {
+        long clicks = starts.clicks + attempts.clicks + matches.clicks + answers.clicks;
+        std::cout << "SkateGameGUI benchmark: " << finished << " games, " << clicks << " clicks in " << std::fixed
+                  << std::setprecision(2) << seconds << " s (" << std::setprecision(0) << clicks / seconds
+                  << " clicks/s, painted in between)" << std::endl;
+        for (const ClickStats *stats : {&starts, &attempts, &matches, &answers}) {
+            if (stats->clicks == 0) {
+                continue;
+            }
+            std::cout << "  " << std::left << std::setw(14) << stats->name << std::right << std::setw(8)
+                      << stats->clicks << " clicks, " << std::setprecision(1) << std::setw(8)
+                      << stats->seconds * 1e6 / stats->clicks << " us in the slot, " << std::setw(7)
+                      << static_cast<double>(stats->allocations) / stats->clicks << " allocations" << std::endl;
+        }
+        LatencySummary shown = window.latencyMonitor().inputLatency();
+        LatencySummary stalls = window.latencyMonitor().stallLength();
+        std::cout << "  Click to paint (last " << std::min(shown.count, kLatencySamples) << " inputs): median "
+                  << std::setprecision(2) << shown.median << " ms, p95 " << shown.p95 << " ms, max " << shown.max
+                  << " ms" << std::endl;
+        std::cout << "  Event loop stalls over " << std::setprecision(0) << kStallMs << " ms: " << stalls.count;
+        if (stalls.count > 0) {
+            std::cout << ", longest " << std::setprecision(1) << stalls.max << " ms";
+        }
+        std::cout << std::endl;
+        if (unpainted > 0) {
+            std::cout << "  " << unpainted << " clicks were not painted before the next one" << std::endl;
+        }
+        if (window.latencyMonitor().unpainted() > 0) {
+            std::cout << "  " << window.latencyMonitor().unpainted() << " clicks changed nothing on screen" << std::endl;
+        }
+    }
+
+private:
+    void next() {
+        QTimer::singleShot(0, &window, [this]() { step(); });
+    }
+
+    // Press and release in the middle of the button, as a mouse would
+    void click(QAbstractButton *button, ClickStats &stats) {
+        QPointF at(button->width() / 2.0, button->height() / 2.0);
+        QPointF global = button->mapToGlobal(at);
+        QMouseEvent press(QEvent::MouseButtonPress, at, global, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+        QMouseEvent release(QEvent::MouseButtonRelease, at, global, Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+        long allocations = threadAllocations;
+        clickedAt = std::chrono::steady_clock::now();
+        QCoreApplication::sendEvent(button, &press);
+        QCoreApplication::sendEvent(button, &release);
+        stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - clickedAt).count();
+        stats.allocations += threadAllocations - allocations;
+        stats.clicks++;
+    }
+
+    SkateGameWindow &window;
+    int games;
+    int finished;
+    long unpainted;
+    std::mt19937 rng;
+    std::chrono::steady_clock::time_point clickedAt;
+    QPushButton *start;
+    QPushButton *attempt;
+    QPushButton *match;
+    QComboBox *tricks;
+    ClickStats starts;
+    ClickStats attempts;
+    ClickStats matches;
+    ClickStats answers;
+};
+
+int main(int argc, char *argv[]) {
+    // No display needed
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    int games = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+
+    SkateGameWindow window;
+    window.measureLatency(nullptr, false);
+    window.show();
+
+    GuiBench bench(window, games);
+    auto start = std::chrono::steady_clock::now();
+    QTimer::singleShot(0, &window, [&bench]() { bench.step(); });
+    app.exec();
+    bench.report(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}
+#else
 // Main function
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
+    SKATE_TRACE_THREAD("gui");
     
     SkateGameWindow window;
+    
+    // Optional fitted skill model: SkateGameGUI --skill model.txt
+    SkillModel skillModel;
+    QStringList args = app.arguments();
+    int skillArg = args.indexOf("--skill");
+    if (skillArg >= 0 && skillArg + 1 < args.size()) {
+        std::ifstream in(args[skillArg + 1].toStdString());
+        if (skillModel.load(in)) {
+            window.useSkillModel(&skillModel);
+        } else {
+            QMessageBox::warning(nullptr, "Skill Model", "Could not read " + args[skillArg + 1]);
+        }
+    }
+    
+    // Optional rule variant: SkateGameGUI --rules pig:retry
+    int rulesArg = args.indexOf("--rules");
+    if (rulesArg >= 0 && rulesArg + 1 < args.size()) {
+        RuleSet rules;
+        if (parseRuleSet(args[rulesArg + 1].toStdString(), rules)) {
+            window.useRules(rules);
+        } else {
+            QMessageBox::warning(nullptr, "Rules", "Unknown rules " + args[rulesArg + 1]);
+        }
+    }
+    
+    // Optional latency figures: SkateGameGUI --latency latency.log and/or --overlay
+    std::ofstream latencyLog;
+    int latencyArg = args.indexOf("--latency");
+    if (latencyArg >= 0 && latencyArg + 1 < args.size()) {
+        latencyLog.open(args[latencyArg + 1].toStdString(), std::ios::app);
+        if (!latencyLog) {
+            QMessageBox::warning(nullptr, "Latency", "Could not open " + args[latencyArg + 1]);
+        }
+    }
+    bool overlay = args.contains("--overlay");
+    if (latencyLog.is_open() || overlay) {
+        window.measureLatency(latencyLog.is_open() ? &latencyLog : nullptr, overlay);
+    }
+    
+    // Optional timeline of the slots: SkateGameGUI --trace trace.json (built with -DSKATE_TRACE)
+    int traceArg = args.indexOf("--trace");
+    
     window.show();
     
-    return app.exec();
+    int result = app.exec();
+    if (traceArg >= 0 && traceArg + 1 < args.size()) {
+        std::ofstream out(args[traceArg + 1].toStdString());
+        writeChromeTrace(out);
+    }
+    return result;
 }
+#endif
 
 #include "skate_gui_standalone_qt6.moc"
\ No newline at end of file
@@ -8,31 +8,45 @@
 #include <ctime>
 #include <algorithm>
 #include <limits>
+#include <chrono>
+#include <memory>
+#include <fstream>
+#include <cstring>
 
-class Trick {
-public:
-    std::string name;
-    int difficulty; // 1-10 scale
-
-    Trick(std::string n, int d) : name(n), difficulty(d) {}
-};
+#include "skate_core.h"
+#include "skate_bot.h"
+#include "skate_skill.h"
+#include "skate_rules.h"
+#include "skate_house.h"
+#include "skate_session.h"
+#include "skate_leaderboard.h"
+#include "skate_replay.h"
+#include "skate_trace.h"
 
 class Player {
 public:
     std::string name;
     std::string letters;
+    std::string word; // spelling all of it loses the game
+    int skillRow; // row in the skill model, or -1 to use the difficulty formula
 
-    Player(std::string n) : name(n), letters("") {}
+    Player(std::string n, std::string w = RuleSet().word()) : name(n), letters(""), word(w), skillRow(-1) {}
+
+    // Ready the slot for a new match, keeping the memory of the old name and letters
+    void reset(const std::string& n) {
+        name = n;
+        letters.clear();
+        skillRow = -1;
+    }
 
     void addLetter() {
-        std::string skate = "SKATE";
-        if (letters.length() < 5) {
-            letters += skate[letters.length()];
+        if (letters.length() < word.length()) {
+            letters += word[letters.length()];
         }
     }
 
     bool hasLost() {
-        return letters == "SKATE";
+        return letters == word;
     }
 
     void displayStatus() {
@@ -42,78 +56,220 @@ public:
         } else {
             std::cout << letters;
         }
-        std::cout << " (" << letters.length() << "/5)" << std::endl;
+        std::cout << " (" << letters.length() << "/" << word.length() << ")" << std::endl;
     }
 };
 
+// How long the computer thinks about each trick it sets
+const int kBotThinkMs = 500;
+
 class Game {
 private:
-    std::vector<Trick> tricks;
+    std::shared_ptr<const TrickCatalog> catalog; // shared by every game, never copied
+    TrickCatalog tricks;                         // view of *catalog
+    HouseRules house;    // the rules being played, the built-in variants included
+    CompiledRules table; // the same rules as lookup tables
+    int position;        // the current position in the table
     Player player1;
     Player player2;
     Player* currentSetter;
     Player* currentResponder;
-    std::mt19937 rng;
+    std::mt19937 rng;    // draws the seed of every game
+    uint64_t seed;       // the game's dice: attempt n rolls replayRoll(seed, n)
+    uint32_t attempts;   // attempts made this game
+    int roundRolls;      // attempts made this round
+    int roundLanded;     // bit i: attempt i of this round landed
+    std::unique_ptr<MctsBot> bot; // computer opponent playing as player 2, if any
+    const SkillModel* skill;      // fitted success chances, or nullptr for the difficulty formula
+    std::ostream* attemptLog;     // where every attempt is recorded, if anywhere
+    Leaderboard* leaderboard;     // where results are reported, if anywhere
+    std::ostream* replayLog;      // where finished games are saved as replays, if anywhere
+    Replay replay;                // the game so far, while replayLog is set
 
 public:
-    Game(std::string p1Name, std::string p2Name) 
-        : player1(p1Name), player2(p2Name), 
-          currentSetter(&player1), currentResponder(&player2) {
+    Game(std::string p1Name, std::string p2Name, bool vsComputer = false, const RuleSet& ruleSet = RuleSet(),
+         std::shared_ptr<const TrickCatalog> trickCatalog = sharedDefaultCatalog()) 
+        : catalog(trickCatalog), tricks(*catalog), house(houseRulesFor(ruleSet)), position(0), player1(p1Name, house.word), player2(p2Name, house.word), 
+          currentSetter(&player1), currentResponder(&player2),
+          attempts(0), roundRolls(0), roundLanded(0), skill(nullptr), attemptLog(nullptr), leaderboard(nullptr),
+          replayLog(nullptr) {
         // Seed random number generator
         rng.seed(static_cast<unsigned int>(time(nullptr)));
+        newSeed();
         
-        // Initialize trick library
-        initializeTricks();
+        table = compileHouseRules(house, tricks);
+
+        if (vsComputer) {
+            createBot();
+        }
     }
 
-    void initializeTricks() {
-        // Clear the vector first if it might have elements
-        tricks.clear();
-        
-        // Add tricks one by one
-        tricks.push_back(Trick("Ollie", 1));
-        tricks.push_back(Trick("Kickflip", 3));
-        tricks.push_back(Trick("Heelflip", 3));
-        tricks.push_back(Trick("Pop Shove-it", 2));
-        tricks.push_back(Trick("360 Flip", 5));
-        tricks.push_back(Trick("Hardflip", 6));
-        tricks.push_back(Trick("Varial Kickflip", 4));
-        tricks.push_back(Trick("Varial Heelflip", 4));
-        tricks.push_back(Trick("Backside 180", 2));
-        tricks.push_back(Trick("Frontside 180", 2));
-        tricks.push_back(Trick("Backside 360", 5));
-        tricks.push_back(Trick("Frontside 360", 5));
-        tricks.push_back(Trick("Impossible", 7));
-        tricks.push_back(Trick("Casper Flip", 7));
-        tricks.push_back(Trick("Nollie", 2));
-        tricks.push_back(Trick("Switch Ollie", 3));
-        tricks.push_back(Trick("Kickflip to Manual", 6));
-        tricks.push_back(Trick("Impossible Late Flip", 9));
-        tricks.push_back(Trick("Dolphin Flip", 8));
-        tricks.push_back(Trick("Double Kickflip", 6));
+    // Start a new match with the same tricks, rules and computer opponent. Nothing is
+    // allocated as long as the new names fit where the old ones were.
+    void reset(const std::string& p1Name, const std::string& p2Name) {
+        int oldRows[2] = {player1.skillRow, player2.skillRow};
+        player1.reset(p1Name);
+        player2.reset(p2Name);
+        currentSetter = &player1;
+        currentResponder = &player2;
+        position = 0;
+        newSeed();
+        if (skill) {
+            player1.skillRow = skill->playerRow(player1.name);
+            player2.skillRow = skill->playerRow(player2.name);
+            // The computer only has to learn new chances if somebody else is playing
+            if (bot && (player1.skillRow != oldRows[0] || player2.skillRow != oldRows[1])) {
+                createBot();
+            }
+        }
+    }
+
+    // Use fitted per-player chances instead of the difficulty formula.
+    // Players the model does not know keep using the formula.
+    void useSkillModel(const SkillModel* model) {
+        skill = model;
+        player1.skillRow = model ? model->playerRow(player1.name) : -1;
+        player2.skillRow = model ? model->playerRow(player2.name) : -1;
+        if (bot) {
+            createBot();
+        }
+    }
+
+    // Play by house rules instead; call before the game starts
+    void useHouseRules(const HouseRules& rules) {
+        house = rules;
+        table = compileHouseRules(house, tricks);
+        player1.word = player2.word = house.word;
+        if (bot) {
+            createBot();
+        }
+    }
+
+    void logAttempts(std::ostream* log) {
+        attemptLog = log;
+    }
+
+    void reportResults(Leaderboard* board) {
+        leaderboard = board;
+    }
+
+    // Append a replay of every finished game to `log`
+    void saveReplays(std::ostream* log) {
+        replayLog = log;
+    }
+
+    // New dice for a new game
+    void newSeed() {
+        seed = static_cast<uint64_t>(rng()) << 32 | rng();
+        attempts = 0;
+        roundRolls = 0;
+        roundLanded = 0;
+    }
+
+    std::vector<int> trickDifficulties() const {
+        std::vector<int> difficulties;
+        for (const auto& trick : tricks) {
+            difficulties.push_back(trick.difficulty);
+        }
+        return difficulties;
     }
 
     void displayTricks() {
         std::cout << "\nAvailable tricks:" << std::endl;
         for (size_t i = 0; i < tricks.size(); i++) {
             std::cout << i + 1 << ". " << tricks[i].name 
-                      << " (Difficulty: " << tricks[i].difficulty << ")" << std::endl;
+                      << " (Difficulty: " << tricks[i].difficulty << ")";
+            if (table.settable(static_cast<TrickId>(i)) < 0) {
+                std::cout << " - not allowed";
+            }
+            std::cout << std::endl;
         }
     }
 
-    bool attemptTrick(const Trick& trick) {
-        // Calculate success probability based on trick difficulty
-        // Harder tricks have lower success rates
-        int successChance = 95 - (trick.difficulty * 8);
+    // Chance (in percent) that the player lands the trick
+    int trickChance(const Player* player, TrickId trick) const {
+        if (skill && player->skillRow >= 0 && trick < skill->trickCount()) {
+            return skill->successChance(player->skillRow, trick);
+        }
+        // Precomputed from the trick's difficulty when the rules were set
+        return table.thresholds[trick];
+    }
+
+    bool attemptTrick(const Player* player, TrickId trick) {
+        SKATE_TRACE_SCOPE("attempt");
+        int chance = trickChance(player, trick);
         
-        // Random number between 1-100
-        std::uniform_int_distribution<int> dist(1, 100);
-        int roll = dist(rng);
+        // Random number between 1-100, the same every time the game is replayed
+        int roll = replayRoll(seed, attempts++);
+        bool landed = roll <= chance;
+        roundLanded |= (landed ? 1 : 0) << roundRolls;
+        roundRolls++;
         
-        return roll <= successChance;
+        if (attemptLog) {
+            SKATE_TRACE_SCOPE("attempt log write");
+            *attemptLog << player->name << '\t' << trick << '\t' << (landed ? 1 : 0) << '\t'
+                        << (player == currentSetter ? 's' : 'r') << '\t' << time(nullptr) << '\n';
+        }
+        return landed;
+    }
+
+    void createBot() {
+        std::vector<std::vector<int>> chances(2);
+        for (size_t i = 0; i < tricks.size(); i++) {
+            TrickId trick = static_cast<TrickId>(i);
+            chances[0].push_back(trickChance(&player1, trick));
+            chances[1].push_back(trickChance(&player2, trick));
+        }
+        // The search plays by the same table as the game, so it never sets a trick the rules forbid
+        bot.reset(new MctsBot(chances, table));
+    }
+
+    bool hasSettableTricks() const {
+        return !table.tricks.empty();
+    }
+
+    bool isComputer(const Player* player) const {
+        return bot && player == &player2;
+    }
+
+    // Let the computer search for the best trick to set from the current position
+    TrickId chooseComputerTrick() {
+        SKATE_TRACE_SCOPE("trick selection");
+        int trick = bot->chooseTrick(table.positions[position], std::chrono::milliseconds(kBotThinkMs));
+        return static_cast<TrickId>(trick);
+    }
+
+    // Move to the position the table gives for how the round ended
+    void finishRound(int event, TrickId trick) {
+        SKATE_TRACE_SCOPE("letter award");
+        if (replayLog) {
+            recordRound(replay, position, attempts - roundRolls, trick, roundRolls, roundLanded);
+        }
+        roundRolls = 0;
+        roundLanded = 0;
+        int next = table.after(position, event);
+        const BotState& state = table.positions[next];
+        Player* players[2] = {&player1, &player2};
+        for (int i = 0; i < 2; i++) {
+            size_t before = players[i]->letters.length();
+            // assign() reuses the string's buffer, so a round allocates nothing
+            players[i]->letters.assign(table.word, 0, state.letters[i]);
+            size_t gained = players[i]->letters.length() - before;
+            if (gained == 1) {
+                std::cout << players[i]->name << " gets a letter!" << std::endl;
+            } else if (gained > 1) {
+                std::cout << players[i]->name << " gets " << gained << " letters!" << std::endl;
+            }
+        }
+        bool switched = state.setter != table.positions[position].setter;
+        position = next;
+        if (switched && !isGameOver()) {
+            switchRoles();
+        }
     }
 
     void switchRoles() {
+        SKATE_TRACE_SCOPE("role switch");
         if (currentSetter == &player1) {
             currentSetter = &player2;
             currentResponder = &player1;
@@ -130,39 +286,59 @@ public:
         displayTricks();
         
         // Get trick selection
-        int trickChoice;
-        std::cout << "Choose a trick (1-" << tricks.size() << "): ";
-        while (!(std::cin >> trickChoice) || trickChoice < 1 || trickChoice > static_cast<int>(tricks.size())) {
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::cout << "Invalid choice. Please enter a number between 1 and " << tricks.size() << ": ";
+        TrickId trick;
+        if (isComputer(currentSetter)) {
+            trick = chooseComputerTrick();
+            std::cout << currentSetter->name << " chooses trick " << trick + 1 << "." << std::endl;
+        } else {
+            SKATE_TRACE_SCOPE("trick input");
+            int trickChoice;
+            std::cout << "Choose a trick (1-" << tricks.size() << "): ";
+            while (!(std::cin >> trickChoice) || trickChoice < 1 || trickChoice > static_cast<int>(tricks.size()) ||
+                   table.settable(trickChoice - 1) < 0) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cout << "Invalid choice. Please enter the number of an allowed trick between 1 and "
+                          << tricks.size() << ": ";
+            }
+            trick = static_cast<TrickId>(trickChoice - 1);
         }
         
-        Trick selectedTrick = tricks[trickChoice - 1];
-        std::cout << currentSetter->name << " attempts a " << selectedTrick.name << "..." << std::endl;
+        const char* trickName = tricks.name(trick);
+        std::cout << currentSetter->name << " attempts a " << trickName << "..." << std::endl;
         
-        bool setterSuccess = attemptTrick(selectedTrick);
+        bool setterSuccess = attemptTrick(currentSetter, trick);
         if (!setterSuccess) {
-            std::cout << currentSetter->name << " failed to land the " << selectedTrick.name << "!" << std::endl;
-            switchRoles();
+            std::cout << currentSetter->name << " failed to land the " << trickName << "!" << std::endl;
+            finishRound(HOUSE_SETTER_MISSED, trick);
             return;
         }
         
-        std::cout << currentSetter->name << " landed the " << selectedTrick.name << "!" << std::endl;
-        std::cout << "\n" << currentResponder->name << " must now match the " << selectedTrick.name << "..." << std::endl;
+        std::cout << currentSetter->name << " landed the " << trickName << "!" << std::endl;
+        std::cout << "\n" << currentResponder->name << " must now match the " << trickName << "..." << std::endl;
         
         // Simulate responder's attempt
-        std::cout << "Press Enter to attempt the trick...";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        std::cin.get();
+        if (!isComputer(currentResponder)) {
+            std::cout << "Press Enter to attempt the trick...";
+            // A human setter left the end of their trick choice in the buffer
+            if (!isComputer(currentSetter)) {
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+            std::cin.get();
+        }
         
-        bool responderSuccess = attemptTrick(selectedTrick);
+        bool responderSuccess = attemptTrick(currentResponder, trick);
+        for (int attempt = 2; !responderSuccess && attempt <= table.tries[position]; attempt++) {
+            std::cout << currentResponder->name << " missed, but gets try " << attempt << " of "
+                      << static_cast<int>(table.tries[position]) << " on the last letter..." << std::endl;
+            responderSuccess = attemptTrick(currentResponder, trick);
+        }
         if (!responderSuccess) {
-            std::cout << currentResponder->name << " failed to land the " << selectedTrick.name << "!" << std::endl;
-            currentResponder->addLetter();
-            std::cout << currentResponder->name << " gets a letter!" << std::endl;
+            std::cout << currentResponder->name << " failed to land the " << trickName << "!" << std::endl;
+            finishRound(table.missEvent[table.settable(trick)], trick);
         } else {
-            std::cout << currentResponder->name << " successfully landed the " << selectedTrick.name << "!" << std::endl;
+            std::cout << currentResponder->name << " successfully landed the " << trickName << "!" << std::endl;
+            finishRound(HOUSE_BOTH_LANDED, trick);
         }
     }
 
@@ -178,19 +354,57 @@ public:
     }
 
     void announceWinner() {
+        const Player& winner = player1.hasLost() ? player2 : player1;
+        const Player& loser = player1.hasLost() ? player1 : player2;
         std::cout << "\n==========================" << std::endl;
-        if (player1.hasLost()) {
-            std::cout << player2.name << " WINS THE GAME!" << std::endl;
-        } else {
-            std::cout << player1.name << " WINS THE GAME!" << std::endl;
-        }
+        std::cout << winner.name << " WINS THE GAME!" << std::endl;
         std::cout << "==========================" << std::endl;
+        if (leaderboard) {
+            leaderboard->report(winner.name, loser.name);
+        }
+        if (replayLog) {
+            SKATE_TRACE_SCOPE("replay write");
+            replay.winner = player1.hasLost() ? 1 : 0;
+            saveReplay(*replayLog, replay);
+            replayLog->flush();
+        }
+    }
+
+    // Start the replay of the game about to be played
+    void startReplay() {
+        replay.seed = seed;
+        replay.firstSetter = 0;
+        replay.winner = -1;
+        replay.names[0] = player1.name;
+        replay.names[1] = player2.name;
+        replay.rules = house;
+        replay.rounds.clear();
+        replay.checkpoints.clear();
+        const Player* players[2] = {&player1, &player2};
+        for (int p = 0; p < 2; p++) {
+            replay.chances[p].clear();
+            for (size_t i = 0; i < tricks.size(); i++) {
+                replay.chances[p].push_back(trickChance(players[p], static_cast<TrickId>(i)));
+            }
+        }
     }
 
     void playGame() {
-        std::cout << "\nWelcome to SKATE!" << std::endl;
+        std::cout << "\nWelcome to " << house.word << "!" << std::endl;
         std::cout << "Players take turns setting tricks. If you fail to match your opponent's trick, you get a letter." << std::endl;
-        std::cout << "First to spell 'SKATE' loses!\n" << std::endl;
+        if (house.lastLetterTries > 1) {
+            std::cout << "On your last letter you get " << house.lastLetterTries << " tries to match." << std::endl;
+        }
+        if (house.setterPenalty > 0) {
+            std::cout << "Missing your own trick costs " << house.setterPenalty << " letter(s)." << std::endl;
+        }
+        if (house.maxDifficulty < kHouseDifficulties - 1) {
+            std::cout << "Tricks harder than difficulty " << house.maxDifficulty << " may not be set." << std::endl;
+        }
+        std::cout << "First to spell '" << house.word << "' loses!\n" << std::endl;
+        if (replayLog) {
+            startReplay();
+        }
         
         while (!isGameOver()) {
             displayGameStatus();
@@ -210,17 +424,508 @@ public:
     }
 };
 
-int main() {
+// A jam of three or more skaters (see skate_session.h), everyone at the keyboard
+class Session {
+private:
+    std::shared_ptr<const TrickCatalog> catalog;
+    TrickCatalog tricks;
+    HouseRules house;
+    std::vector<int> thresholds; // landing threshold of every trick under the house curve
+    std::vector<Player> players;
+    SessionState state;
+    std::mt19937 rng;
+    const SkillModel* skill;
+    std::ostream* attemptLog;
+    Leaderboard* leaderboard;
+
+public:
+    Session(const std::vector<std::string>& names, const RuleSet& ruleSet = RuleSet(),
+            std::shared_ptr<const TrickCatalog> trickCatalog = sharedDefaultCatalog())
+        : catalog(trickCatalog), tricks(*catalog), skill(nullptr), attemptLog(nullptr), leaderboard(nullptr) {
+        rng.seed(static_cast<unsigned int>(time(nullptr)));
+        useHouseRules(houseRulesFor(ruleSet));
+        reset(names);
+    }
+
+    // Start a new session with the same tricks and rules
+    void reset(const std::vector<std::string>& names) {
+        players.resize(names.size(), Player("", house.word));
+        for (size_t i = 0; i < names.size(); i++) {
+            players[i].reset(names[i]);
+            players[i].word = house.word;
+            players[i].skillRow = skill ? skill->playerRow(names[i]) : -1;
+        }
+        state = startSession(static_cast<int>(players.size()));
+    }
+
+    void useSkillModel(const SkillModel* model) {
+        skill = model;
+        for (Player& player : players) {
+            player.skillRow = model ? model->playerRow(player.name) : -1;
+        }
+    }
+
+    // Play by house rules instead; call before the session starts
+    void useHouseRules(const HouseRules& rules) {
+        house = rules;
+        thresholds.clear();
+        for (const TrickInfo& trick : tricks) {
+            thresholds.push_back(trickThreshold(trick, house.curve));
+        }
+        for (Player& player : players) {
+            player.word = house.word;
+        }
+    }
+
+    void logAttempts(std::ostream* log) {
+        attemptLog = log;
+    }
+
+    // The winner is reported as beating every other skater
+    void reportResults(Leaderboard* board) {
+        leaderboard = board;
+    }
+
+    bool isAllowed(TrickId trick) const {
+        return tricks[trick].difficulty <= house.maxDifficulty;
+    }
+
+    bool hasSettableTricks() const {
+        for (size_t i = 0; i < tricks.size(); i++) {
+            if (isAllowed(static_cast<TrickId>(i))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool attemptTrick(const Player& player, TrickId trick) {
+        SKATE_TRACE_SCOPE("attempt");
+        int chance = thresholds[trick];
+        if (skill && player.skillRow >= 0 && trick < skill->trickCount()) {
+            chance = skill->successChance(player.skillRow, trick);
+        }
+        std::uniform_int_distribution<int> dist(1, 100);
+        bool landed = dist(rng) <= chance;
+        if (attemptLog) {
+            SKATE_TRACE_SCOPE("attempt log write");
+            *attemptLog << player.name << '\t' << trick << '\t' << (landed ? 1 : 0) << '\t'
+                        << (&player == &players[state.setter] ? 's' : 'r') << '\t' << time(nullptr) << '\n';
+        }
+        return landed;
+    }
+
+    // Copy the letter counts of the state to the players, announcing what changed
+    void updateLetters() {
+        SKATE_TRACE_SCOPE("letter award");
+        for (size_t i = 0; i < players.size(); i++) {
+            Player& player = players[i];
+            size_t before = player.letters.length();
+            player.letters.assign(house.word, 0, state.lettersOf(static_cast<int>(i)));
+            size_t gained = player.letters.length() - before;
+            if (gained > 0) {
+                std::cout << player.name << " gets " << (gained == 1 ? "a letter" : std::to_string(gained) + " letters")
+                          << "!" << std::endl;
+            }
+            if (gained > 0 && !state.isActive(static_cast<int>(i))) {
+                std::cout << player.name << " spelled " << house.word << " and is out!" << std::endl;
+            }
+        }
+    }
+
+    void playRound() {
+        Player& setter = players[state.setter];
+        std::cout << "\n" << setter.name << "'s turn to set a trick." << std::endl;
+        std::cout << "\nAvailable tricks:" << std::endl;
+        for (size_t i = 0; i < tricks.size(); i++) {
+            std::cout << i + 1 << ". " << tricks[i].name << " (Difficulty: " << tricks[i].difficulty << ")"
+                      << (isAllowed(static_cast<TrickId>(i)) ? "" : " - not allowed") << std::endl;
+        }
+
+        int trickChoice;
+        std::cout << "Choose a trick (1-" << tricks.size() << "): ";
+        while (!(std::cin >> trickChoice) || trickChoice < 1 || trickChoice > static_cast<int>(tricks.size()) ||
+               !isAllowed(static_cast<TrickId>(trickChoice - 1))) {
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::cout << "Invalid choice. Please enter the number of an allowed trick between 1 and "
+                      << tricks.size() << ": ";
+        }
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        TrickId trick = static_cast<TrickId>(trickChoice - 1);
+        const char* trickName = tricks.name(trick);
+
+        std::cout << setter.name << " attempts a " << trickName << "..." << std::endl;
+        if (!attemptTrick(setter, trick)) {
+            std::cout << setter.name << " failed to land the " << trickName << "!" << std::endl;
+            state = setterMissed(state, house.setterPenalty, static_cast<int>(house.word.size()));
+            updateLetters();
+            if (!state.isOver()) {
+                std::cout << "\n--- " << players[state.setter].name << " is now setting tricks. ---" << std::endl;
+            }
+            return;
+        }
+        std::cout << setter.name << " landed the " << trickName << "!" << std::endl;
+
+        // Everyone still in responds in turn, starting after the setter
+        int difficulty = std::min(kHouseDifficulties - 1, std::max(0, tricks[trick].difficulty));
+        SessionState before = state;
+        for (int p = before.nextActive(before.setter); p != before.setter; p = before.nextActive(p)) {
+            Player& responder = players[p];
+            std::cout << "\n" << responder.name << " must now match the " << trickName
+                      << ". Press Enter to attempt the trick...";
+            std::cin.get();
+            int tries = before.lettersOf(p) == static_cast<int>(house.word.size()) - 1 ? house.lastLetterTries : 1;
+            bool landed = attemptTrick(responder, trick);
+            for (int attempt = 2; !landed && attempt <= tries; attempt++) {
+                std::cout << responder.name << " missed, but gets try " << attempt << " of " << tries
+                          << " on the last letter..." << std::endl;
+                landed = attemptTrick(responder, trick);
+            }
+            if (landed) {
+                std::cout << responder.name << " successfully landed the " << trickName << "!" << std::endl;
+            } else {
+                std::cout << responder.name << " failed to land the " << trickName << "!" << std::endl;
+                state = addLetters(state, p, house.award[difficulty], static_cast<int>(house.word.size()));
+            }
+        }
+        updateLetters();
+    }
+
+    void displayStatus() {
+        std::cout << "\n--- Current Session Status ---" << std::endl;
+        for (size_t i = 0; i < players.size(); i++) {
+            players[i].displayStatus();
+        }
+        std::cout << "------------------------------\n" << std::endl;
+    }
+
+    void playGame() {
+        std::cout << "\nWelcome to a " << players.size() << "-skater game of " << house.word << "!" << std::endl;
+        std::cout << "The setter keeps setting until they miss, then the next skater takes over." << std::endl;
+        std::cout << "Everyone else must match a landed trick. Spell '" << house.word << "' and you are out;"
+                  << " the last skater standing wins!\n" << std::endl;
+
+        while (!state.isOver()) {
+            displayStatus();
+            playRound();
+        }
+        displayStatus();
+        std::cout << "\n==========================" << std::endl;
+        std::cout << players[state.winner()].name << " WINS THE GAME!" << std::endl;
+        std::cout << "==========================" << std::endl;
+        for (size_t i = 0; leaderboard && i < players.size(); i++) {
+            if (static_cast<int>(i) != state.winner()) {
+                leaderboard->report(players[state.winner()].name, players[i].name);
+            }
+        }
+    }
+};
+
+void printUsage() {
+    std::cout << "Usage: skate [--skill model.txt] [--log attempts.log] [--rules skate|horse|pig[:retry]]" << std::endl;
+    std::cout << "             [--house rules.txt] [--ratings ratings.txt] [--replays replays.txt]" << std::endl;
+    std::cout << "             [--trace trace.json]" << std::endl;
+    std::cout << "       skate --fit attempts.log model.txt" << std::endl;
+    std::cout << "       skate --verify replays.txt" << std::endl;
+    std::cout << "       skate --show replays.txt GAME ROUND" << std::endl;
+}
+
+// Every replay of a file, in order
+bool loadReplays(const char* path, std::vector<Replay>& replays) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "Could not open " << path << std::endl;
+        return false;
+    }
+    Replay replay;
+    while (loadReplay(in, replay)) {
+        replays.push_back(replay);
+    }
+    if (!in.eof()) {
+        std::cout << "Replay " << replays.size() + 1 << " of " << path << " is damaged" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Play every replay of a file again and report the ones that do not add up
+int verifyReplayFile(const char* path) {
+    std::vector<Replay> replays;
+    if (!loadReplays(path, replays)) {
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ReplayVerdict> verdicts = verifyReplays(replays);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t bad = 0;
+    for (size_t i = 0; i < verdicts.size(); i++) {
+        if (!verdicts[i].ok) {
+            bad++;
+            std::cout << "Game " << i + 1 << " (" << replays[i].names[0] << " vs " << replays[i].names[1] << "): "
+                      << verdicts[i].problem;
+            if (verdicts[i].round >= 0) {
+                std::cout << " in round " << verdicts[i].round + 1;
+            }
+            std::cout << std::endl;
+        }
+    }
+    std::cout << replays.size() - bad << " of " << replays.size() << " games verified in " << seconds * 1000.0
+              << " ms" << std::endl;
+    return bad == 0 ? 0 : 1;
+}
+
+// Show where game `game` of a file stood at the start of round `round` (both from 1)
+int showReplay(const char* path, int game, int round) {
+    std::vector<Replay> replays;
+    if (!loadReplays(path, replays)) {
+        return 1;
+    }
+    if (game < 1 || game > static_cast<int>(replays.size()) || round < 1) {
+        std::cout << path << " has " << replays.size() << " games" << std::endl;
+        return 1;
+    }
+    const Replay& replay = replays[game - 1];
+    CompiledRules table = compileHouseRules(replay.rules);
+    ReplayState state = seekReplay(replay, table, static_cast<uint32_t>(round - 1));
+    const BotState& at = table.positions[state.position];
+    std::cout << replay.names[0] << " vs " << replay.names[1] << ", ";
+    if (state.round < replay.rounds.size()) {
+        std::cout << "round " << state.round + 1 << " of " << replay.rounds.size() << std::endl;
+    } else {
+        std::cout << "after all " << replay.rounds.size() << " rounds" << std::endl;
+    }
+    for (int p = 0; p < 2; p++) {
+        std::cout << "  " << replay.names[p] << ": "
+                  << (at.letters[p] > 0 ? table.word.substr(0, at.letters[p]) : std::string("No letters"))
+                  << (at.setter == p ? " (setting)" : "") << std::endl;
+    }
+    if (state.round < replay.rounds.size()) {
+        const ReplayRound& next = replay.rounds[state.round];
+        std::cout << "  " << replay.names[at.setter] << " sets a " << kDefaultCatalog.name(next.trick) << ":";
+        for (int a = 0; a < next.rolls; a++) {
+            std::cout << ' ' << replayRoll(replay.seed, state.attempt + a) << ((next.landed >> a) & 1 ? " landed" : " missed");
+            std::cout << (a + 1 < next.rolls ? "," : "");
+        }
+        std::cout << std::endl;
+    } else if (replay.winner >= 0) {
+        std::cout << "  " << replay.names[replay.winner] << " won" << std::endl;
+    }
+    return 0;
+}
+
+// Fit a skill model from an attempt log and save it
+int fitSkillModel(const char* logPath, const char* modelPath) {
+    std::ifstream log(logPath);
+    if (!log) {
+        std::cout << "Could not open " << logPath << std::endl;
+        return 1;
+    }
+    
+    // The difficulty formula of the default tricks is the starting point of every estimate
+    Game defaults("", "");
+    SkillFitter fitter(defaults.trickDifficulties());
+    size_t attempts = fitter.readLog(log, static_cast<int>(std::thread::hardware_concurrency()));
+    SkillModel model = fitter.fit();
+    
+    std::ofstream out(modelPath);
+    model.save(out);
+    if (!out) {
+        std::cout << "Could not write " << modelPath << std::endl;
+        return 1;
+    }
+    std::cout << "Fitted " << model.playerCount() << " players from " << attempts
+              << " attempts into " << modelPath << std::endl;
+    return 0;
+}
+
+// Write what was traced, for chrome://tracing or ui.perfetto.dev
+void saveTrace(const std::string& path) {
+    if (path.empty()) {
+        return;
+    }
+    std::ofstream out(path);
+    writeChromeTrace(out);
+    if (!out) {
+        std::cout << "Could not write trace " << path << std::endl;
+    }
+}
+
+// After a game: wait for the new ratings, show them and save them
+void updateRatings(Leaderboard& leaderboard, const std::vector<std::string>& names, const std::string& path) {
+    leaderboard.flush();
+    std::cout << "\nRatings:" << std::endl;
+    for (const std::string& name : names) {
+        std::cout << "  " << name << ": " << leaderboard.rating(name) << " (rank " << leaderboard.rank(name)
+                  << " of " << leaderboard.playerCount() << ")" << std::endl;
+    }
+    std::ofstream out(path);
+    leaderboard.save(out);
+    if (!out) {
+        std::cout << "Could not write ratings " << path << std::endl;
+    }
+}
+
+#ifndef SKATE_NO_MAIN // skate_bench.cpp includes this file for Game
+int main(int argc, char *argv[]) {
+    SKATE_TRACE_THREAD("game");
+    SkillModel skillModel;
+    bool haveSkillModel = false;
+    std::ofstream attemptLog;
+    RuleSet rules;
+    HouseRules houseRules;
+    bool haveHouseRules = false;
+    Leaderboard leaderboard;
+    std::string ratingsPath;
+    std::ofstream replayLog;
+    std::string tracePath;
+    
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--fit") == 0 && i + 2 < argc) {
+            return fitSkillModel(argv[i + 1], argv[i + 2]);
+        } else if (std::strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+            return verifyReplayFile(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--show") == 0 && i + 3 < argc) {
+            return showReplay(argv[i + 1], std::atoi(argv[i + 2]), std::atoi(argv[i + 3]));
+        } else if (std::strcmp(argv[i], "--replays") == 0 && i + 1 < argc) {
+            replayLog.open(argv[++i], std::ios::app);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+            if (!kTraceEnabled) {
+                std::cout << "This skate was built without tracing (-DSKATE_TRACE); the trace will be empty" << std::endl;
+            }
+        } else if (std::strcmp(argv[i], "--skill") == 0 && i + 1 < argc) {
+            std::ifstream in(argv[++i]);
+            if (!skillModel.load(in)) {
+                std::cout << "Could not read skill model " << argv[i] << std::endl;
+                return 1;
+            }
+            haveSkillModel = true;
+        } else if (std::strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            attemptLog.open(argv[++i], std::ios::app);
+        } else if (std::strcmp(argv[i], "--house") == 0 && i + 1 < argc) {
+            std::ifstream in(argv[++i]);
+            std::string error;
+            if (!in || !loadHouseRules(in, houseRules, error)) {
+                std::cout << "Could not read house rules " << argv[i] << (error.empty() ? "" : ": ") << error << std::endl;
+                return 1;
+            }
+            haveHouseRules = true;
+        } else if (std::strcmp(argv[i], "--ratings") == 0 && i + 1 < argc) {
+            ratingsPath = argv[++i];
+            // No file yet means nobody has played
+            std::ifstream in(ratingsPath);
+            if (in && !leaderboard.load(in)) {
+                std::cout << "Could not read ratings " << ratingsPath << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            if (!parseRuleSet(argv[++i], rules)) {
+                std::cout << "Unknown rules " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    
     std::string name1, name2;
     
     std::cout << "Enter name for Player 1: ";
     std::getline(std::cin, name1);
     
-    std::cout << "Enter name for Player 2: ";
+    std::cout << "Enter name for Player 2 (leave blank to play against the computer): ";
     std::getline(std::cin, name2);
     
-    Game skateGame(name1, name2);
-    skateGame.playGame();
+    // More names make it a jam session
+    std::vector<std::string> names;
+    names.push_back(name1);
+    names.push_back(name2);
+    while (!name2.empty() && names.size() < static_cast<size_t>(kMaxSessionPlayers)) {
+        std::string more;
+        std::cout << "Enter name for Player " << names.size() + 1 << " (leave blank to start): ";
+        if (!std::getline(std::cin, more) || more.empty()) {
+            break;
+        }
+        names.push_back(more);
+    }
+    if (names.size() > 2) {
+        Session session(names, rules);
+        if (haveHouseRules) {
+            session.useHouseRules(houseRules);
+            if (!session.hasSettableTricks()) {
+                std::cout << "The house rules leave no trick to set" << std::endl;
+                return 1;
+            }
+        }
+        if (haveSkillModel) {
+            session.useSkillModel(&skillModel);
+        }
+        if (attemptLog.is_open()) {
+            session.logAttempts(&attemptLog);
+        }
+        if (!ratingsPath.empty()) {
+            session.reportResults(&leaderboard);
+        }
+        while (true) {
+            session.playGame();
+            if (!ratingsPath.empty()) {
+                updateRatings(leaderboard, names, ratingsPath);
+            }
+            
+            std::string answer;
+            std::cout << "\nPlay again? (y/n): ";
+            if (!std::getline(std::cin, answer) || answer.empty() || (answer[0] != 'y' && answer[0] != 'Y')) {
+                break;
+            }
+            session.reset(names);
+        }
+        saveTrace(tracePath);
+        return 0;
+    }
+    
+    bool vsComputer = name2.empty();
+    if (vsComputer) {
+        name2 = "Computer";
+    }
+    
+    Game skateGame(name1, name2, vsComputer, rules);
+    if (haveHouseRules) {
+        skateGame.useHouseRules(houseRules);
+        if (!skateGame.hasSettableTricks()) {
+            std::cout << "The house rules leave no trick to set" << std::endl;
+            return 1;
+        }
+    }
+    if (haveSkillModel) {
+        skateGame.useSkillModel(&skillModel);
+    }
+    if (attemptLog.is_open()) {
+        skateGame.logAttempts(&attemptLog);
+    }
+    if (replayLog.is_open()) {
+        skateGame.saveReplays(&replayLog);
+    }
+    if (!ratingsPath.empty()) {
+        skateGame.reportResults(&leaderboard);
+        names[1] = name2;
+    }
+    while (true) {
+        skateGame.playGame();
+        if (!ratingsPath.empty()) {
+            updateRatings(leaderboard, names, ratingsPath);
+        }
+        
+        std::string answer;
+        std::cout << "\nPlay again? (y/n): ";
+        if (!std::getline(std::cin, answer) || answer.empty() || (answer[0] != 'y' && answer[0] != 'Y')) {
+            break;
+        }
+        skateGame.reset(name1, name2);
+    }
+    saveTrace(tracePath);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif
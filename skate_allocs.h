@@ -0,0 +1,77 @@
+// Game of Skate - allocation counting
+// Replaces the global operator new and delete, every form of them, with ones that count the
+// allocations each thread makes and otherwise just call malloc and free. The benchmarks read
+// threadAllocations before and after the code they measure.
+//
+// Include it from exactly one source file of a program, and only of a benchmark: the game
+// itself keeps the standard allocator.
+//
+// The replacements are kept out of line. Inlined, GCC follows a pointer from malloc in operator
+// new to free in operator delete and warns under -Wall (-Wmismatched-new-delete).
+//
+// C++11. skate_bench.cpp and the GUI's benchmark build (SKATE_GUI_BENCH) include it.
+
+#ifndef SKATE_ALLOCS_H
+#define SKATE_ALLOCS_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GNUC__)
+#define SKATE_ALLOC_OUT_OF_LINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define SKATE_ALLOC_OUT_OF_LINE __declspec(noinline)
+#else
+#define SKATE_ALLOC_OUT_OF_LINE
+#endif
+
+// Allocations made by the calling thread
+static thread_local long threadAllocations = 0;
+
+SKATE_ALLOC_OUT_OF_LINE void* operator new(std::size_t size) {
+    threadAllocations++;
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+SKATE_ALLOC_OUT_OF_LINE void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    threadAllocations++;
+    return std::malloc(size ? size : 1);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void* operator new[](std::size_t size, const std::nothrow_t& nothrow) noexcept {
+    return ::operator new(size, nothrow);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void operator delete[](void* block) noexcept {
+    std::free(block);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void operator delete[](void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void operator delete(void* block, const std::nothrow_t&) noexcept {
+    std::free(block);
+}
+
+SKATE_ALLOC_OUT_OF_LINE void operator delete[](void* block, const std::nothrow_t&) noexcept {
+    std::free(block);
+}
+
+#endif // SKATE_ALLOCS_H
@@ -0,0 +1,269 @@
+// Game of Skate - session arenas
+// Memory for hosted matches (see skate_turns.h) that comes and goes with the match, without
+// going through malloc for every small object.
+//
+// A SlabPool hands out fixed-size slabs and takes them back for the next user; it only asks the
+// system for a slab when all of its own are in use, so once a server has warmed up, matches
+// starting and ending neither call malloc nor leave holes in the heap.
+//
+// A SessionArena is one match's memory. Blocks are rounded up to a size class (16 bytes up to
+// kArenaLargest) and bumped off the arena's current slab; a block given back goes on its class's
+// free list for the next block of that size. reset() frees everything at once by handing the
+// slabs back to the pool. Blocks larger than kArenaLargest come from the system.
+//
+// Neither is thread safe: each scheduler (one thread) owns its pool and its matches' arenas.
+
+#ifndef SKATE_ARENA_H
+#define SKATE_ARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Size of a slab, and the largest block an arena cuts from one
+const size_t kSlabBytes = 4096;
+const size_t kArenaLargest = 2048;
+// Size classes 16, 32, ..., kArenaLargest
+const int kArenaClasses = 8;
+// Every block is aligned to this
+const size_t kArenaAlign = 16;
+
+class SlabPool {
+public:
+    SlabPool() : idleSlabs(nullptr), allocatedSlabs(0), idleCount(0) {}
+
+    ~SlabPool() {
+        while (idleSlabs) {
+            Link* slab = idleSlabs;
+            idleSlabs = slab->next;
+            std::free(slab);
+        }
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    void* take() {
+        if (idleSlabs) {
+            Link* slab = idleSlabs;
+            idleSlabs = slab->next;
+            idleCount--;
+            return slab;
+        }
+        void* slab = std::malloc(kSlabBytes);
+        if (!slab) {
+            throw std::bad_alloc();
+        }
+        allocatedSlabs++;
+        return slab;
+    }
+
+    void give(void* slab) {
+        Link* link = static_cast<Link*>(slab);
+        link->next = idleSlabs;
+        idleSlabs = link;
+        idleCount++;
+    }
+
+    // Slabs taken from the system so far
+    size_t allocated() const {
+        return allocatedSlabs;
+    }
+
+    // Slabs waiting for an arena
+    size_t idle() const {
+        return idleCount;
+    }
+
+private:
+    struct Link {
+        Link* next;
+    };
+
+    Link* idleSlabs;
+    size_t allocatedSlabs;
+    size_t idleCount;
+};
+
+struct ArenaStats {
+    long allocations; // blocks handed out
+    long reused;      // of them, blocks given back earlier
+    long large;       // of them, too big for a slab
+    long resets;      // times everything was freed at once
+    long slabs;       // slabs held right now
+
+    void add(const ArenaStats& other) {
+        allocations += other.allocations;
+        reused += other.reused;
+        large += other.large;
+        resets += other.resets;
+        slabs += other.slabs;
+    }
+};
+
+class SessionArena {
+public:
+    explicit SessionArena(SlabPool& slabPool)
+        : pool(&slabPool), slabs(nullptr), large(nullptr), next(nullptr), end(nullptr) {
+        stats = ArenaStats{0, 0, 0, 0, 0};
+        for (int c = 0; c < kArenaClasses; c++) {
+            freeBlocks[c] = nullptr;
+        }
+    }
+
+    ~SessionArena() {
+        reset();
+    }
+
+    SessionArena(const SessionArena&) = delete;
+    SessionArena& operator=(const SessionArena&) = delete;
+
+    void* allocate(size_t bytes) {
+        stats.allocations++;
+        if (bytes > kArenaLargest) {
+            stats.large++;
+            Large* block = static_cast<Large*>(std::malloc(sizeof(Large) + bytes));
+            if (!block) {
+                throw std::bad_alloc();
+            }
+            block->previous = nullptr;
+            block->next = large;
+            if (large) {
+                large->previous = block;
+            }
+            large = block;
+            return block + 1;
+        }
+        int c = sizeClass(bytes);
+        if (freeBlocks[c]) {
+            stats.reused++;
+            Free* block = freeBlocks[c];
+            freeBlocks[c] = block->next;
+            return block;
+        }
+        size_t size = kArenaAlign << c;
+        if (static_cast<size_t>(end - next) < size) {
+            newSlab();
+        }
+        void* block = next;
+        next += size;
+        return block;
+    }
+
+    // `bytes` must be the size the block was allocated with
+    void deallocate(void* block, size_t bytes) {
+        if (bytes > kArenaLargest) {
+            Large* header = static_cast<Large*>(block) - 1;
+            if (header->previous) {
+                header->previous->next = header->next;
+            } else {
+                large = header->next;
+            }
+            if (header->next) {
+                header->next->previous = header->previous;
+            }
+            std::free(header);
+            return;
+        }
+        int c = sizeClass(bytes);
+        Free* freed = static_cast<Free*>(block);
+        freed->next = freeBlocks[c];
+        freeBlocks[c] = freed;
+    }
+
+    // Frees every block: the slabs go back to the pool, large blocks to the system
+    void reset() {
+        while (slabs) {
+            Slab* slab = slabs;
+            slabs = slab->next;
+            pool->give(slab);
+        }
+        while (large) {
+            Large* block = large;
+            large = block->next;
+            std::free(block);
+        }
+        for (int c = 0; c < kArenaClasses; c++) {
+            freeBlocks[c] = nullptr;
+        }
+        next = end = nullptr;
+        stats.slabs = 0;
+        stats.resets++;
+    }
+
+    const ArenaStats& statistics() const {
+        return stats;
+    }
+
+private:
+    // Headers keep the blocks after them aligned
+    struct alignas(kArenaAlign) Slab {
+        Slab* next;
+    };
+    struct alignas(kArenaAlign) Large {
+        Large* previous;
+        Large* next;
+    };
+    struct Free {
+        Free* next;
+    };
+
+    static int sizeClass(size_t bytes) {
+        int c = 0;
+        while ((kArenaAlign << c) < bytes) {
+            c++;
+        }
+        return c;
+    }
+
+    void newSlab() {
+        Slab* slab = static_cast<Slab*>(pool->take());
+        slab->next = slabs;
+        slabs = slab;
+        next = reinterpret_cast<char*>(slab + 1);
+        end = reinterpret_cast<char*>(slab) + kSlabBytes;
+        stats.slabs++;
+    }
+
+    SlabPool* pool;
+    Slab* slabs;
+    Large* large;
+    char* next; // free space left in the newest slab
+    char* end;
+    Free* freeBlocks[kArenaClasses];
+    ArenaStats stats;
+};
+
+// Standard allocator over an arena, for containers and std::allocate_shared
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(SessionArena* owner) : arena(owner) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, size_t n) {
+        arena->deallocate(block, n * sizeof(T));
+    }
+
+    SessionArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+#endif // SKATE_ARENA_H
@@ -0,0 +1,249 @@
+// Game of Skate - benchmarks
+// Measures how well (and how fast) the computer opponent plays against the greedy baseline,
+// how fast skill models are refitted from logged attempts, what a trace event costs and what
+// the console game allocates to start a new match.
+//
+// Usage: skate_bench [games] [budget ms per trick] [max threads] [refit attempts in millions]
+
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <sstream>
+#include <atomic>
+
+#include "skate_core.h"
+#include "skate_bot.h"
+#include "skate_skill.h"
+#include "skate_trace.h"
+
+// The console game's Game class, without its main()
+#define SKATE_NO_MAIN
+#include "skate.cpp"
+
+// Counts what the code under test allocates
+#include "skate_allocs.h"
+
+std::vector<int> formulaChances() {
+    std::vector<int> chances;
+    for (int difficulty : kDefaultTrickDifficulties) {
+        chances.push_back(successChance(difficulty));
+    }
+    return chances;
+}
+
+// A player who is better or worse than the formula on each trick
+std::vector<int> specialistChances(std::mt19937& rng) {
+    std::uniform_int_distribution<int> skew(-25, 25);
+    std::vector<int> chances = formulaChances();
+    for (int& chance : chances) {
+        chance = std::min(99, std::max(1, chance + skew(rng)));
+    }
+    return chances;
+}
+
+// Play one full game; mctsPlayer is the index searched by the bot, the other plays greedy
+int playMatch(MctsBot& bot, const std::vector<std::vector<int>>& chances, int mctsPlayer,
+              int firstSetter, std::chrono::milliseconds budget, std::mt19937& rng) {
+    std::uniform_int_distribution<int> dist(1, 100);
+    BotState state = {{0, 0}, firstSetter};
+    while (!state.isOver()) {
+        int trick = state.setter == mctsPlayer ? bot.chooseTrick(state, budget)
+                                               : greedyTrick(chances, state);
+        int outcome = BOTH_LANDED;
+        if (dist(rng) > chances[state.setter][trick]) {
+            outcome = SETTER_MISSED;
+        } else if (dist(rng) > chances[1 - state.setter][trick]) {
+            outcome = RESPONDER_MISSED;
+        }
+        state = applyOutcome(state, outcome);
+    }
+    return state.winner();
+}
+
+void benchMatchups(const std::string& label, const std::vector<std::vector<int>>& chances,
+                   int games, std::chrono::milliseconds budget, int threads) {
+    MctsBot bot(chances, threads);
+    std::mt19937 rng(2024);
+    int wins = 0;
+    long playouts = 0;
+    double searchMs = 0.0;
+    for (int g = 0; g < games; g++) {
+        // Swap seats and first setter so neither side gets a structural edge
+        int mctsPlayer = g % 2;
+        int firstSetter = (g / 2) % 2;
+        if (playMatch(bot, chances, mctsPlayer, firstSetter, budget, rng) == mctsPlayer) {
+            wins++;
+        }
+        playouts += bot.lastStats().iterations;
+        searchMs += bot.lastStats().elapsedMs;
+    }
+    std::cout << std::left << std::setw(14) << label
+              << " MCTS win rate vs greedy: " << std::fixed << std::setprecision(1)
+              << (100.0 * wins / games) << "% over " << games << " games ("
+              << std::setprecision(0) << (searchMs > 0 ? playouts / searchMs : 0.0)
+              << " playouts/ms)" << std::endl;
+}
+
+void benchScaling(const std::vector<std::vector<int>>& chances, std::chrono::milliseconds budget,
+                  int maxThreads) {
+    BotState state = {{0, 0}, 0};
+    double baseline = 0.0;
+    std::cout << "\nThread scaling (" << budget.count() << " ms search from the opening):" << std::endl;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        MctsBot bot(chances, threads, 1 << 17);
+        bot.chooseTrick(state, budget);
+        double rate = bot.lastStats().iterations / bot.lastStats().elapsedMs;
+        if (threads == 1) {
+            baseline = rate;
+        }
+        std::cout << std::right << std::setw(4) << threads << " threads: " << std::setw(8) << std::setprecision(0)
+                  << rate << " playouts/ms  speedup " << std::setprecision(2) << rate / baseline
+                  << "x" << std::endl;
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchSkillRefit(long attempts, int threads) {
+    const int kPlayers = 100000;
+    std::vector<int> difficulties(kDefaultTrickDifficulties, kDefaultTrickDifficulties + kDefaultTrickCount);
+    std::mt19937 rng(99);
+
+    std::cout << "\nSkill model refit (" << kPlayers << " players):" << std::endl;
+
+    // Counting pass over attempts already in memory
+    SkillFitter fitter(difficulties);
+    for (int p = 0; p < kPlayers; p++) {
+        fitter.addPlayer("player" + std::to_string(p));
+    }
+    std::vector<AttemptRecord> records(attempts);
+    for (auto& record : records) {
+        uint32_t bits = rng();
+        record.player = bits % kPlayers;
+        record.trick = static_cast<uint16_t>((bits >> 17) % kDefaultTrickCount);
+        record.landed = (bits >> 31) & 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    fitter.addBatch(records.data(), records.size(), threads);
+    SkillModel model = fitter.fit();
+    double seconds = secondsSince(start);
+    std::cout << "  " << attempts << " attempts counted and fitted in " << std::setprecision(3)
+              << seconds << " s (" << std::setprecision(1) << attempts / seconds / 1e6
+              << " M attempts/s, 100M would take " << std::setprecision(2)
+              << 1e8 * seconds / attempts << " s)" << std::endl;
+
+    // Parsing the text log format, worst case: every line names a random player
+    std::ostringstream text;
+    const int kLogLines = 1000000;
+    for (int i = 0; i < kLogLines; i++) {
+        const AttemptRecord& record = records[i % records.size()];
+        text << "player" << record.player << '\t' << record.trick << '\t' << record.landed << '\n';
+    }
+    std::istringstream log(text.str());
+    SkillFitter logFitter(difficulties);
+    start = std::chrono::steady_clock::now();
+    logFitter.readLog(log, threads);
+    seconds = secondsSince(start);
+    std::cout << "  " << kLogLines << " log lines parsed in " << std::setprecision(3) << seconds
+              << " s (" << std::setprecision(1) << kLogLines / seconds / 1e6 << " M lines/s)" << std::endl;
+}
+
+// Cost of one traced scope (what SKATE_TRACE_SCOPE costs in a -DSKATE_TRACE build), and how much
+// of it is the two clock reads
+void benchTracing() {
+    const long kEvents = 10000000;
+    std::cout << "\nTracing:" << std::endl;
+    {
+        TraceScope warmup("warmup"); // the first event of a thread makes its ring
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < kEvents; i++) {
+        TraceScope scope("bench");
+    }
+    double seconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < kEvents; i++) {
+        traceClock();
+    }
+    double clock = secondsSince(start);
+    std::cout << std::fixed << std::setprecision(1) << "  " << seconds * 1e9 / kEvents << " ns per event, "
+              << 2e9 * clock / kEvents << " ns of it reading the clock" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+// Allocations of Game::reset, the path the console game takes for "Play again?": with the same
+// players nothing should be allocated; a new opponent makes the computer learn new chances.
+void benchGameReset() {
+    const int kResets = 1000;
+    std::vector<int> difficulties(kDefaultTrickDifficulties, kDefaultTrickDifficulties + kDefaultTrickCount);
+    SkillFitter fitter(difficulties);
+    const char* names[] = {"Jon", "Ana", "Computer"};
+    for (const char* name : names) {
+        int row = fitter.addPlayer(name);
+        for (int trick = 0; trick < kDefaultTrickCount; trick++) {
+            fitter.add(row, trick, trick % 3 != row);
+        }
+    }
+    SkillModel model = fitter.fit();
+
+    Game game("Jon", "Computer", true);
+    game.useSkillModel(&model);
+    std::string jon = "Jon", ana = "Ana", computer = "Computer";
+    game.reset(jon, computer);
+
+    std::cout << "\nGame reset (" << kResets << " matches):" << std::endl;
+    long before = threadAllocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kResets; i++) {
+        game.reset(jon, computer);
+    }
+    double seconds = secondsSince(start);
+    std::cout << "  same players: " << threadAllocations - before << " allocations, " << std::setprecision(2)
+              << seconds * 1e9 / kResets << " ns per reset" << std::endl;
+
+    before = threadAllocations;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kResets; i++) {
+        game.reset(i % 2 ? jon : ana, computer);
+    }
+    seconds = secondsSince(start);
+    std::cout << "  new opponent every match: " << std::setprecision(3)
+              << static_cast<double>(threadAllocations - before) / kResets << " allocations, "
+              << seconds * 1e6 / kResets << " us per reset (the computer is rebuilt)" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    int games = argc > 1 ? std::atoi(argv[1]) : 40;
+    std::chrono::milliseconds budget(argc > 2 ? std::atoi(argv[2]) : 10);
+    int maxThreads = argc > 3 ? std::atoi(argv[3])
+                              : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::cout << "SKATE bot benchmark: " << budget.count() << " ms per trick, up to "
+              << maxThreads << " threads\n" << std::endl;
+
+    std::vector<std::vector<int>> equal(2, formulaChances());
+    benchMatchups("Formula", equal, games, budget, maxThreads);
+
+    std::mt19937 profileRng(7);
+    std::vector<std::vector<int>> specialists = {specialistChances(profileRng),
+                                                 specialistChances(profileRng)};
+    benchMatchups("Specialists", specialists, games, budget, maxThreads);
+
+    benchScaling(equal, std::chrono::milliseconds(200), std::max(16, maxThreads));
+
+    long refitAttempts = (argc > 4 ? std::atol(argv[4]) : 20) * 1000000L;
+    benchSkillRefit(refitAttempts, maxThreads);
+
+    benchTracing();
+    benchGameReset();
+    return 0;
+}
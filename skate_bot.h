@@ -0,0 +1,374 @@
+// Game of Skate - computer opponent
+// Picks the setter's trick with a parallel Monte Carlo Tree Search over attemptTrick outcomes.
+// All worker threads grow one shared tree. A thread walking down an edge charges it a
+// virtual loss until its result is backed up, so the other threads spread out over
+// different tricks instead of all following the same line.
+//
+// The search plays the game by its CompiledRules (see skate_house.h): the word's length, the
+// responder's tries on their last letter, the setter's penalty, the letters each trick hands
+// out and which tricks may be set all come from the table, so it looks ahead in the game
+// actually being played. Without rules it plays SKATE.
+
+#ifndef SKATE_BOT_H
+#define SKATE_BOT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "skate_core.h"
+#include "skate_house.h"
+
+// The three ways a round can end (same rules as Game::playRound)
+enum RoundOutcome {
+    SETTER_MISSED = 0,    // roles switch
+    RESPONDER_MISSED = 1, // responder gets a letter, setter keeps setting
+    BOTH_LANDED = 2       // nothing changes, setter keeps setting
+};
+
+inline BotState applyOutcome(BotState state, int outcome) {
+    if (outcome == SETTER_MISSED) {
+        state.setter = 1 - state.setter;
+    } else if (outcome == RESPONDER_MISSED) {
+        state.letters[1 - state.setter]++;
+    }
+    return state;
+}
+
+// Greedy baseline: pick the trick most likely to give the responder a letter this round
+inline int greedyTrick(const std::vector<std::vector<int>>& chances, const BotState& state) {
+    const std::vector<int>& setterChances = chances[state.setter];
+    const std::vector<int>& responderChances = chances[1 - state.setter];
+    int best = 0;
+    int bestScore = -1;
+    for (size_t i = 0; i < setterChances.size(); i++) {
+        // P(setter lands) * P(responder misses), in units of 1/10000
+        int score = setterChances[i] * (100 - responderChances[i]);
+        if (score > bestScore) {
+            bestScore = score;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+class MctsBot {
+public:
+    struct SearchStats {
+        long iterations;
+        int nodesUsed;
+        double elapsedMs;
+    };
+
+    // chances[player][trick] is the success chance in percent of each player on each trick.
+    // threads = 0 uses every hardware thread. poolNodes bounds the memory used by the tree.
+    MctsBot(const std::vector<std::vector<int>>& chances, int threads = 0, int poolNodes = 1 << 15)
+        : MctsBot(chances, skateRules(static_cast<int>(chances[0].size())), threads, poolNodes) {}
+
+    // Searches the game played by `rules`; tricks they do not allow are never chosen
+    MctsBot(const std::vector<std::vector<int>>& chances, const CompiledRules& rules, int threads = 0,
+            int poolNodes = 1 << 15)
+        : chances(chances),
+          rules(rules),
+          numTricks(static_cast<int>(chances[0].size())),
+          numThreads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          capacity(poolNodes),
+          nextNode(0),
+          seed(static_cast<unsigned int>(std::random_device{}())) {
+        for (int i = 0; i < numTricks; i++) {
+            int slot = rules.settable(i);
+            if (slot >= 0) {
+                choices.push_back(i);
+                missEvents.push_back(rules.missEvent[slot]);
+            }
+        }
+        numChoices = static_cast<int>(choices.size());
+        nodes.reset(new Node[poolNodes]);
+        edges.reset(new Edge[static_cast<size_t>(poolNodes) * std::max(1, numChoices)]);
+        stats = SearchStats{0, 0, 0.0};
+    }
+
+    void setSeed(unsigned int s) {
+        seed = s;
+    }
+
+    void setThreads(int threads) {
+        numThreads = threads;
+    }
+
+    // Anytime search: runs until the time budget is spent (or maxIterations playouts have
+    // been done, if non-zero) and returns the most visited trick at the root.
+    int chooseTrick(const BotState& state, std::chrono::milliseconds budget, long maxIterations = 0) {
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + budget;
+        if (numChoices == 0) {
+            stats = SearchStats{0, 0, 0.0};
+            return 0;
+        }
+
+        // Recycle the whole node pool for the new search
+        nextNode.store(1, std::memory_order_relaxed);
+        initNode(0, rules.position(state));
+        iterations.store(0, std::memory_order_relaxed);
+        claimed.store(0, std::memory_order_relaxed);
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < numThreads; t++) {
+            workers.emplace_back(&MctsBot::searchWorker, this, seed + t, deadline, maxIterations);
+        }
+        searchWorker(seed, deadline, maxIterations);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        seed += numThreads;
+
+        stats.iterations = iterations.load(std::memory_order_relaxed);
+        stats.nodesUsed = std::min(nextNode.load(std::memory_order_relaxed), capacity);
+        stats.elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        int best = 0;
+        for (int i = 1; i < numChoices; i++) {
+            const Edge& candidate = edges[i];
+            const Edge& current = edges[best];
+            int cv = candidate.visits.load(std::memory_order_relaxed);
+            int bv = current.visits.load(std::memory_order_relaxed);
+            if (cv > bv || (cv == bv && candidate.score.load(std::memory_order_relaxed) >
+                                        current.score.load(std::memory_order_relaxed))) {
+                best = i;
+            }
+        }
+        return choices[best];
+    }
+
+    // Visit counts of each trick at the root of the last search (0 for tricks not allowed)
+    std::vector<int> rootVisits() const {
+        std::vector<int> visits(numTricks);
+        for (int i = 0; i < numChoices; i++) {
+            visits[choices[i]] = edges[i].visits.load(std::memory_order_relaxed);
+        }
+        return visits;
+    }
+
+    const SearchStats& lastStats() const {
+        return stats;
+    }
+
+    // SKATE, with every one of `tricks` tricks allowed and handing out one letter
+    static CompiledRules skateRules(int tricks) {
+        CompiledRules skate = compileHouseRules(HouseRules());
+        skate.tricks.clear();
+        skate.slot.clear();
+        skate.missEvent.clear();
+        for (int i = 0; i < tricks; i++) {
+            skate.slot.push_back(static_cast<int16_t>(i));
+            skate.tricks.push_back(i);
+            skate.missEvent.push_back(HOUSE_RESPONDER_MISSED);
+        }
+        return skate;
+    }
+
+private:
+    // Extra visits charged to an edge while a thread is still playing out below it
+    static const int kVirtualLoss = 3;
+    // Playouts longer than this are scored as a draw
+    static const int kMaxRolloutRounds = 2000;
+
+    struct Edge {
+        std::atomic<int> visits;
+        std::atomic<int> score;    // 2 per win, 1 per draw, for the node's setter
+        std::atomic<int> child[3]; // node index per RoundOutcome, -1 if not expanded
+    };
+
+    struct Node {
+        int position; // in rules
+        std::atomic<int> visits;
+    };
+
+    std::vector<std::vector<int>> chances;
+    CompiledRules rules;
+    std::vector<int> choices;        // the tricks the rules allow, as indices into chances
+    std::vector<uint8_t> missEvents; // rules event of a responder missing each of them
+    int numTricks;
+    int numChoices;
+    int numThreads;
+    int capacity;
+    std::unique_ptr<Node[]> nodes;
+    std::unique_ptr<Edge[]> edges;
+    std::atomic<int> nextNode;
+    std::atomic<long> iterations;
+    std::atomic<long> claimed;
+    unsigned int seed;
+    SearchStats stats;
+
+    Edge& edgeAt(int node, int choice) {
+        return edges[static_cast<size_t>(node) * numChoices + choice];
+    }
+
+    void initNode(int index, int position) {
+        nodes[index].position = position;
+        nodes[index].visits.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < numChoices; i++) {
+            Edge& edge = edgeAt(index, i);
+            edge.visits.store(0, std::memory_order_relaxed);
+            edge.score.store(0, std::memory_order_relaxed);
+            for (int k = 0; k < 3; k++) {
+                edge.child[k].store(-1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Take a node from the pool and publish it as the child; returns -1 if the pool is empty
+    int expand(Edge& edge, int outcome, int position) {
+        if (nextNode.load(std::memory_order_relaxed) >= capacity) {
+            return -1;
+        }
+        int index = nextNode.fetch_add(1, std::memory_order_relaxed);
+        if (index >= capacity) {
+            return -1;
+        }
+        initNode(index, position);
+        int expected = -1;
+        if (edge.child[outcome].compare_exchange_strong(expected, index, std::memory_order_acq_rel,
+                                                        std::memory_order_acquire)) {
+            return index;
+        }
+        // Another thread expanded the same child first; our node is left unused
+        return expected;
+    }
+
+    int selectChoice(int nodeIndex) {
+        Node& node = nodes[nodeIndex];
+        int parentVisits = node.visits.load(std::memory_order_relaxed);
+        double logParent = std::log(static_cast<double>(parentVisits + 1));
+        int best = 0;
+        double bestValue = -1.0;
+        for (int i = 0; i < numChoices; i++) {
+            Edge& edge = edgeAt(nodeIndex, i);
+            int visits = edge.visits.load(std::memory_order_relaxed);
+            if (visits == 0) {
+                return i;
+            }
+            double mean = edge.score.load(std::memory_order_relaxed) / (2.0 * visits);
+            double value = mean + 0.7 * std::sqrt(logParent / visits);
+            if (value > bestValue) {
+                bestValue = value;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // The responder gets as many tries as the rules give them in this position
+    int rollOutcome(int position, int choice, std::mt19937& rng) {
+        std::uniform_int_distribution<int> dist(1, 100);
+        int setter = rules.positions[position].setter;
+        int trick = choices[choice];
+        if (dist(rng) > chances[setter][trick]) {
+            return SETTER_MISSED;
+        }
+        for (int t = 0; t < rules.tries[position]; t++) {
+            if (dist(rng) <= chances[1 - setter][trick]) {
+                return BOTH_LANDED;
+            }
+        }
+        return RESPONDER_MISSED;
+    }
+
+    int nextPosition(int position, int choice, int outcome) const {
+        int event = missEvents[choice];
+        if (outcome == SETTER_MISSED) {
+            event = HOUSE_SETTER_MISSED;
+        } else if (outcome == BOTH_LANDED) {
+            event = HOUSE_BOTH_LANDED;
+        }
+        return rules.after(position, event);
+    }
+
+    // Random playout to the end of the game; returns the winner or -1 for a draw
+    int rollout(int position, std::mt19937& rng) {
+        std::uniform_int_distribution<int> pick(0, numChoices - 1);
+        for (int round = 0; round < kMaxRolloutRounds; round++) {
+            if (rules.winner[position] >= 0) {
+                return rules.winner[position];
+            }
+            int choice = pick(rng);
+            position = nextPosition(position, choice, rollOutcome(position, choice, rng));
+        }
+        return -1;
+    }
+
+    void runIteration(std::mt19937& rng, std::vector<std::pair<int, int>>& path) {
+        path.clear();
+        int nodeIndex = 0;
+        int winner;
+        while (true) {
+            int choice = selectChoice(nodeIndex);
+            Edge& edge = edgeAt(nodeIndex, choice);
+            edge.visits.fetch_add(kVirtualLoss, std::memory_order_relaxed);
+            nodes[nodeIndex].visits.fetch_add(kVirtualLoss, std::memory_order_relaxed);
+            path.push_back(std::make_pair(nodeIndex, choice));
+
+            int position = nodes[nodeIndex].position;
+            int outcome = rollOutcome(position, choice, rng);
+            int next = nextPosition(position, choice, outcome);
+            if (rules.winner[next] >= 0) {
+                winner = rules.winner[next];
+                break;
+            }
+            int child = edge.child[outcome].load(std::memory_order_acquire);
+            if (child < 0) {
+                // Grow the tree by one node (if the pool allows) and play out from there
+                expand(edge, outcome, next);
+                winner = rollout(next, rng);
+                break;
+            }
+            nodeIndex = child;
+        }
+
+        // Back up the result and take back the virtual loss
+        for (const auto& step : path) {
+            Node& node = nodes[step.first];
+            Edge& edge = edgeAt(step.first, step.second);
+            int setter = rules.positions[node.position].setter;
+            int score = winner < 0 ? 1 : (winner == setter ? 2 : 0);
+            edge.score.fetch_add(score, std::memory_order_relaxed);
+            edge.visits.fetch_sub(kVirtualLoss - 1, std::memory_order_relaxed);
+            node.visits.fetch_sub(kVirtualLoss - 1, std::memory_order_relaxed);
+        }
+    }
+
+    void searchWorker(unsigned int workerSeed, std::chrono::steady_clock::time_point deadline,
+                      long maxIterations) {
+        std::mt19937 rng(workerSeed);
+        std::vector<std::pair<int, int>> path;
+        long done = 0;
+        while (true) {
+            // Playouts are handed out (and the clock checked) in small batches
+            long batch = 32;
+            if (maxIterations > 0) {
+                long first = claimed.fetch_add(batch, std::memory_order_relaxed);
+                if (first >= maxIterations) {
+                    break;
+                }
+                batch = std::min(batch, maxIterations - first);
+            }
+            for (long i = 0; i < batch; i++) {
+                runIteration(rng, path);
+            }
+            done += batch;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+        }
+        iterations.fetch_add(done, std::memory_order_relaxed);
+    }
+};
+
+#endif // SKATE_BOT_H
@@ -0,0 +1,302 @@
+// Game of Skate - spectator broadcast
+// Sends the events of live matches (see skate_turns.h) to any number of spectators.
+//
+// Every event is written out once, as a short text line, into a reference-counted buffer
+// taken from the hub's own arena (see skate_arena.h), so publishing does not call malloc.
+// Each spectator of the match queues a reference to that buffer, not a copy, and flushing
+// a spectator hands all of its queued buffers to the kernel in one scatter-gather write.
+//
+// Queues are bounded. A spectator that falls a whole queue behind (a slow connection) has
+// its backlog thrown away and gets a snapshot of the match instead, so the game never waits
+// for a viewer and a viewer never has to replay what it missed.
+//
+// A match's id is reused once the scheduler releases it. Its TURN_MATCH_CLOSED event is the
+// last line its viewers get: the hub then forgets the match and its viewers, who still get
+// what is queued for them but nothing of the next match on that id.
+//
+// Lines on the wire:
+//   E <match> <event type> <player> <trick> <value>       one TurnEvent
+//   S <match> <letters 0> <letters 1> <setter> <winner>   where the match stands now
+
+#ifndef SKATE_BROADCAST_H
+#define SKATE_BROADCAST_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+#include "skate_arena.h"
+#include "skate_turns.h"
+
+// Longest line a broadcast buffer holds
+const int kBroadcastLine = 64;
+
+// Buffers handed to a single write; the rest wait for the next flush
+const int kBroadcastBatch = 64;
+
+// One serialized line, shared by every spectator it is queued for
+struct BroadcastBuffer {
+    int size;
+    char data[kBroadcastLine];
+};
+
+typedef std::shared_ptr<const BroadcastBuffer> SharedBuffer;
+
+struct BroadcastStats {
+    long published;   // events serialized
+    long queued;      // references queued to spectators
+    long resyncs;     // times a spectator fell behind and was sent a snapshot instead
+    long bytesWritten;
+};
+
+class SpectatorHub {
+public:
+    explicit SpectatorHub(size_t queueLength = 256) : lines(slabs), queueLength(std::max<size_t>(2, queueLength)) {
+        stats = BroadcastStats{0, 0, 0, 0};
+    }
+
+    // Starts sending `match` to a file descriptor (a socket or pipe, ideally non-blocking).
+    // The spectator first gets a snapshot of where the match stands. The id of a spectator
+    // who left is given to a later one.
+    int subscribe(int match, int fd) {
+        int id;
+        if (!leftIds.empty()) {
+            id = leftIds.back();
+            leftIds.pop_back();
+        } else {
+            id = static_cast<int>(spectators.size());
+            spectators.push_back(Spectator());
+        }
+        Spectator& spectator = spectators[id];
+        spectator.fd = fd;
+        spectator.match = match;
+        spectator.queue.resize(queueLength);
+        spectator.head = 0;
+        spectator.count = 0;
+        spectator.offset = 0;
+        viewFor(match).spectators.push_back(id);
+        push(spectators[id], snapshot(match));
+        return id;
+    }
+
+    // Stops sending to a spectator; its fd is left open for the caller to close
+    void unsubscribe(int id) {
+        Spectator& spectator = spectators[id];
+        if (spectator.fd < 0) {
+            return;
+        }
+        if (spectator.match >= 0) {
+            std::vector<int>& list = views[spectator.match].spectators;
+            list.erase(std::remove(list.begin(), list.end(), id), list.end());
+        }
+        spectator.fd = -1;
+        spectator.count = 0;
+        std::vector<SharedBuffer>().swap(spectator.queue); // thousands of viewers come and go
+        leftIds.push_back(id);
+    }
+
+    // Serializes the event once and queues it for every spectator of its match. Never blocks.
+    void publish(const TurnEvent& event) {
+        MatchView& view = viewFor(event.match);
+        if (event.type == TURN_LETTERS) {
+            view.letters[event.player] = event.value;
+        } else if (event.type == TURN_SETTER_CHANGED || event.type == TURN_CHOOSE_TRICK) {
+            // The opening setter is only ever named by their first TURN_CHOOSE_TRICK
+            view.setter = event.player;
+        } else if (event.type == TURN_GAME_OVER) {
+            view.winner = event.player;
+        }
+        stats.published++;
+        if (view.spectators.empty()) {
+            if (event.type == TURN_MATCH_CLOSED) {
+                close(event.match);
+            }
+            return;
+        }
+
+        std::shared_ptr<BroadcastBuffer> buffer = newBuffer();
+        buffer->size = std::snprintf(buffer->data, kBroadcastLine, "E %d %d %d %d %d\n", event.match,
+                                     static_cast<int>(event.type), event.player, event.trick, event.value);
+        SharedBuffer line = buffer;
+        SharedBuffer resync;
+        for (int id : view.spectators) {
+            Spectator& spectator = spectators[id];
+            if (spectator.count < queueLength) {
+                push(spectator, line);
+                continue;
+            }
+            // Too far behind: keep only a line already half written, then catch up in one go
+            size_t keep = spectator.offset > 0 ? 1 : 0;
+            for (size_t i = keep; i < spectator.count; i++) {
+                spectator.queue[(spectator.head + i) % queueLength].reset();
+            }
+            spectator.count = keep;
+            if (!resync) {
+                resync = snapshot(event.match);
+            }
+            push(spectator, resync);
+            stats.resyncs++;
+        }
+        if (event.type == TURN_MATCH_CLOSED) {
+            close(event.match);
+        }
+    }
+
+    // Forgets a match: a new one on its id starts from a clean view. Its viewers keep what is
+    // queued for them and get nothing more until the caller unsubscribes them.
+    void close(int match) {
+        MatchView& view = viewFor(match);
+        for (int id : view.spectators) {
+            spectators[id].match = -1;
+        }
+        view = MatchView();
+    }
+
+    // Writes as much of the spectator's queue as its fd takes right now; returns the bytes written.
+    // A spectator whose fd fails for good is unsubscribed.
+    size_t flush(int id) {
+        Spectator& spectator = spectators[id];
+        size_t total = 0;
+        while (spectator.fd >= 0 && spectator.count > 0) {
+            size_t batch = std::min(spectator.count, static_cast<size_t>(kBroadcastBatch));
+            long written = writeQueued(spectator, batch);
+            if (written < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    unsubscribe(id);
+                }
+                break;
+            }
+            total += static_cast<size_t>(written);
+            consume(spectator, static_cast<size_t>(written));
+            if (written == 0) {
+                break;
+            }
+        }
+        stats.bytesWritten += static_cast<long>(total);
+        return total;
+    }
+
+    size_t flushAll() {
+        size_t total = 0;
+        for (size_t id = 0; id < spectators.size(); id++) {
+            total += flush(static_cast<int>(id));
+        }
+        return total;
+    }
+
+    // Lines waiting to be written to a spectator
+    size_t backlog(int id) const {
+        return spectators[id].count;
+    }
+
+    // Spectator slots, in use or waiting for the next subscribe
+    size_t spectatorSlots() const {
+        return spectators.size();
+    }
+
+    const BroadcastStats& statistics() const {
+        return stats;
+    }
+
+    // Memory of the buffers
+    const ArenaStats& bufferMemory() const {
+        return lines.statistics();
+    }
+
+private:
+    struct Spectator {
+        int fd;
+        int match; // -1 once the match is closed
+        std::vector<SharedBuffer> queue; // ring of queueLength entries
+        size_t head = 0;
+        size_t count = 0;
+        size_t offset = 0; // bytes of the front buffer already written
+    };
+
+    // Where a match stands, as far as its events tell
+    struct MatchView {
+        int letters[2] = {0, 0};
+        int setter = 0;
+        int winner = -1;
+        std::vector<int> spectators;
+    };
+
+    MatchView& viewFor(int match) {
+        if (match >= static_cast<int>(views.size())) {
+            views.resize(match + 1);
+        }
+        return views[match];
+    }
+
+    std::shared_ptr<BroadcastBuffer> newBuffer() {
+        return std::allocate_shared<BroadcastBuffer>(ArenaAllocator<BroadcastBuffer>(&lines));
+    }
+
+    SharedBuffer snapshot(int match) {
+        const MatchView& view = viewFor(match);
+        std::shared_ptr<BroadcastBuffer> buffer = newBuffer();
+        buffer->size = std::snprintf(buffer->data, kBroadcastLine, "S %d %d %d %d %d\n", match, view.letters[0],
+                                     view.letters[1], view.setter, view.winner);
+        return buffer;
+    }
+
+    void push(Spectator& spectator, const SharedBuffer& buffer) {
+        spectator.queue[(spectator.head + spectator.count) % queueLength] = buffer;
+        spectator.count++;
+        stats.queued++;
+    }
+
+    long writeQueued(const Spectator& spectator, size_t batch) {
+#ifndef _WIN32
+        struct iovec parts[kBroadcastBatch];
+        for (size_t i = 0; i < batch; i++) {
+            const BroadcastBuffer& buffer = *spectator.queue[(spectator.head + i) % queueLength];
+            size_t skip = i == 0 ? spectator.offset : 0;
+            parts[i].iov_base = const_cast<char*>(buffer.data + skip);
+            parts[i].iov_len = buffer.size - skip;
+        }
+        return static_cast<long>(::writev(spectator.fd, parts, static_cast<int>(batch)));
+#else
+        const BroadcastBuffer& buffer = *spectator.queue[spectator.head];
+        (void)batch;
+        return ::_write(spectator.fd, buffer.data + spectator.offset,
+                        static_cast<unsigned int>(buffer.size - spectator.offset));
+#endif
+    }
+
+    // Drops the buffers (and part of a buffer) a write got through
+    void consume(Spectator& spectator, size_t written) {
+        while (written > 0) {
+            SharedBuffer& front = spectator.queue[spectator.head];
+            size_t left = front->size - spectator.offset;
+            if (written < left) {
+                spectator.offset += written;
+                return;
+            }
+            written -= left;
+            front.reset();
+            spectator.offset = 0;
+            spectator.head = (spectator.head + 1) % queueLength;
+            spectator.count--;
+        }
+    }
+
+    SlabPool slabs;
+    SessionArena lines; // before every queue holding a buffer
+    size_t queueLength;
+    std::vector<Spectator> spectators;
+    std::vector<int> leftIds; // slots of spectators who unsubscribed
+    std::vector<MatchView> views;
+    BroadcastStats stats;
+};
+
+#endif // SKATE_BROADCAST_H
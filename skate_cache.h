@@ -0,0 +1,383 @@
+// Game of Skate - result cache
+// Remembers answers that took work to find (solved positions, simulated estimates) so the same
+// question is answered instantly the next time, also after the program has been restarted.
+//
+// Keys are 64-bit hashes of everything the answer depends on. The table is split into shards
+// by key; lookups take a shard's lock shared, so readers never wait for each other. When a
+// shard is full it throws out the entry that is cheapest to work out again and least recently
+// used (GreedyDual: priority = cost + the priority of the last entry thrown out), judged from
+// a small random sample instead of a full scan.
+//
+// The cache file is a fixed-size header followed by fixed-size records. It is mapped into
+// memory on load and written to a temporary file that replaces the old one on save.
+
+#ifndef SKATE_CACHE_H
+#define SKATE_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "skate_core.h"
+#include "skate_bot.h"
+#include "skate_rules.h"
+#include "skate_solver.h"
+
+struct CachedResult {
+    double value;
+    double stdError; // 0 for exact results
+};
+
+struct CacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+};
+
+// Builds a key by hashing numbers one at a time (SplitMix64 finaliser after every word)
+class CacheKey {
+public:
+    CacheKey() : hash(0x736B617465ULL) {}
+
+    CacheKey& add(uint64_t word) {
+        uint64_t z = hash ^ (word + 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        hash = z ^ (z >> 31);
+        return *this;
+    }
+
+    CacheKey& add(const std::vector<int>& values) {
+        add(values.size());
+        for (int value : values) {
+            add(static_cast<uint64_t>(static_cast<int64_t>(value)));
+        }
+        return *this;
+    }
+
+    uint64_t value() const {
+        return hash;
+    }
+
+private:
+    uint64_t hash;
+};
+
+// Identifies the rules a result was worked out under. The version goes up whenever the
+// meaning of a rule changes, so results under the old meaning are not found again.
+inline uint64_t rulesetKey(const RuleSet& rules) {
+    const uint64_t kRulesVersion = 1;
+    const RuleVariant& variant = rules.info();
+    CacheKey key;
+    key.add(kRulesVersion).add(variant.letters).add(variant.curve.base).add(variant.curve.slope);
+    return key.add(rules.lastLetterRetry).value();
+}
+
+// Key of a position in a matchup. The two success tables are put in a fixed order (and the
+// position mirrored to match), so "A against B" and "B against A" share one entry. When
+// `mirrored` comes back true the cached value is from the other player's side: use 1 - value.
+inline uint64_t matchupKey(const std::vector<std::vector<int>>& chances, uint64_t ruleset,
+                           const BotState& state, bool& mirrored) {
+    mirrored = chances[1] < chances[0];
+    int first = mirrored ? 1 : 0;
+    CacheKey key;
+    key.add(ruleset).add(chances[first]).add(chances[1 - first]);
+    key.add(state.letters[first]).add(state.letters[1 - first]).add(state.setter == first ? 0 : 1);
+    return key.value();
+}
+
+class ResultCache {
+public:
+    // Shard count is rounded up to a power of two
+    explicit ResultCache(size_t capacity = 1 << 16, int shardCount = 16) {
+        int count = 1;
+        while (count < shardCount) {
+            count *= 2;
+        }
+        shardMask = count - 1;
+        for (int i = 0; i < count; i++) {
+            shards.emplace_back(new Shard());
+            shards.back()->capacity = std::max<size_t>(1, (capacity + count - 1) / count);
+            shards.back()->sampler = 0x9E3779B97F4A7C15ULL * (i + 1);
+        }
+    }
+
+    bool find(uint64_t key, CachedResult& result) {
+        Shard& shard = shardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // Touching an entry raises its priority again; a plain store is enough for a hint
+        it->second.priority.store(shard.inflation + it->second.cost, std::memory_order_relaxed);
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        result = it->second.result;
+        return true;
+    }
+
+    // cost: how long the result took to work out, in seconds
+    void insert(uint64_t key, const CachedResult& result, double cost) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            while (shard.entries.size() >= shard.capacity) {
+                evictOne(shard);
+            }
+            it = shard.entries.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                                       std::forward_as_tuple()).first;
+        }
+        it->second.result = result;
+        it->second.cost = cost;
+        it->second.priority.store(shard.inflation + cost, std::memory_order_relaxed);
+    }
+
+    // Cached result for key, or compute() timed and stored. Two threads missing the same key
+    // at once may both compute it; the answers are the same, so the second one just wins.
+    template <typename Compute>
+    CachedResult findOrCompute(uint64_t key, Compute compute) {
+        CachedResult result;
+        if (find(key, result)) {
+            return result;
+        }
+        auto start = std::chrono::steady_clock::now();
+        result = compute();
+        insert(key, result, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        return result;
+    }
+
+    CacheStats stats() const {
+        CacheStats total = {0, 0, 0, 0};
+        for (const auto& shard : shards) {
+            std::shared_lock<std::shared_mutex> lock(shard->lock);
+            total.hits += shard->hits.load(std::memory_order_relaxed);
+            total.misses += shard->misses.load(std::memory_order_relaxed);
+            total.evictions += shard->evictions;
+            total.entries += shard->entries.size();
+        }
+        return total;
+    }
+
+    // Adds the entries of a cache file; a missing file is an empty cache, not an error
+    bool load(const std::string& path) {
+        const char* data = nullptr;
+        size_t size = 0;
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return errno == ENOENT;
+        }
+        struct stat info;
+        void* mapped = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            size = static_cast<size_t>(info.st_size);
+            mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const char*>(mapped);
+#else
+        std::vector<char> copy;
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return true;
+        }
+        copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data = copy.data();
+        size = copy.size();
+#endif
+        bool ok = loadRecords(data, size);
+#ifndef _WIN32
+        ::munmap(const_cast<char*>(data), size);
+#endif
+        return ok;
+    }
+
+    bool save(const std::string& path) const {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            uint64_t count = stats().entries;
+            out.write(kFileMagic, sizeof(kFileMagic));
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            uint64_t written = 0;
+            for (const auto& shard : shards) {
+                std::shared_lock<std::shared_mutex> lock(shard->lock);
+                for (const auto& entry : shard->entries) {
+                    // Entries added since count was taken wait for the next save
+                    if (written == count) {
+                        break;
+                    }
+                    Record record = {entry.first, entry.second.result.value, entry.second.result.stdError,
+                                     entry.second.cost};
+                    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+                    written++;
+                }
+            }
+            if (written < count) {
+                // Entries were evicted while saving: fix up the header
+                out.seekp(sizeof(kFileMagic));
+                out.write(reinterpret_cast<const char*>(&written), sizeof(written));
+            }
+            if (!out) {
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+private:
+    static constexpr char kFileMagic[8] = {'S', 'K', 'C', 'A', 'C', 'H', 'E', '1'};
+    // Entries looked at to pick one to throw out
+    static const int kEvictionSample = 8;
+
+    struct Record {
+        uint64_t key;
+        double value;
+        double stdError;
+        double cost;
+    };
+
+    struct Entry {
+        CachedResult result;
+        double cost;
+        std::atomic<double> priority;
+    };
+
+    struct Shard {
+        mutable std::shared_mutex lock;
+        std::unordered_map<uint64_t, Entry> entries;
+        size_t capacity;
+        double inflation = 0.0; // priority of the last entry thrown out
+        uint64_t sampler;
+        uint64_t evictions = 0;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    Shard& shardFor(uint64_t key) {
+        // The low bits pick the bucket inside a shard, so shards go by the high bits
+        return *shards[(key >> 48) & shardMask];
+    }
+
+    // Called with the shard locked exclusively
+    void evictOne(Shard& shard) {
+        size_t buckets = shard.entries.bucket_count();
+        shard.sampler = shard.sampler * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t bucket = static_cast<size_t>(shard.sampler >> 33) % buckets;
+        auto victim = shard.entries.end();
+        double lowest = 0.0;
+        int seen = 0;
+        for (size_t step = 0; step < buckets && seen < kEvictionSample; step++) {
+            size_t b = (bucket + step) % buckets;
+            for (auto it = shard.entries.begin(b); it != shard.entries.end(b); ++it) {
+                double priority = it->second.priority.load(std::memory_order_relaxed);
+                if (victim == shard.entries.end() || priority < lowest) {
+                    victim = shard.entries.find(it->first);
+                    lowest = priority;
+                }
+                seen++;
+            }
+        }
+        shard.inflation = std::max(shard.inflation, lowest);
+        shard.entries.erase(victim);
+        shard.evictions++;
+    }
+
+    bool loadRecords(const char* data, size_t size) {
+        const size_t header = sizeof(kFileMagic) + sizeof(uint64_t);
+        if (size < header || std::memcmp(data, kFileMagic, sizeof(kFileMagic)) != 0) {
+            return false;
+        }
+        uint64_t count;
+        std::memcpy(&count, data + sizeof(kFileMagic), sizeof(count));
+        if (count > (size - header) / sizeof(Record)) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            Record record;
+            std::memcpy(&record, data + header + i * sizeof(Record), sizeof(record));
+            CachedResult result = {record.value, record.stdError};
+            insert(record.key, result, record.cost);
+        }
+        return true;
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    uint64_t shardMask;
+};
+
+// Solved matchup from the cache if every position of it is there, from the solver otherwise.
+// A miss stores every position, since the solver works them all out anyway.
+inline SolvedMatchup cachedSolve(ResultCache& cache, const std::vector<std::vector<int>>& chances,
+                                 const RuleSet& rules = RuleSet()) {
+    const int full = rules.letters();
+    uint64_t ruleset = rulesetKey(rules);
+    SolvedMatchup solved;
+    solved.rules = rules;
+    bool complete = true;
+    for (int a = 0; a <= full; a++) {
+        for (int b = 0; b <= full; b++) {
+            for (int setter = 0; setter < 2; setter++) {
+                BotState state = {{a, b}, setter};
+                CachedResult result;
+                bool mirrored;
+                if (a == full || b == full) {
+                    solved.value[a][b][setter] = b == full ? 1.0 : 0.0;
+                } else if (complete && cache.find(matchupKey(chances, ruleset, state, mirrored), result)) {
+                    solved.value[a][b][setter] = mirrored ? 1.0 - result.value : result.value;
+                } else {
+                    complete = false;
+                }
+            }
+        }
+    }
+    if (complete) {
+        return solved;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    solved = solveMatchup(chances, rules);
+    double cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const int positions = 2 * full * full;
+    for (int a = 0; a < full; a++) {
+        for (int b = 0; b < full; b++) {
+            for (int setter = 0; setter < 2; setter++) {
+                BotState state = {{a, b}, setter};
+                bool mirrored;
+                uint64_t key = matchupKey(chances, ruleset, state, mirrored);
+                double value = solved.value[a][b][setter];
+                CachedResult result = {mirrored ? 1.0 - value : value, 0.0};
+                cache.insert(key, result, cost / positions);
+            }
+        }
+    }
+    return solved;
+}
+
+#endif // SKATE_CACHE_H
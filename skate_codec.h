@@ -0,0 +1,649 @@
+// Game of Skate - attempt stream codec
+// Packs streams of attempts (see skate_store.h) into a few bits each, for archiving months of
+// matches, and reads any part of an archive back without decoding what comes before it.
+//
+// Attempts are coded in blocks of 16K. Within a block each attempt is predicted from the one
+// before it: a responder goes for the trick just set, players take turns, and a trick keeps
+// its difficulty. An attempt becomes a one-byte op (same trick?, same / other / new player,
+// landed, role, new difficulty?), plus a trick only when it changed and the seconds since the
+// last attempt. The op, trick and time streams are entropy coded with rANS under frequency
+// tables fitted to the block; whatever does not fit in a symbol goes to a raw varint stream.
+//
+// Archive layout: magic, blocks, player names, an index of (offset, first attempt) per block,
+// and a trailer with where things are and how many. Blocks start afresh, so any one decodes
+// on its own.
+//
+// C++11, like skate_store.h, which it includes for AttemptEvent. skate_stats is its only user.
+
+#ifndef SKATE_CODEC_H
+#define SKATE_CODEC_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "skate_store.h"
+
+// Attempts per block, the unit of random access
+const int kCodecBlockEvents = 16384;
+
+// Frequencies of a block's symbols add up to 1 << kCodecProbBits
+const int kCodecProbBits = 12;
+const uint32_t kCodecProbScale = 1u << kCodecProbBits;
+
+// rANS state stays in [kRansLow, kRansLow << 8)
+const uint32_t kRansLow = 1u << 23;
+
+// Symbol meaning "look in the raw stream"
+const int kCodecEscape = 255;
+
+const char kCodecMagic[8] = {'S', 'K', 'A', 'R', 'C', 'H', '0', '1'};
+
+// Bits of an op
+enum CodecOp {
+    OP_SAME_TRICK = 1,      // trick of the attempt before
+    OP_OTHER_PLAYER = 2,    // the player before the last one
+    OP_NEW_PLAYER = 4,      // player in the raw stream
+    OP_LANDED = 8,
+    OP_SETTER = 16,
+    OP_NEW_DIFFICULTY = 32  // difficulty in the raw stream
+};
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Scales symbol counts to frequencies adding up to kCodecProbScale; every symbol seen keeps at least 1
+inline void normalizeFrequencies(const uint32_t* counts, uint32_t* freq) {
+    uint64_t total = 0;
+    for (int s = 0; s < 256; s++) {
+        total += counts[s];
+    }
+    uint32_t sum = 0;
+    int largest = 0;
+    for (int s = 0; s < 256; s++) {
+        freq[s] = counts[s] == 0 ? 0 : std::max<uint32_t>(1, static_cast<uint32_t>(counts[s] * kCodecProbScale / total));
+        sum += freq[s];
+        if (freq[s] > freq[largest]) {
+            largest = s;
+        }
+    }
+    if (sum <= kCodecProbScale) {
+        freq[largest] += kCodecProbScale - sum;
+        return;
+    }
+    // Rounding the rare symbols up overshot: take it back from the commonest ones
+    while (sum > kCodecProbScale) {
+        int biggest = static_cast<int>(std::max_element(freq, freq + 256) - freq);
+        freq[biggest]--;
+        sum--;
+    }
+}
+
+// Codes symbols (last to first, so they decode first to last) and appends the bytes to out
+inline void ransEncode(const std::vector<uint8_t>& symbols, const uint32_t* freq, std::vector<uint8_t>& out) {
+    uint32_t start[256];
+    uint32_t cumulative = 0;
+    for (int s = 0; s < 256; s++) {
+        start[s] = cumulative;
+        cumulative += freq[s];
+    }
+    std::vector<uint8_t> bytes;
+    uint32_t x = kRansLow;
+    for (size_t i = symbols.size(); i-- > 0;) {
+        uint32_t f = freq[symbols[i]];
+        uint32_t limit = ((kRansLow >> kCodecProbBits) << 8) * f;
+        while (x >= limit) {
+            bytes.push_back(static_cast<uint8_t>(x));
+            x >>= 8;
+        }
+        x = ((x / f) << kCodecProbBits) + (x % f) + start[symbols[i]];
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        bytes.push_back(static_cast<uint8_t>(x >> shift));
+    }
+    out.insert(out.end(), bytes.rbegin(), bytes.rend());
+}
+
+// Slot lookup for decoding: the symbol of every slot, its frequency and its place in the symbol's range
+struct RansTable {
+    uint8_t symbol[kCodecProbScale];
+    uint16_t freq[kCodecProbScale];
+    uint16_t offset[kCodecProbScale];
+
+    void build(const uint32_t* frequencies) {
+        uint32_t slot = 0;
+        for (int s = 0; s < 256; s++) {
+            for (uint32_t i = 0; i < frequencies[s]; i++, slot++) {
+                symbol[slot] = static_cast<uint8_t>(s);
+                freq[slot] = static_cast<uint16_t>(frequencies[s]);
+                offset[slot] = static_cast<uint16_t>(i);
+            }
+        }
+    }
+};
+
+// A damaged stream cannot hang the decoder: running out of bytes leaves the state below
+// kRansLow for good, and finished() then reports the stream as damaged.
+struct RansDecoder {
+    uint32_t x;
+    const uint8_t* p;
+    const uint8_t* end;
+    const RansTable* table;
+
+    // False unless the stream opens with a state the encoder could have written
+    bool start(const RansTable& codeTable, const uint8_t* begin, const uint8_t* stop) {
+        table = &codeTable;
+        p = begin;
+        end = stop;
+        x = 0;
+        if (end - p < 4) {
+            return false;
+        }
+        for (int i = 0; i < 4; i++) {
+            x |= static_cast<uint32_t>(*p++) << (8 * i);
+        }
+        return x >= kRansLow && x < (kRansLow << 8);
+    }
+
+    int next() {
+        uint32_t slot = x & (kCodecProbScale - 1);
+        int s = table->symbol[slot];
+        x = table->freq[slot] * (x >> kCodecProbBits) + table->offset[slot];
+        while (x < kRansLow && p < end) {
+            x = (x << 8) | *p++;
+        }
+        return s;
+    }
+
+    // The encoder started from kRansLow and wrote nothing past the last symbol
+    bool finished() const {
+        return x == kRansLow && p == end;
+    }
+};
+
+// Writes attempts to an archive as they come
+class AttemptEncoder {
+public:
+    explicit AttemptEncoder(std::ostream& stream) : out(stream), position(0), events(0) {
+        out.write(kCodecMagic, sizeof(kCodecMagic));
+        position = sizeof(kCodecMagic);
+    }
+
+    // Dictionary number of a player, adding them if they are new
+    uint32_t actor(const std::string& name) {
+        std::unordered_map<std::string, uint32_t>::const_iterator it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(names.size());
+        ids[name] = id;
+        names.push_back(name);
+        return id;
+    }
+
+    void add(const AttemptEvent& event) {
+        pending.push_back(event);
+        if (pending.size() == static_cast<size_t>(kCodecBlockEvents)) {
+            encodeBlock();
+        }
+    }
+
+    // Writes the last block, the player names, the index and the trailer
+    bool finish() {
+        encodeBlock();
+        uint64_t dictionaryOffset = position;
+        std::vector<uint8_t> dictionary;
+        for (size_t i = 0; i < names.size(); i++) {
+            putVarint(dictionary, names[i].size());
+            dictionary.insert(dictionary.end(), names[i].begin(), names[i].end());
+        }
+        write(dictionary.data(), dictionary.size());
+        uint64_t indexOffset = position;
+        for (size_t i = 0; i < index.size(); i++) {
+            write(&index[i], sizeof(index[i]));
+        }
+        uint64_t trailer[5] = {indexOffset, static_cast<uint64_t>(index.size()), events, dictionaryOffset,
+                               static_cast<uint64_t>(names.size())};
+        write(trailer, sizeof(trailer));
+        write(kCodecMagic, sizeof(kCodecMagic));
+        out.flush();
+        return static_cast<bool>(out);
+    }
+
+    uint64_t bytesWritten() const {
+        return position;
+    }
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        uint64_t firstEvent;
+    };
+
+    void write(const void* data, size_t size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        position += size;
+    }
+
+    void encodeBlock() {
+        if (pending.empty()) {
+            return;
+        }
+        std::vector<uint8_t> streams[3]; // ops, tricks, time gaps
+        std::vector<uint8_t> raw;
+        uint32_t last = ~0u;
+        uint32_t other = ~0u;
+        int previousTrick = -1;
+        int64_t previousTime = pending[0].time;
+        uint8_t difficulty[256] = {0};
+        for (size_t i = 0; i < pending.size(); i++) {
+            const AttemptEvent& event = pending[i];
+            int op = 0;
+            if (event.trick == previousTrick) {
+                op |= OP_SAME_TRICK;
+            } else if (event.trick < kCodecEscape) {
+                streams[1].push_back(static_cast<uint8_t>(event.trick));
+            } else {
+                streams[1].push_back(kCodecEscape);
+                putVarint(raw, event.trick);
+            }
+            if (event.actor == other) {
+                op |= OP_OTHER_PLAYER;
+                std::swap(last, other);
+            } else if (event.actor != last) {
+                op |= OP_NEW_PLAYER;
+                putVarint(raw, event.actor);
+                other = last;
+                last = event.actor;
+            }
+            op |= event.landed ? OP_LANDED : 0;
+            op |= event.role == ROLE_SETTER ? OP_SETTER : 0;
+            uint8_t predicted = event.trick < 256 ? difficulty[event.trick] : 0;
+            if (event.difficulty != predicted) {
+                op |= OP_NEW_DIFFICULTY;
+                raw.push_back(event.difficulty);
+                if (event.trick < 256) {
+                    difficulty[event.trick] = event.difficulty;
+                }
+            }
+            uint64_t gap = zigzag(static_cast<int64_t>(static_cast<uint64_t>(event.time) -
+                                                       static_cast<uint64_t>(previousTime)));
+            if (gap < static_cast<uint64_t>(kCodecEscape)) {
+                streams[2].push_back(static_cast<uint8_t>(gap));
+            } else {
+                streams[2].push_back(kCodecEscape);
+                putVarint(raw, gap);
+            }
+            streams[0].push_back(static_cast<uint8_t>(op));
+            previousTrick = event.trick;
+            previousTime = event.time;
+        }
+
+        // Header: attempts, first time, then per stream its frequency table and coded length
+        std::vector<uint8_t> header;
+        std::vector<uint8_t> body;
+        putVarint(header, pending.size());
+        putVarint(header, zigzag(pending[0].time));
+        for (int k = 0; k < 3; k++) {
+            uint32_t counts[256] = {0};
+            uint32_t freq[256];
+            for (size_t i = 0; i < streams[k].size(); i++) {
+                counts[streams[k][i]]++;
+            }
+            normalizeFrequencies(counts, freq);
+            if (streams[k].empty()) {
+                std::fill(freq, freq + 256, 0u);
+            }
+            int present = static_cast<int>(256 - std::count(freq, freq + 256, 0u));
+            putVarint(header, present);
+            for (int s = 0; s < 256; s++) {
+                if (freq[s] > 0) {
+                    header.push_back(static_cast<uint8_t>(s));
+                    putVarint(header, freq[s]);
+                }
+            }
+            size_t before = body.size();
+            if (!streams[k].empty()) {
+                ransEncode(streams[k], freq, body);
+            }
+            putVarint(header, body.size() - before);
+        }
+        putVarint(header, raw.size());
+        body.insert(body.end(), raw.begin(), raw.end());
+
+        IndexEntry entry = {position, events};
+        index.push_back(entry);
+        write(header.data(), header.size());
+        write(body.data(), body.size());
+        events += pending.size();
+        pending.clear();
+    }
+
+    std::ostream& out;
+    uint64_t position;
+    uint64_t events;
+    std::vector<AttemptEvent> pending;
+    std::vector<IndexEntry> index;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+// Reads an archive written by AttemptEncoder. Decoding never changes it, so any number of
+// threads can decode blocks of one archive at once.
+class AttemptArchive {
+public:
+    AttemptArchive() : blockCount(0), eventCount(0), blocksEnd(0) {}
+
+    bool open(const std::string& path) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return load(data);
+    }
+
+    bool load(const std::vector<uint8_t>& data) {
+        bytes = data;
+        blockCount = 0;
+        eventCount = 0;
+        names.clear();
+        ids.clear();
+        // Trailer: index offset, blocks, attempts, dictionary offset, players, magic
+        size_t trailer = 5 * sizeof(uint64_t) + sizeof(kCodecMagic);
+        if (bytes.size() < sizeof(kCodecMagic) + trailer ||
+            std::memcmp(bytes.data(), kCodecMagic, sizeof(kCodecMagic)) != 0 ||
+            std::memcmp(bytes.data() + bytes.size() - sizeof(kCodecMagic), kCodecMagic, sizeof(kCodecMagic)) != 0) {
+            return false;
+        }
+        uint64_t fields[5];
+        std::memcpy(fields, bytes.data() + bytes.size() - trailer, sizeof(fields));
+        uint64_t indexEnd = bytes.size() - trailer;
+        if (fields[0] > indexEnd || fields[1] != (indexEnd - fields[0]) / 16 || fields[3] > fields[0]) {
+            return false;
+        }
+        offsets.resize(fields[1]);
+        firstEvents.resize(fields[1]);
+        for (uint64_t b = 0; b < fields[1]; b++) {
+            std::memcpy(&offsets[b], bytes.data() + fields[0] + 16 * b, sizeof(uint64_t));
+            std::memcpy(&firstEvents[b], bytes.data() + fields[0] + 16 * b + 8, sizeof(uint64_t));
+            if (offsets[b] > fields[3] || (b > 0 && (offsets[b] < offsets[b - 1] || firstEvents[b] < firstEvents[b - 1]))) {
+                return false;
+            }
+        }
+        const uint8_t* p = bytes.data() + fields[3];
+        const uint8_t* end = bytes.data() + fields[0];
+        for (uint64_t i = 0; i < fields[4]; i++) {
+            uint64_t length;
+            if (!getVarint(p, end, length) || length > static_cast<uint64_t>(end - p)) {
+                return false;
+            }
+            names.push_back(std::string(reinterpret_cast<const char*>(p), static_cast<size_t>(length)));
+            ids[names.back()] = static_cast<uint32_t>(i);
+            p += length;
+        }
+        blockCount = static_cast<size_t>(fields[1]);
+        eventCount = fields[2];
+        blocksEnd = fields[3];
+        return true;
+    }
+
+    static bool isArchive(const std::string& path) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        char magic[sizeof(kCodecMagic)] = {0};
+        in.read(magic, sizeof(magic));
+        return in && std::memcmp(magic, kCodecMagic, sizeof(kCodecMagic)) == 0;
+    }
+
+    size_t blocks() const {
+        return blockCount;
+    }
+
+    uint64_t events() const {
+        return eventCount;
+    }
+
+    size_t size() const {
+        return bytes.size();
+    }
+
+    size_t playerCount() const {
+        return names.size();
+    }
+
+    // Dictionary number of a player, or -1
+    int64_t actor(const std::string& name) const {
+        std::unordered_map<std::string, uint32_t>::const_iterator it = ids.find(name);
+        return it == ids.end() ? -1 : static_cast<int64_t>(it->second);
+    }
+
+    // Name of a player the encoder was told about, or "" for a bare number
+    std::string actorName(uint32_t actor) const {
+        return actor < names.size() ? names[actor] : std::string();
+    }
+
+    // Number of the first attempt in a block
+    uint64_t firstEvent(size_t block) const {
+        return firstEvents[block];
+    }
+
+    // Appends the attempts of one block to out; false if the block is damaged
+    bool decodeBlock(size_t block, std::vector<AttemptEvent>& out) const {
+        const uint8_t* p = bytes.data() + offsets[block];
+        const uint8_t* end = bytes.data() + (block + 1 < blockCount ? offsets[block + 1] : blocksEnd);
+        uint64_t count;
+        uint64_t firstTime;
+        if (!getVarint(p, end, count) || !getVarint(p, end, firstTime) || count == 0 ||
+            count > static_cast<uint64_t>(kCodecBlockEvents)) {
+            return false;
+        }
+        std::vector<RansTable> tables(3);
+        uint64_t lengths[4];
+        uint64_t symbolsIn[3];
+        for (int k = 0; k < 3; k++) {
+            uint32_t freq[256] = {0};
+            uint64_t present;
+            if (!getVarint(p, end, present) || present > 256) {
+                return false;
+            }
+            uint64_t total = 0;
+            for (uint64_t i = 0; i < present; i++) {
+                uint64_t f;
+                if (p >= end) {
+                    return false;
+                }
+                uint8_t s = *p++;
+                if (!getVarint(p, end, f) || f > kCodecProbScale) {
+                    return false;
+                }
+                freq[s] = static_cast<uint32_t>(f);
+                total += f;
+            }
+            if (present > 0 && total != kCodecProbScale) {
+                return false;
+            }
+            symbolsIn[k] = present;
+            tables[k].build(freq);
+            if (!getVarint(p, end, lengths[k])) {
+                return false;
+            }
+        }
+        if (!getVarint(p, end, lengths[3])) {
+            return false;
+        }
+        const uint8_t* begin[4];
+        for (int k = 0; k < 4; k++) {
+            if (lengths[k] > static_cast<uint64_t>(end - p)) {
+                return false;
+            }
+            begin[k] = p;
+            p += lengths[k];
+        }
+        // Every attempt has an op and a gap; the trick stream may be empty
+        RansDecoder ops;
+        RansDecoder gaps;
+        if (symbolsIn[0] == 0 || symbolsIn[2] == 0 || !ops.start(tables[0], begin[0], begin[0] + lengths[0]) ||
+            !gaps.start(tables[2], begin[2], begin[2] + lengths[2])) {
+            return false;
+        }
+        const uint8_t* raw = begin[3];
+        const uint8_t* rawEnd = begin[3] + lengths[3];
+
+        // The streams are independent: decode them first, ops and gaps side by side so the
+        // two chains of state updates overlap, then put the attempts together
+        std::vector<uint8_t> symbols(3 * count + 1); // + 1: the trick read ahead of the last op
+        uint8_t* opSymbols = symbols.data();
+        uint8_t* gapSymbols = opSymbols + count;
+        uint8_t* trickSymbols = gapSymbols + count;
+        size_t newTricks = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            opSymbols[i] = static_cast<uint8_t>(ops.next());
+            gapSymbols[i] = static_cast<uint8_t>(gaps.next());
+            newTricks += (opSymbols[i] & OP_SAME_TRICK) ? 0 : 1;
+        }
+        RansDecoder tricks = RansDecoder();
+        if (newTricks > 0) {
+            if (symbolsIn[1] == 0 || !tricks.start(tables[1], begin[1], begin[1] + lengths[1])) {
+                return false;
+            }
+            for (size_t i = 0; i < newTricks; i++) {
+                trickSymbols[i] = static_cast<uint8_t>(tricks.next());
+            }
+        }
+        if (!ops.finished() || !gaps.finished() || (newTricks > 0 && !tricks.finished())) {
+            return false;
+        }
+
+        uint32_t last = ~0u;
+        uint32_t other = ~0u;
+        int trick = -1;
+        size_t nextTrick = 0;
+        int64_t time = unzigzag(firstTime);
+        uint8_t difficulty[256] = {0};
+        size_t first = out.size();
+        out.resize(first + count);
+        AttemptEvent* event = out.data() + first;
+        for (uint64_t i = 0; i < count; i++, event++) {
+            int op = opSymbols[i];
+            uint64_t value;
+            // Selects rather than branches where the bits are as good as random
+            int newTrick = (op & OP_SAME_TRICK) ^ 1;
+            int keep = newTrick - 1; // all ones when the trick stays
+            trick = (trickSymbols[nextTrick] & ~keep) | (trick & keep);
+            nextTrick += newTrick;
+            if (newTrick && trick == kCodecEscape) {
+                if (!getVarint(raw, rawEnd, value)) {
+                    return false;
+                }
+                trick = static_cast<int>(value);
+            }
+            uint32_t swapMask = 0u - static_cast<uint32_t>((op & OP_OTHER_PLAYER) >> 1);
+            uint32_t swapBits = (last ^ other) & swapMask;
+            last ^= swapBits;
+            other ^= swapBits;
+            if (op & OP_NEW_PLAYER) {
+                if (!getVarint(raw, rawEnd, value)) {
+                    return false;
+                }
+                other = last;
+                last = static_cast<uint32_t>(value);
+            }
+            uint8_t level;
+            if (op & OP_NEW_DIFFICULTY) {
+                if (raw >= rawEnd) {
+                    return false;
+                }
+                level = *raw++;
+                if (trick < 256) {
+                    difficulty[trick] = level;
+                }
+            } else {
+                level = trick < 256 ? difficulty[trick] : 0;
+            }
+            uint64_t gap = gapSymbols[i];
+            if (gap == static_cast<uint64_t>(kCodecEscape) && !getVarint(raw, rawEnd, gap)) {
+                return false;
+            }
+            time = static_cast<int64_t>(static_cast<uint64_t>(time) + static_cast<uint64_t>(unzigzag(gap)));
+            AttemptEvent decoded;
+            decoded.actor = last;
+            decoded.trick = static_cast<TrickId>(trick);
+            decoded.difficulty = level;
+            decoded.landed = (op & OP_LANDED) ? 1 : 0;
+            decoded.role = static_cast<uint8_t>((op & OP_SETTER) ? ROLE_SETTER : ROLE_RESPONDER);
+            decoded.time = time;
+            *event = decoded;
+        }
+        return true;
+    }
+
+    // Appends attempts [first, first + count) to out, decoding only the blocks they are in
+    bool read(uint64_t first, uint64_t count, std::vector<AttemptEvent>& out) const {
+        if (first + count > eventCount) {
+            return false;
+        }
+        size_t block = static_cast<size_t>(std::upper_bound(firstEvents.begin(), firstEvents.end(), first) -
+                                           firstEvents.begin()) - 1;
+        std::vector<AttemptEvent> decoded;
+        while (count > 0 && block < blockCount) {
+            decoded.clear();
+            if (!decodeBlock(block, decoded)) {
+                return false;
+            }
+            uint64_t skip = first - firstEvents[block];
+            if (skip > decoded.size()) {
+                return false;
+            }
+            uint64_t take = std::min<uint64_t>(count, decoded.size() - skip);
+            out.insert(out.end(), decoded.begin() + static_cast<std::ptrdiff_t>(skip),
+                       decoded.begin() + static_cast<std::ptrdiff_t>(skip + take));
+            first += take;
+            count -= take;
+            block++;
+        }
+        return count == 0;
+    }
+
+private:
+    std::vector<uint8_t> bytes;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> firstEvents;
+    size_t blockCount;
+    uint64_t eventCount;
+    uint64_t blocksEnd;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+#endif // SKATE_CODEC_H
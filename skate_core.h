@@ -0,0 +1,140 @@
+// Game of Skate - shared rules
+// Pieces of the game logic used by the console game, the computer opponent and the tools
+
+#ifndef SKATE_CORE_H
+#define SKATE_CORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Number of letters in "SKATE" - a player holding all of them has lost
+const int kSkateLetters = 5;
+
+// Difficulties of the 20 default tricks, in the order the games list them
+const int kDefaultTrickCount = 20;
+constexpr int kDefaultTrickDifficulties[kDefaultTrickCount] = {
+    1, 3, 3, 2, 5, 6, 4, 4, 2, 2, 5, 5, 7, 7, 2, 3, 6, 9, 8, 6
+};
+
+// Constants of the success formula: chance = base - difficulty * slope.
+// They are balance knobs, so the tools can try other values.
+struct SuccessCurve {
+    int base;
+    int slope;
+};
+
+constexpr SuccessCurve kDefaultCurve = {95, 8};
+
+// Success probability (in percent) of a trick with the given difficulty.
+// Harder tricks have lower success rates.
+constexpr int successChance(int difficulty, const SuccessCurve& curve) {
+    return curve.base - (difficulty * curve.slope);
+}
+
+constexpr int successChance(int difficulty) {
+    return successChance(difficulty, kDefaultCurve);
+}
+
+// Compact handle of a trick: its position in the catalog. The game, its log and the tools
+// pass tricks around as these and only look the name up to show it to someone.
+typedef uint16_t TrickId;
+
+// A trick of the built-in catalog. A roll of 1-100 lands it when it is at most threshold,
+// which is worked out from the difficulty by the compiler.
+struct TrickInfo {
+    const char* name;
+    int difficulty; // 1-10 scale
+    int threshold;  // successChance(difficulty)
+};
+
+constexpr TrickInfo kDefaultTricks[kDefaultTrickCount] = {
+    {"Ollie", 1, successChance(1)},
+    {"Kickflip", 3, successChance(3)},
+    {"Heelflip", 3, successChance(3)},
+    {"Pop Shove-it", 2, successChance(2)},
+    {"360 Flip", 5, successChance(5)},
+    {"Hardflip", 6, successChance(6)},
+    {"Varial Kickflip", 4, successChance(4)},
+    {"Varial Heelflip", 4, successChance(4)},
+    {"Backside 180", 2, successChance(2)},
+    {"Frontside 180", 2, successChance(2)},
+    {"Backside 360", 5, successChance(5)},
+    {"Frontside 360", 5, successChance(5)},
+    {"Impossible", 7, successChance(7)},
+    {"Casper Flip", 7, successChance(7)},
+    {"Nollie", 2, successChance(2)},
+    {"Switch Ollie", 3, successChance(3)},
+    {"Kickflip to Manual", 6, successChance(6)},
+    {"Impossible Late Flip", 9, successChance(9)},
+    {"Dolphin Flip", 8, successChance(8)},
+    {"Double Kickflip", 6, successChance(6)},
+};
+
+constexpr bool catalogMatchesDifficulties(int from = 0) {
+    return from == kDefaultTrickCount ||
+           (kDefaultTricks[from].difficulty == kDefaultTrickDifficulties[from] && catalogMatchesDifficulties(from + 1));
+}
+
+static_assert(catalogMatchesDifficulties(), "kDefaultTricks and kDefaultTrickDifficulties disagree");
+
+// Read-only view of a trick catalog; copying one copies two words.
+// The names live in static storage once, so every view hands out the same pointers.
+struct TrickCatalog {
+    const TrickInfo* tricks;
+    size_t count;
+
+    size_t size() const {
+        return count;
+    }
+
+    const TrickInfo& operator[](size_t index) const {
+        return tricks[index];
+    }
+
+    const char* name(TrickId id) const {
+        return tricks[id].name;
+    }
+
+    const TrickInfo* begin() const {
+        return tricks;
+    }
+
+    const TrickInfo* end() const {
+        return tricks + count;
+    }
+};
+
+constexpr TrickCatalog kDefaultCatalog = {kDefaultTricks, kDefaultTrickCount};
+
+// The built-in catalog as a shared, immutable catalog: games keep a reference to it instead
+// of a copy of their own. It lives in static storage, so the last reference frees nothing.
+inline const std::shared_ptr<const TrickCatalog>& sharedDefaultCatalog() {
+    static const std::shared_ptr<const TrickCatalog> catalog(&kDefaultCatalog, [](const TrickCatalog*) {});
+    return catalog;
+}
+
+// Landing threshold of a trick under a success curve; the catalog's own when it is the default
+inline int trickThreshold(const TrickInfo& trick, const SuccessCurve& curve) {
+    if (curve.base == kDefaultCurve.base && curve.slope == kDefaultCurve.slope) {
+        return trick.threshold;
+    }
+    return successChance(trick.difficulty, curve);
+}
+
+// A position in the game: letters held by each player and who sets the next trick.
+// isOver() and winner() are for SKATE; other rules read both from their CompiledRules.
+struct BotState {
+    int letters[2];
+    int setter; // 0 or 1
+
+    bool isOver() const {
+        return letters[0] >= kSkateLetters || letters[1] >= kSkateLetters;
+    }
+
+    int winner() const {
+        return letters[0] >= kSkateLetters ? 1 : 0;
+    }
+};
+
+#endif // SKATE_CORE_H
@@ -0,0 +1,202 @@
+// Game of Skate - handicaps
+// Finds the handicap that makes a game between a stronger and a weaker skater closest to 50/50.
+//
+// A handicap is any mix of: the stronger player starting with letters, the stronger player only
+// setting tricks up to some difficulty, the weaker player getting extra tries to match, and the
+// weaker player setting first. Every handicap is judged by the exact solver (both players set
+// the trick that is best for them), not by simulation, so the answer is exact and quick.
+//
+// Starting letters only move the starting position, so one solve covers every head start: the
+// search solves one matchup per difficulty cap and number of tries, spread over all cores,
+// and reads every starting position off the solved tables.
+
+#ifndef SKATE_HANDICAP_H
+#define SKATE_HANDICAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "skate_bot.h"
+#include "skate_rules.h"
+#include "skate_solver.h"
+
+// Most tries a handicap gives a player to match a trick
+const int kMaxHandicapTries = 3;
+
+struct Handicap {
+    int startLetters[2];  // letters each player starts with
+    int maxDifficulty[2]; // hardest trick each player may set
+    int tries[2];         // tries each player gets to match a trick
+    int firstSetter;
+
+    Handicap() : startLetters{0, 0}, maxDifficulty{INT_MAX, INT_MAX}, tries{1, 1}, firstSetter(0) {}
+};
+
+// Chance that player 0 wins from every position under a handicap's cap and tries, with perfect
+// play. `difficulties` holds every trick's difficulty; the letters of the handicap are ignored.
+inline SolvedMatchup solveHandicap(const std::vector<std::vector<int>>& chances, const std::vector<int>& difficulties,
+                                   const RuleSet& rules, const Handicap& handicap) {
+    SolvedMatchup solved;
+    solved.rules = rules;
+    const int full = rules.letters();
+    const size_t tricks = chances[0].size();
+
+    for (int a = 0; a <= full; a++) {
+        for (int b = 0; b <= full; b++) {
+            for (int setter = 0; setter < 2; setter++) {
+                solved.value[a][b][setter] = b == full ? 1.0 : (a == full ? 0.0 : 0.5);
+            }
+        }
+    }
+
+    // Chance that each player lands a trick to set, and matches it with their tries
+    std::vector<double> lands[2];
+    std::vector<double> matches[2][2]; // [player][on their last letter]
+    for (int p = 0; p < 2; p++) {
+        int lastTries = std::max(handicap.tries[p], rules.lastLetterRetry ? 2 : 1);
+        for (size_t t = 0; t < tricks; t++) {
+            double chance = solverProbability(chances[p][t]);
+            lands[p].push_back(difficulties[t] <= handicap.maxDifficulty[p] ? chance : 0.0);
+            matches[p][0].push_back(1.0 - std::pow(1.0 - chance, handicap.tries[p]));
+            matches[p][1].push_back(1.0 - std::pow(1.0 - chance, lastTries));
+        }
+    }
+
+    for (int total = 2 * (full - 1); total >= 0; total--) {
+        for (int a = std::min(full - 1, total); a >= 0 && total - a < full; a--) {
+            int b = total - a;
+            double letterFor1 = solved.value[a][b + 1][0];
+            double letterFor0 = solved.value[a + 1][b][1];
+            const std::vector<double>& match1 = matches[1][b == full - 1 ? 1 : 0];
+            const std::vector<double>& match0 = matches[0][a == full - 1 ? 1 : 0];
+            double v0 = 0.5;
+            double v1 = 0.5;
+            for (int iteration = 0; iteration < 10000; iteration++) {
+                // A player with no trick they may set misses their own trick every time
+                double best0 = trickValue(0.0, 0.0, v1, letterFor1);
+                double best1 = trickValue(0.0, 0.0, v0, letterFor0);
+                for (size_t t = 0; t < tricks; t++) {
+                    best0 = std::max(best0, trickValue(lands[0][t], match1[t], v1, letterFor1));
+                    best1 = std::min(best1, trickValue(lands[1][t], match0[t], v0, letterFor0));
+                }
+                double change = std::fabs(best0 - v0) + std::fabs(best1 - v1);
+                v0 = best0;
+                v1 = best1;
+                if (change < 1e-13) {
+                    break;
+                }
+            }
+            solved.value[a][b][0] = v0;
+            solved.value[a][b][1] = v1;
+        }
+    }
+    return solved;
+}
+
+// Chance that player 0 wins a game played with the handicap
+inline double handicapWinChance(const std::vector<std::vector<int>>& chances, const std::vector<int>& difficulties,
+                                const RuleSet& rules, const Handicap& handicap) {
+    BotState start = {{handicap.startLetters[0], handicap.startLetters[1]}, handicap.firstSetter};
+    return solveHandicap(chances, difficulties, rules, handicap).winChance(start);
+}
+
+struct HandicapResult {
+    Handicap handicap;
+    double winChance;   // of player 0 with the handicap
+    double evenChance;  // of player 0 without one
+    int weaker;         // the player the handicap helps
+    int solves;         // matchups solved
+    int evaluated;      // handicaps compared
+};
+
+// How much a handicap changes the game, to prefer the lightest of equally fair ones
+inline int handicapWeight(const Handicap& handicap, int weaker, int top) {
+    int stronger = 1 - weaker;
+    int cap = std::min(top, handicap.maxDifficulty[stronger]);
+    return handicap.startLetters[stronger] * 4 + (top - cap) + (handicap.tries[weaker] - 1) * 3 +
+           (handicap.firstSetter != 0 ? 1 : 0);
+}
+
+// The handicap closest to an even game for these two players. Only the stronger player is held
+// back and only the weaker one helped; `threads` solve in parallel (0: every hardware thread).
+inline HandicapResult balanceHandicap(const std::vector<std::vector<int>>& chances,
+                                      const std::vector<int>& difficulties, const RuleSet& rules,
+                                      int threads = 0) {
+    HandicapResult result;
+    result.evenChance = handicapWinChance(chances, difficulties, rules, Handicap());
+    result.weaker = result.evenChance < 0.5 ? 0 : 1;
+    const int weaker = result.weaker;
+    const int stronger = 1 - weaker;
+
+    // Caps worth trying are the difficulties of the tricks, hardest first
+    std::vector<int> caps(difficulties.begin(), difficulties.end());
+    std::sort(caps.begin(), caps.end());
+    caps.erase(std::unique(caps.begin(), caps.end()), caps.end());
+    std::reverse(caps.begin(), caps.end());
+    const int top = caps.empty() ? 0 : caps[0];
+
+    std::vector<Handicap> solves;
+    for (int cap : caps) {
+        for (int tries = 1; tries <= kMaxHandicapTries; tries++) {
+            Handicap handicap;
+            handicap.maxDifficulty[stronger] = cap;
+            handicap.tries[weaker] = tries;
+            solves.push_back(handicap);
+        }
+    }
+    std::vector<SolvedMatchup> solved(solves.size());
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = std::min(threads, static_cast<int>(solves.size()));
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < solves.size(); i = next++) {
+            solved[i] = solveHandicap(chances, difficulties, rules, solves[i]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+
+    // Read every head start and first setter off the tables, in a fixed order so the answer
+    // does not depend on the threads
+    result.handicap = Handicap();
+    result.winChance = result.evenChance;
+    result.solves = static_cast<int>(solves.size()) + 1;
+    result.evaluated = 0;
+    int bestWeight = 0;
+    for (size_t i = 0; i < solves.size(); i++) {
+        for (int letters = 0; letters < rules.letters(); letters++) {
+            // The second player setting first is a handicap only when they are the weaker one
+            for (int setter = 0; setter <= weaker; setter++) {
+                Handicap handicap = solves[i];
+                handicap.startLetters[stronger] = letters;
+                handicap.firstSetter = setter;
+                BotState start = {{handicap.startLetters[0], handicap.startLetters[1]}, setter};
+                double chance = solved[i].winChance(start);
+                int weight = handicapWeight(handicap, weaker, top);
+                double gap = std::fabs(chance - 0.5);
+                double bestGap = std::fabs(result.winChance - 0.5);
+                result.evaluated++;
+                if (gap < bestGap - 1e-9 || (gap < bestGap + 1e-9 && weight < bestWeight)) {
+                    result.handicap = handicap;
+                    result.winChance = chance;
+                    bestWeight = weight;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+#endif // SKATE_HANDICAP_H
@@ -0,0 +1,206 @@
+// Game of Skate - house rules
+// Rules made up by event organisers, read from a small text file:
+//
+//   # Friday night rules
+//   word = SKATE
+//   base = 95               # success formula: chance = base - difficulty * slope
+//   slope = 8
+//   last_letter_tries = 2   # tries to match for a responder one letter from losing
+//   setter_penalty = 1      # letters a setter takes for missing their own trick
+//   max_difficulty = 8      # harder tricks may not be set
+//   award = 7:2             # a missed trick of difficulty 7 or more hands out 2 letters
+//
+// A rules file is compiled once into flat tables: the next position for every position and
+// every way a round can end, the responder's tries in every position and the letters every
+// trick hands out. Playing a round is then a handful of array lookups, whatever rules are on.
+
+#ifndef SKATE_HOUSE_H
+#define SKATE_HOUSE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "skate_core.h"
+#include "skate_rules.h"
+
+// Longest word a rules file may use
+const int kMaxHouseLetters = 8;
+
+// Most letters a single missed trick may hand out
+const int kMaxHouseAward = 4;
+
+// Difficulties 0-10, the indices of HouseRules::award
+const int kHouseDifficulties = 11;
+
+struct HouseRules {
+    std::string word;
+    SuccessCurve curve;
+    int lastLetterTries;
+    int setterPenalty;
+    int maxDifficulty;
+    int award[kHouseDifficulties]; // letters handed out by a missed trick of each difficulty
+
+    HouseRules()
+        : word(RuleSet().word()), curve(kDefaultCurve), lastLetterTries(1), setterPenalty(0),
+          maxDifficulty(kHouseDifficulties - 1) {
+        std::fill(award, award + kHouseDifficulties, 1);
+    }
+};
+
+// One of the built-in variants written as house rules
+inline HouseRules houseRulesFor(const RuleSet& rules) {
+    HouseRules house;
+    house.word = rules.word();
+    house.curve = rules.info().curve;
+    house.lastLetterTries = rules.lastLetterRetry ? 2 : 1;
+    return house;
+}
+
+// Reads a rules file. Keys that are left out keep the SKATE defaults.
+inline bool loadHouseRules(std::istream& in, HouseRules& rules, std::string& error) {
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        size_t equals = line.find('=');
+        std::istringstream keyText(line.substr(0, equals));
+        std::string key;
+        if (!(keyText >> key)) {
+            continue;
+        }
+        std::istringstream valueText(equals == std::string::npos ? "" : line.substr(equals + 1));
+        std::string value;
+        valueText >> value;
+        if (value.empty()) {
+            error = "line " + std::to_string(lineNumber) + ": expected key = value";
+            return false;
+        }
+
+        int number = std::atoi(value.c_str());
+        bool ok = true;
+        if (key == "word") {
+            rules.word = value;
+            ok = !value.empty() && value.size() <= static_cast<size_t>(kMaxHouseLetters);
+        } else if (key == "base") {
+            rules.curve.base = number;
+        } else if (key == "slope") {
+            rules.curve.slope = number;
+        } else if (key == "last_letter_tries") {
+            rules.lastLetterTries = number;
+            ok = number >= 1 && number <= 10;
+        } else if (key == "setter_penalty") {
+            rules.setterPenalty = number;
+            ok = number >= 0 && number <= kMaxHouseLetters;
+        } else if (key == "max_difficulty") {
+            rules.maxDifficulty = number;
+            ok = number >= 1;
+        } else if (key == "award") {
+            size_t colon = value.find(':');
+            int from = std::atoi(value.substr(0, colon).c_str());
+            int letters = colon == std::string::npos ? 0 : std::atoi(value.substr(colon + 1).c_str());
+            ok = from >= 0 && from < kHouseDifficulties && letters >= 1 && letters <= kMaxHouseAward;
+            for (int d = from; ok && d < kHouseDifficulties; d++) {
+                rules.award[d] = letters;
+            }
+        } else {
+            error = "line " + std::to_string(lineNumber) + ": unknown rule " + key;
+            return false;
+        }
+        if (!ok) {
+            error = "line " + std::to_string(lineNumber) + ": bad value for " + key;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Columns of the transition table: how a round ended
+enum HouseEvent {
+    HOUSE_SETTER_MISSED = 0,
+    HOUSE_BOTH_LANDED = 1,
+    HOUSE_RESPONDER_MISSED = 2 // + letters handed out - 1
+};
+
+const int kHouseEvents = HOUSE_RESPONDER_MISSED + kMaxHouseAward;
+
+// Positions are numbered (letters0 * (letters + 1) + letters1) * 2 + setter
+struct CompiledRules {
+    std::string word;
+    int letters;
+    SuccessCurve curve;
+    std::vector<uint16_t> next;      // [position * kHouseEvents + event]
+    std::vector<uint8_t> tries;      // the responder's tries to match, per position
+    std::vector<int8_t> winner;      // per position: -1 while the game goes on
+    std::vector<BotState> positions; // letters and setter of every position
+    std::vector<int> tricks;         // every trick that may be set, as an index into the full list
+    std::vector<int16_t> slot;       // per trick of the full list: its index in tricks, or -1
+    std::vector<uint8_t> missEvent;  // event of a responder missing each of those tricks
+    std::vector<int> thresholds;     // landing threshold of every trick in the full list
+
+    int position(const BotState& state) const {
+        return (state.letters[0] * (letters + 1) + state.letters[1]) * 2 + state.setter;
+    }
+
+    int after(int position, int event) const {
+        return next[position * kHouseEvents + event];
+    }
+
+    // The settable trick a full-list index refers to, or -1
+    int settable(int trick) const {
+        return trick >= 0 && trick < static_cast<int>(slot.size()) ? slot[trick] : -1;
+    }
+};
+
+inline CompiledRules compileHouseRules(const HouseRules& rules, const TrickCatalog& catalog = kDefaultCatalog) {
+    CompiledRules compiled;
+    compiled.word = rules.word;
+    compiled.letters = static_cast<int>(rules.word.size());
+    compiled.curve = rules.curve;
+    const int full = compiled.letters;
+
+    for (int a = 0; a <= full; a++) {
+        for (int b = 0; b <= full; b++) {
+            for (int setter = 0; setter < 2; setter++) {
+                BotState state = {{a, b}, setter};
+                compiled.positions.push_back(state);
+            }
+        }
+    }
+    for (const BotState& state : compiled.positions) {
+        bool over = state.letters[0] >= full || state.letters[1] >= full;
+        int responder = 1 - state.setter;
+        compiled.winner.push_back(static_cast<int8_t>(over ? (state.letters[0] >= full ? 1 : 0) : -1));
+        compiled.tries.push_back(static_cast<uint8_t>(state.letters[responder] == full - 1 ? rules.lastLetterTries : 1));
+        for (int event = 0; event < kHouseEvents; event++) {
+            BotState next = state;
+            if (!over && event == HOUSE_SETTER_MISSED) {
+                next.letters[state.setter] = std::min(full, next.letters[state.setter] + rules.setterPenalty);
+                next.setter = responder;
+            } else if (!over && event >= HOUSE_RESPONDER_MISSED) {
+                int award = event - HOUSE_RESPONDER_MISSED + 1;
+                next.letters[responder] = std::min(full, next.letters[responder] + award);
+            }
+            compiled.next.push_back(static_cast<uint16_t>(compiled.position(next)));
+        }
+    }
+
+    for (size_t i = 0; i < catalog.size(); i++) {
+        compiled.thresholds.push_back(trickThreshold(catalog[i], rules.curve));
+        int difficulty = std::min(kHouseDifficulties - 1, std::max(0, catalog[i].difficulty));
+        bool allowed = catalog[i].difficulty <= rules.maxDifficulty;
+        compiled.slot.push_back(static_cast<int16_t>(allowed ? compiled.tricks.size() : -1));
+        if (allowed) {
+            compiled.tricks.push_back(static_cast<int>(i));
+            compiled.missEvent.push_back(static_cast<uint8_t>(HOUSE_RESPONDER_MISSED + rules.award[difficulty] - 1));
+        }
+    }
+    return compiled;
+}
+
+#endif // SKATE_HOUSE_H
@@ -0,0 +1,171 @@
+// Game of Skate - GUI latency
+// How long the GUI takes to show what a click did, and how long its event loop stops answering.
+//
+// The GUI tells the monitor when input arrives, when a frame has finished painting and when its
+// heartbeat timer fires. An input's latency runs from the input to the end of the next paint,
+// the first frame that can show its result. An input that changes nothing on screen has no such
+// frame: once a whole heartbeat has gone by after it without a paint it is dropped, so a later,
+// unrelated paint is not charged to it. The heartbeat is due every few milliseconds; one that
+// comes more than kStallMs late means the event loop was busy, and the delay is a stall.
+//
+// The latest kLatencySamples of each are kept for the overlay's percentiles, and every sample is
+// written to the log as it happens.
+//
+// C++11 and free of Qt, so the tests can drive it with made-up times.
+
+#ifndef SKATE_LATENCY_H
+#define SKATE_LATENCY_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ios>
+#include <ostream>
+#include <vector>
+
+// Samples kept of each kind
+const size_t kLatencySamples = 1024;
+// Heartbeat interval of the GUI
+const int kHeartbeatMs = 16;
+// A heartbeat later than this is a stall: about three frames without an answer
+const double kStallMs = 50.0;
+
+struct LatencySummary {
+    size_t count; // samples so far, kept or not
+    double last;  // all in milliseconds, over the kept samples
+    double median;
+    double p95;
+    double max;
+};
+
+// The latest samples, oldest overwritten first
+class LatencySamples {
+public:
+    LatencySamples() : count(0) {}
+
+    void add(double ms) {
+        if (samples.size() < kLatencySamples) {
+            samples.push_back(ms);
+        } else {
+            samples[count % kLatencySamples] = ms;
+        }
+        count++;
+    }
+
+    LatencySummary summary() const {
+        LatencySummary result = {count, 0.0, 0.0, 0.0, 0.0};
+        if (samples.empty()) {
+            return result;
+        }
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        result.last = samples[(count - 1) % kLatencySamples];
+        result.median = sorted[(sorted.size() - 1) / 2];
+        result.p95 = sorted[(sorted.size() - 1) * 95 / 100];
+        result.max = sorted.back();
+        return result;
+    }
+
+private:
+    std::vector<double> samples;
+    size_t count;
+};
+
+class LatencyMonitor {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    LatencyMonitor() : log(nullptr), start(Clock::now()), inputPending(false), haveBeat(false), dropped(0) {}
+
+    // Write every sample to `out` as "seconds<TAB>input|stall<TAB>milliseconds"
+    void logTo(std::ostream* out) {
+        log = out;
+    }
+
+    // Input arrived; the earliest input since the last paint is the one measured
+    void input(Clock::time_point at) {
+        if (!inputPending) {
+            pending = at;
+            inputPending = true;
+        }
+    }
+
+    // An input is waiting for its frame
+    bool waiting() const {
+        return inputPending;
+    }
+
+    // A frame finished painting; true if it ended an input's latency
+    bool painted(Clock::time_point at) {
+        if (!inputPending) {
+            return false;
+        }
+        inputPending = false;
+        double ms = millis(at - pending);
+        inputs.add(ms);
+        write(at, "input", ms);
+        return true;
+    }
+
+    // The heartbeat fired; true if it found a stall
+    bool heartbeat(Clock::time_point at) {
+        // The event loop got round to a whole beat since the input and painted nothing for it
+        if (inputPending && haveBeat && lastBeat >= pending) {
+            inputPending = false;
+            dropped++;
+        }
+        bool stalled = false;
+        if (haveBeat) {
+            double late = millis(at - lastBeat) - kHeartbeatMs;
+            if (late > kStallMs) {
+                stalls.add(late);
+                write(at, "stall", late);
+                stalled = true;
+            }
+        }
+        lastBeat = at;
+        haveBeat = true;
+        return stalled;
+    }
+
+    LatencySummary inputLatency() const {
+        return inputs.summary();
+    }
+
+    LatencySummary stallLength() const {
+        return stalls.summary();
+    }
+
+    // Inputs dropped because no frame followed them
+    size_t unpainted() const {
+        return dropped;
+    }
+
+private:
+    static double millis(Clock::duration span) {
+        return std::chrono::duration<double, std::milli>(span).count();
+    }
+
+    void write(Clock::time_point at, const char* kind, double ms) {
+        if (!log) {
+            return;
+        }
+        std::ios::fmtflags flags = log->flags(std::ios::fixed);
+        std::streamsize precision = log->precision(3);
+        *log << millis(at - start) / 1000.0 << '\t' << kind << '\t' << ms << '\n';
+        log->flags(flags);
+        log->precision(precision);
+    }
+
+    std::ostream* log;
+    Clock::time_point start;
+    Clock::time_point pending;
+    bool inputPending;
+    Clock::time_point lastBeat;
+    bool haveBeat;
+    size_t dropped;
+    LatencySamples inputs;
+    LatencySamples stalls;
+};
+
+#endif // SKATE_LATENCY_H
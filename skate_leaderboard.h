@@ -0,0 +1,349 @@
+// Game of Skate - ratings and leaderboard
+// Elo ratings for every player who finishes a game, ranked live.
+//
+// Games report results with report(), which only appends to a queue; a background thread
+// applies them, so a game never waits for the leaderboard. Ratings are whole numbers, so
+// the live table keeps players in a bucket per rating.
+//
+// Readers never touch the live table. The updater publishes snapshots: immutable, sorted
+// copies of the table, swapped in with an atomic shared_ptr store. rank(), rating() and pages
+// all read the latest snapshot, so a lookup never waits for results being applied, however
+// many have piled up, and every page of one snapshot shows the same moment. A snapshot is at
+// most kSnapshotInterval behind; flush() brings it up to date.
+//
+// Finding a player by name in a snapshot goes through a few name maps shared between
+// snapshots: each publish maps only the players who are new since the last one, and merges
+// maps of similar size, so there are O(log players) of them and publishing never rehashes
+// everyone.
+//
+// C++11, so the console game can use it.
+
+#ifndef SKATE_LEADERBOARD_H
+#define SKATE_LEADERBOARD_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const int kStartRating = 1500;
+
+// Most a single game can move a rating
+const int kEloK = 32;
+
+// Ratings are kept between 0 and this
+const int kMaxRating = 4095;
+
+// Longest a result waits before it shows up in the pages
+const std::chrono::milliseconds kSnapshotInterval(200);
+
+// Points the winner gains (and the loser loses) under Elo
+inline int eloChange(int winnerRating, int loserRating) {
+    double expected = 1.0 / (1.0 + std::pow(10.0, (loserRating - winnerRating) / 400.0));
+    return static_cast<int>(std::lround(kEloK * (1.0 - expected)));
+}
+
+struct LeaderboardRow {
+    const std::string* name; // lives as long as the leaderboard
+    int player;
+    int rating;
+    int games;
+    int wins;
+};
+
+typedef std::unordered_map<std::string, int> LeaderboardIds; // name to player number
+
+// The table at one moment, best first. Rows with the same rating share a rank.
+struct LeaderboardSnapshot {
+    std::vector<LeaderboardRow> rows;
+    long version; // counts up with every snapshot published
+    std::vector<int> rowOf; // row of every player number
+    std::vector<std::shared_ptr<const LeaderboardIds>> ids; // oldest players first
+
+    // Row of a player, or -1 for somebody who has not played
+    int find(const std::string& name) const {
+        for (size_t i = ids.size(); i-- > 0;) {
+            LeaderboardIds::const_iterator it = ids[i]->find(name);
+            if (it != ids[i]->end()) {
+                return rowOf[it->second];
+            }
+        }
+        return -1;
+    }
+
+    // Rank of the row at `index`: 1 + the rows rated higher
+    int rankAt(size_t index) const {
+        int rating = rows[index].rating;
+        auto first = std::lower_bound(rows.begin(), rows.end(), rating,
+                                      [](const LeaderboardRow& row, int r) { return row.rating > r; });
+        return static_cast<int>(first - rows.begin()) + 1;
+    }
+
+    // `count` rows starting at rank `first` (1 is the top)
+    std::vector<LeaderboardRow> page(size_t first, size_t count) const {
+        size_t from = std::min(rows.size(), first > 0 ? first - 1 : 0);
+        size_t to = std::min(rows.size(), from + count);
+        return std::vector<LeaderboardRow>(rows.begin() + from, rows.begin() + to);
+    }
+};
+
+class Leaderboard {
+public:
+    Leaderboard()
+        : version(0), applied(0), flushing(0), stop(false), buckets(kMaxRating + 1), mappedPlayers(0) {
+        std::shared_ptr<LeaderboardSnapshot> empty = std::make_shared<LeaderboardSnapshot>();
+        empty->version = 0;
+        snapshot = empty;
+        updater = std::thread([this]() { run(); });
+    }
+
+    ~Leaderboard() {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            stop = true;
+        }
+        queueReady.notify_one();
+        updater.join();
+    }
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // Records a finished game. Returns at once; the ratings change on the updater thread.
+    void report(const std::string& winner, const std::string& loser) {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            pending.push_back(Result{winner, loser});
+        }
+        queueReady.notify_one();
+    }
+
+    // Waits until every result reported so far is applied and in the latest snapshot
+    void flush() {
+        std::unique_lock<std::mutex> guard(queueLock);
+        long wanted = version + static_cast<long>(pending.size());
+        flushing++;
+        queueReady.notify_one();
+        caughtUp.wait(guard, [&]() { return applied >= wanted; });
+        flushing--;
+    }
+
+    // Rank of a player in the latest snapshot (1 is the top), or 0 for somebody not in it
+    int rank(const std::string& name) const {
+        std::shared_ptr<const LeaderboardSnapshot> table = latest();
+        int row = table->find(name);
+        return row < 0 ? 0 : table->rankAt(static_cast<size_t>(row));
+    }
+
+    int rating(const std::string& name) const {
+        std::shared_ptr<const LeaderboardSnapshot> table = latest();
+        int row = table->find(name);
+        return row < 0 ? kStartRating : table->rows[row].rating;
+    }
+
+    size_t playerCount() const {
+        return latest()->rows.size();
+    }
+
+    // The latest published table; page through it as long as needed
+    std::shared_ptr<const LeaderboardSnapshot> latest() const {
+        return std::atomic_load_explicit(&snapshot, std::memory_order_acquire);
+    }
+
+    // One line per player: name, rating, games, wins (tab separated)
+    void save(std::ostream& out) const {
+        std::shared_ptr<const LeaderboardSnapshot> table = latest();
+        for (const LeaderboardRow& row : table->rows) {
+            out << *row.name << '\t' << row.rating << '\t' << row.games << '\t' << row.wins << '\n';
+        }
+    }
+
+    // Adds the players of a saved table; call before reporting results
+    bool load(std::istream& in) {
+        std::string line;
+        std::lock_guard<std::mutex> writing(writeLock);
+        while (std::getline(in, line)) {
+            size_t a = line.find('\t');
+            size_t b = a == std::string::npos ? a : line.find('\t', a + 1);
+            size_t c = b == std::string::npos ? b : line.find('\t', b + 1);
+            if (c == std::string::npos) {
+                return false;
+            }
+            int player = playerId(line.substr(0, a));
+            setRating(player, std::atoi(line.c_str() + a + 1));
+            games[player] = std::atoi(line.c_str() + b + 1);
+            wins[player] = std::atoi(line.c_str() + c + 1);
+        }
+        publish();
+        return true;
+    }
+
+private:
+    struct Result {
+        std::string winner;
+        std::string loser;
+    };
+
+    void run() {
+        std::vector<Result> batch;
+        bool dirty = false; // results applied but not yet in a snapshot
+        auto lastPublished = std::chrono::steady_clock::now();
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(queueLock);
+                auto due = [&]() { return stop || !pending.empty() || (dirty && flushing > 0); };
+                if (dirty) {
+                    queueReady.wait_until(guard, lastPublished + kSnapshotInterval, due);
+                } else {
+                    queueReady.wait(guard, due);
+                }
+                if (stop && pending.empty() && !dirty) {
+                    return;
+                }
+                batch.swap(pending);
+                version += static_cast<long>(batch.size());
+            }
+            std::lock_guard<std::mutex> writing(writeLock);
+            for (const Result& result : batch) {
+                apply(result);
+                dirty = true;
+            }
+            batch.clear();
+
+            // Copying the table costs O(players), so busy periods share one snapshot
+            auto now = std::chrono::steady_clock::now();
+            bool waitedOn;
+            {
+                std::lock_guard<std::mutex> guard(queueLock);
+                waitedOn = flushing > 0 || stop;
+            }
+            if (dirty && (waitedOn || now - lastPublished >= kSnapshotInterval)) {
+                publish();
+                dirty = false;
+                lastPublished = now;
+                std::lock_guard<std::mutex> guard(queueLock);
+                applied = version;
+                caughtUp.notify_all();
+            }
+        }
+    }
+
+    void apply(const Result& result) {
+        int winner = playerId(result.winner);
+        int loser = playerId(result.loser);
+        int change = eloChange(ratings[winner], ratings[loser]);
+        setRating(winner, ratings[winner] + change);
+        setRating(loser, ratings[loser] - change);
+        games[winner]++;
+        games[loser]++;
+        wins[winner]++;
+    }
+
+    // Caller holds writeLock
+    int playerId(const std::string& name) {
+        std::unordered_map<std::string, int>::const_iterator it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        int player = static_cast<int>(ratings.size());
+        names.push_back(name);
+        ids[name] = player;
+        ratings.push_back(-1);
+        games.push_back(0);
+        wins.push_back(0);
+        slots.push_back(0);
+        setRating(player, kStartRating);
+        return player;
+    }
+
+    // Moves a player to another rating bucket; caller holds writeLock
+    void setRating(int player, int rating) {
+        rating = std::min(kMaxRating, std::max(0, rating));
+        int old = ratings[player];
+        if (old == rating) {
+            return;
+        }
+        if (old >= 0) {
+            std::vector<int>& from = buckets[old];
+            int moved = from.back();
+            from[slots[player]] = moved;
+            slots[moved] = slots[player];
+            from.pop_back();
+        }
+        slots[player] = static_cast<int>(buckets[rating].size());
+        buckets[rating].push_back(player);
+        ratings[player] = rating;
+    }
+
+    // Copies the table into a new snapshot, best first, by walking the buckets from the top.
+    // Caller holds writeLock; only the updater and load() publish.
+    void publish() {
+        std::shared_ptr<const LeaderboardSnapshot> previous = latest();
+        std::shared_ptr<LeaderboardSnapshot> next = std::make_shared<LeaderboardSnapshot>();
+        next->rows.reserve(ratings.size());
+        next->rowOf.resize(ratings.size());
+        for (int rating = kMaxRating; rating >= 0; rating--) {
+            for (int player : buckets[rating]) {
+                LeaderboardRow row = {&names[player], player, rating, games[player], wins[player]};
+                next->rowOf[player] = static_cast<int>(next->rows.size());
+                next->rows.push_back(row);
+            }
+        }
+
+        // Players new since the last snapshot get a name map of their own, merged with the
+        // newest maps while those are no more than twice its size
+        next->ids = previous->ids;
+        if (mappedPlayers < names.size()) {
+            LeaderboardIds fresh;
+            for (size_t player = mappedPlayers; player < names.size(); player++) {
+                fresh[names[player]] = static_cast<int>(player);
+            }
+            while (!next->ids.empty() && next->ids.back()->size() <= 2 * fresh.size()) {
+                fresh.insert(next->ids.back()->begin(), next->ids.back()->end());
+                next->ids.pop_back();
+            }
+            next->ids.push_back(std::make_shared<const LeaderboardIds>(std::move(fresh)));
+            mappedPlayers = names.size();
+        }
+        next->version = previous->version + 1;
+        std::atomic_store_explicit(&snapshot, std::shared_ptr<const LeaderboardSnapshot>(next),
+                                   std::memory_order_release);
+    }
+
+    // Queue of reported results
+    std::mutex queueLock;
+    std::condition_variable queueReady;
+    std::condition_variable caughtUp;
+    std::vector<Result> pending;
+    long version; // results taken off the queue
+    long applied; // results applied and published
+    int flushing; // threads waiting in flush()
+    bool stop;
+
+    // Live table: only the updater and load() touch it, one at a time under writeLock
+    std::mutex writeLock;
+    std::deque<std::string> names; // a deque, so snapshots can point at names
+    std::unordered_map<std::string, int> ids;
+    std::vector<int> ratings;
+    std::vector<int> games;
+    std::vector<int> wins;
+    std::vector<int> slots;              // index of each player in their bucket
+    std::vector<std::vector<int>> buckets; // players by rating
+    size_t mappedPlayers;                  // players in the snapshots' name maps
+
+    std::shared_ptr<const LeaderboardSnapshot> snapshot; // read and swapped atomically only
+
+    std::thread updater;
+};
+
+#endif // SKATE_LEADERBOARD_H
@@ -0,0 +1,129 @@
+// Game of Skate - live trick odds
+// The setter's exact chance of winning with every trick, kept up to date for the GUI's odds panel.
+//
+// A background thread solves the matchup once per game (the part that grows with the catalog
+// times the positions) and then, whenever the position changes, works out every trick's chance
+// from the solved values, kOddsChunkTricks tricks at a time. Each chunk is handed over as soon
+// as it is ready, tagged with the request it answers. A newer request makes the thread drop the
+// rest of an older one, so the panel only ever fills in for the position on the table.
+
+#ifndef SKATE_ODDS_H
+#define SKATE_ODDS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "skate_bot.h"
+#include "skate_rules.h"
+#include "skate_solver.h"
+#include "skate_trace.h"
+
+// Tricks worked out between two handovers
+const size_t kOddsChunkTricks = 256;
+
+class TrickOddsWorker {
+public:
+    // Called on the worker thread with the setter's chances of tricks first, first + 1, ...
+    typedef std::function<void(long request, size_t first, const std::vector<double>& chances)> Deliver;
+
+    explicit TrickOddsWorker(Deliver handover)
+        : deliver(handover), takeTurns(false), newMatchup(false), taken(0), stop(false), requested(0) {
+        worker = std::thread([this]() { run(); });
+    }
+
+    ~TrickOddsWorker() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+        }
+        ready.notify_one();
+        worker.join();
+    }
+
+    TrickOddsWorker(const TrickOddsWorker&) = delete;
+    TrickOddsWorker& operator=(const TrickOddsWorker&) = delete;
+
+    // A new game: chances[player][trick] in percent. Solved with the next request.
+    void setMatchup(const std::vector<std::vector<int>>& matchup, const RuleSet& ruleSet, bool turns) {
+        std::lock_guard<std::mutex> guard(lock);
+        chances = matchup;
+        rules = ruleSet;
+        takeTurns = turns;
+        newMatchup = true;
+    }
+
+    // Asks for the odds of every trick in `state`; returns the number its chunks will carry
+    long request(const BotState& state) {
+        long id;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            position = state;
+            id = ++requested;
+        }
+        ready.notify_one();
+        return id;
+    }
+
+private:
+    void run() {
+        SKATE_TRACE_THREAD("odds");
+        std::vector<std::vector<int>> solvedChances;
+        SolvedMatchup solved;
+        while (true) {
+            BotState state;
+            long id;
+            bool solve;
+            RuleSet solveRules;
+            bool solveTurns;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                ready.wait(guard, [&]() { return stop || taken != requested; });
+                if (stop) {
+                    return;
+                }
+                state = position;
+                id = taken = requested;
+                solve = newMatchup;
+                if (solve) {
+                    solvedChances.swap(chances);
+                    solveRules = rules;
+                    solveTurns = takeTurns;
+                    newMatchup = false;
+                }
+            }
+            if (solve) {
+                SKATE_TRACE_SCOPE("solve matchup");
+                solved = solveMatchup(solvedChances, solveRules, solveTurns);
+            }
+            if (solvedChances.size() < 2) {
+                continue;
+            }
+            size_t tricks = solvedChances[state.setter].size();
+            for (size_t first = 0; first < tricks && requested == id; first += kOddsChunkTricks) {
+                SKATE_TRACE_SCOPE("odds chunk");
+                deliver(id, first, trickWinChances(solvedChances, solved, state, first, kOddsChunkTricks));
+            }
+        }
+    }
+
+    Deliver deliver;
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::vector<std::vector<int>> chances; // the next matchup to solve
+    RuleSet rules;
+    bool takeTurns;
+    bool newMatchup;
+    BotState position; // of the latest request
+    long taken;        // latest request the worker started on
+    bool stop;
+    std::atomic<long> requested; // read without the lock to drop outdated work
+
+    std::thread worker;
+};
+
+#endif // SKATE_ODDS_H
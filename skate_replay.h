@@ -0,0 +1,363 @@
+// Game of Skate - replays
+// Everything needed to rebuild a two-player game round by round, to settle disputed results.
+//
+// Games roll their dice with replayRoll(seed, attempt): the roll of an attempt depends only on
+// the game's seed and the attempt's number, so any attempt can be rolled again on its own. A
+// replay keeps the seed, the rules, both players' chances, the trick set in every round with
+// how each attempt went, and every kReplayCheckpointInterval rounds a checkpoint of where the
+// game stood (a position in the compiled rules table and the attempt count, ten bytes). Any
+// round is reached from the checkpoint before it in at most that many steps.
+//
+// Verifying a replay plays it again from the start: every roll must give the recorded
+// outcome, every round must take the attempts the rules allow, and the checkpoints and the
+// winner must match. verifyReplays() checks a whole file of replays on all cores.
+//
+// Replay file: one block of lines per game,
+//   skate-replay <seed> <first setter> <winner, or -1>
+//   players <name 1> TAB <name 2>
+//   rules <word> <base> <slope> <last letter tries> <setter penalty> <max difficulty> <award 0> ... <award 10>
+//   chances <chance of player 1 on trick 0> ... (then the same line for player 2)
+//   rounds <trick>:<L or M for every attempt> ...
+//   checkpoints <round>:<attempt>:<position> ...
+//   end
+//
+// C++11, so the console game can use it.
+
+#ifndef SKATE_REPLAY_H
+#define SKATE_REPLAY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skate_core.h"
+#include "skate_house.h"
+
+// Rounds between checkpoints
+const int kReplayCheckpointInterval = 8;
+
+// Most attempts one round can take: the setter's and the responder's tries
+const int kReplayMaxRolls = 11;
+
+// Roll (1-100) of attempt number `attempt` of the game with `seed`: the same number SimRng(seed)
+// gives on its attempt + 1-th roll, worked out without the rolls before it
+inline int replayRoll(uint64_t seed, uint64_t attempt) {
+    uint64_t z = seed + (attempt + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return 1 + static_cast<int>(((z >> 32) * 100ULL) >> 32);
+}
+
+struct ReplayRound {
+    TrickId trick;
+    uint8_t rolls;  // attempts made: the setter's, then the responder's
+    uint16_t landed; // bit i: attempt i landed
+};
+
+// Where a game stood at the start of a round
+struct ReplayCheckpoint {
+    uint32_t round;
+    uint32_t attempt; // attempts made before the round
+    uint16_t position; // in the compiled rules table
+};
+
+struct Replay {
+    uint64_t seed;
+    int firstSetter;
+    int winner; // -1 if the game was not finished
+    std::string names[2];
+    HouseRules rules;
+    std::vector<int> chances[2]; // percent, per trick of the full list
+    std::vector<ReplayRound> rounds;
+    std::vector<ReplayCheckpoint> checkpoints;
+
+    Replay() : seed(0), firstSetter(0), winner(-1) {}
+};
+
+// Adds a round played from `position` with `attempt` attempts made before it
+inline void recordRound(Replay& replay, int position, uint32_t attempt, TrickId trick, int rolls, int landed) {
+    if (replay.rounds.size() % kReplayCheckpointInterval == 0) {
+        ReplayCheckpoint checkpoint = {static_cast<uint32_t>(replay.rounds.size()), attempt,
+                                       static_cast<uint16_t>(position)};
+        replay.checkpoints.push_back(checkpoint);
+    }
+    ReplayRound round = {trick, static_cast<uint8_t>(rolls), static_cast<uint16_t>(landed)};
+    replay.rounds.push_back(round);
+}
+
+// How a recorded round ended, as a column of the rules table
+inline int roundEvent(const CompiledRules& table, const ReplayRound& round) {
+    if (!(round.landed & 1)) {
+        return HOUSE_SETTER_MISSED;
+    }
+    if (round.landed >> 1) {
+        return HOUSE_BOTH_LANDED;
+    }
+    int slot = table.settable(round.trick);
+    return slot >= 0 ? static_cast<int>(table.missEvent[slot]) : static_cast<int>(HOUSE_BOTH_LANDED);
+}
+
+struct ReplayState {
+    uint32_t round;   // rounds played
+    uint32_t attempt; // attempts made
+    int position;     // in the compiled rules table
+};
+
+// Where the game stood at the start of `round` (rounds.size() for the end): from the
+// checkpoint before it, at most kReplayCheckpointInterval rounds are stepped through
+inline ReplayState seekReplay(const Replay& replay, const CompiledRules& table, uint32_t round) {
+    round = std::min(round, static_cast<uint32_t>(replay.rounds.size()));
+    ReplayState state = {0, 0, table.position(BotState{{0, 0}, replay.firstSetter})};
+    size_t index = std::min<size_t>(round / kReplayCheckpointInterval, replay.checkpoints.size());
+    if (index > 0 && replay.checkpoints[index - 1].round <= round) {
+        const ReplayCheckpoint& checkpoint = replay.checkpoints[index - 1];
+        state.round = checkpoint.round;
+        state.attempt = checkpoint.attempt;
+        state.position = checkpoint.position;
+    }
+    for (; state.round < round; state.round++) {
+        const ReplayRound& played = replay.rounds[state.round];
+        state.attempt += played.rolls;
+        state.position = table.after(state.position, roundEvent(table, played));
+    }
+    return state;
+}
+
+struct ReplayVerdict {
+    bool ok;
+    int round;           // first round that does not add up, or -1
+    std::string problem;
+};
+
+inline ReplayVerdict replayProblem(int round, const std::string& problem) {
+    ReplayVerdict verdict = {false, round, problem};
+    return verdict;
+}
+
+// Plays the replay again from the start and checks every roll, round, checkpoint and the winner
+inline ReplayVerdict verifyReplay(const Replay& replay, const CompiledRules& table) {
+    for (int p = 0; p < 2; p++) {
+        if (replay.chances[p].size() < table.thresholds.size()) {
+            return replayProblem(-1, "missing chances");
+        }
+    }
+    ReplayState state = {0, 0, table.position(BotState{{0, 0}, replay.firstSetter})};
+    size_t checkpoint = 0;
+    for (; state.round < replay.rounds.size(); state.round++) {
+        int round = static_cast<int>(state.round);
+        if (table.winner[state.position] >= 0) {
+            return replayProblem(round, "played after the game was over");
+        }
+        if (state.round % kReplayCheckpointInterval == 0) {
+            if (checkpoint >= replay.checkpoints.size()) {
+                return replayProblem(round, "missing checkpoint");
+            }
+            const ReplayCheckpoint& saved = replay.checkpoints[checkpoint++];
+            if (saved.round != state.round || saved.attempt != state.attempt || saved.position != state.position) {
+                return replayProblem(round, "checkpoint does not match");
+            }
+        }
+        const ReplayRound& played = replay.rounds[state.round];
+        if (table.settable(played.trick) < 0) {
+            return replayProblem(round, "trick not allowed");
+        }
+        const BotState& at = table.positions[state.position];
+        int setter = at.setter;
+        int tries = table.tries[state.position];
+        int landed = 0;
+        int rolls = 0;
+        // The setter once; if they land it, the responder until they land it or run out of tries
+        do {
+            int player = rolls == 0 ? setter : 1 - setter;
+            if (replayRoll(replay.seed, state.attempt + rolls) <= replay.chances[player][played.trick]) {
+                landed |= 1 << rolls;
+            }
+            rolls++;
+        } while ((landed & 1) && !(landed >> 1) && rolls <= tries);
+        if (rolls != played.rolls || landed != played.landed) {
+            return replayProblem(round, "attempts do not match the dice");
+        }
+        state.attempt += played.rolls;
+        state.position = table.after(state.position, roundEvent(table, played));
+    }
+    if (checkpoint != replay.checkpoints.size()) {
+        return replayProblem(-1, "extra checkpoints");
+    }
+    if (table.winner[state.position] != replay.winner) {
+        return replayProblem(-1, "wrong winner");
+    }
+    ReplayVerdict verdict = {true, -1, ""};
+    return verdict;
+}
+
+inline ReplayVerdict verifyReplay(const Replay& replay) {
+    return verifyReplay(replay, compileHouseRules(replay.rules));
+}
+
+// Verdicts for many replays, checked by `threads` threads (0: every hardware thread)
+inline std::vector<ReplayVerdict> verifyReplays(const std::vector<Replay>& replays, int threads = 0) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = static_cast<int>(std::min<size_t>(static_cast<size_t>(threads), std::max<size_t>(1, replays.size())));
+    std::vector<ReplayVerdict> verdicts(replays.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        // A day of games mostly shares a few rule sets: compile each one once per thread
+        HouseRules compiledFor;
+        CompiledRules table = compileHouseRules(compiledFor);
+        for (size_t i = next++; i < replays.size(); i = next++) {
+            const HouseRules& rules = replays[i].rules;
+            if (rules.word != compiledFor.word || rules.curve.base != compiledFor.curve.base ||
+                rules.curve.slope != compiledFor.curve.slope || rules.lastLetterTries != compiledFor.lastLetterTries ||
+                rules.setterPenalty != compiledFor.setterPenalty || rules.maxDifficulty != compiledFor.maxDifficulty ||
+                !std::equal(rules.award, rules.award + kHouseDifficulties, compiledFor.award)) {
+                compiledFor = rules;
+                table = compileHouseRules(compiledFor);
+            }
+            verdicts[i] = verifyReplay(replays[i], table);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    return verdicts;
+}
+
+inline void saveReplay(std::ostream& out, const Replay& replay) {
+    const HouseRules& rules = replay.rules;
+    out << "skate-replay " << replay.seed << ' ' << replay.firstSetter << ' ' << replay.winner << '\n';
+    out << "players " << replay.names[0] << '\t' << replay.names[1] << '\n';
+    out << "rules " << rules.word << ' ' << rules.curve.base << ' ' << rules.curve.slope << ' ' << rules.lastLetterTries
+        << ' ' << rules.setterPenalty << ' ' << rules.maxDifficulty;
+    for (int d = 0; d < kHouseDifficulties; d++) {
+        out << ' ' << rules.award[d];
+    }
+    out << '\n';
+    for (int p = 0; p < 2; p++) {
+        out << "chances";
+        for (size_t t = 0; t < replay.chances[p].size(); t++) {
+            out << ' ' << replay.chances[p][t];
+        }
+        out << '\n';
+    }
+    out << "rounds";
+    for (size_t r = 0; r < replay.rounds.size(); r++) {
+        out << ' ' << replay.rounds[r].trick << ':';
+        for (int a = 0; a < replay.rounds[r].rolls; a++) {
+            out << ((replay.rounds[r].landed >> a) & 1 ? 'L' : 'M');
+        }
+    }
+    out << "\ncheckpoints";
+    for (size_t c = 0; c < replay.checkpoints.size(); c++) {
+        const ReplayCheckpoint& checkpoint = replay.checkpoints[c];
+        out << ' ' << checkpoint.round << ':' << checkpoint.attempt << ':' << checkpoint.position;
+    }
+    out << "\nend\n";
+}
+
+// Reads the next replay of a file; false at the end of the file or on a damaged replay.
+// Replays settle disputes, so a hand-edited one is refused if any number in it would lead
+// outside the catalog or the rules table; whether it is a game that was played is then up to
+// verifyReplay().
+inline bool loadReplay(std::istream& in, Replay& replay) {
+    replay = Replay();
+    std::string line;
+    std::string key;
+    std::vector<unsigned long> positions; // of the checkpoints, as written
+    while (std::getline(in, line) && line.empty()) {
+    }
+    std::istringstream head(line);
+    if (!(head >> key >> replay.seed >> replay.firstSetter >> replay.winner) || key != "skate-replay" ||
+        replay.firstSetter < 0 || replay.firstSetter > 1 || replay.winner < -1 || replay.winner > 1) {
+        return false;
+    }
+    while (std::getline(in, line) && line != "end") {
+        std::istringstream fields(line);
+        fields >> key;
+        if (key == "players") {
+            size_t tab = line.find('\t');
+            if (tab == std::string::npos) {
+                return false;
+            }
+            replay.names[0] = line.substr(8, tab - 8);
+            replay.names[1] = line.substr(tab + 1);
+        } else if (key == "rules") {
+            HouseRules& rules = replay.rules;
+            fields >> rules.word >> rules.curve.base >> rules.curve.slope >> rules.lastLetterTries >>
+                rules.setterPenalty >> rules.maxDifficulty;
+            for (int d = 0; d < kHouseDifficulties; d++) {
+                fields >> rules.award[d];
+            }
+            if (!fields || rules.word.empty() || rules.word.size() > static_cast<size_t>(kMaxHouseLetters) ||
+                rules.lastLetterTries < 1 || rules.lastLetterTries >= kReplayMaxRolls || rules.setterPenalty < 0 ||
+                rules.setterPenalty > kMaxHouseLetters) {
+                return false;
+            }
+            for (int d = 0; d < kHouseDifficulties; d++) {
+                if (rules.award[d] < 1 || rules.award[d] > kMaxHouseAward) {
+                    return false;
+                }
+            }
+        } else if (key == "chances") {
+            std::vector<int>& chances = replay.chances[replay.chances[0].empty() ? 0 : 1];
+            int chance;
+            while (fields >> chance) {
+                chances.push_back(chance);
+            }
+        } else if (key == "rounds") {
+            std::string token;
+            while (fields >> token) {
+                size_t colon = token.find(':');
+                size_t rolls = colon == std::string::npos ? 0 : token.size() - colon - 1;
+                int trick = std::atoi(token.c_str());
+                if (rolls < 1 || rolls > static_cast<size_t>(kReplayMaxRolls) || trick < 0 ||
+                    trick >= static_cast<int>(kDefaultCatalog.size())) {
+                    return false;
+                }
+                ReplayRound round = {static_cast<TrickId>(trick), static_cast<uint8_t>(rolls), 0};
+                for (size_t a = 0; a < rolls; a++) {
+                    round.landed |= static_cast<uint16_t>((token[colon + 1 + a] == 'L' ? 1 : 0) << a);
+                }
+                replay.rounds.push_back(round);
+            }
+        } else if (key == "checkpoints") {
+            unsigned long round;
+            unsigned long attempt;
+            unsigned long position;
+            char colon;
+            while (fields >> round >> colon >> attempt >> colon >> position) {
+                if (round > UINT32_MAX || attempt > UINT32_MAX) {
+                    return false;
+                }
+                ReplayCheckpoint checkpoint = {static_cast<uint32_t>(round), static_cast<uint32_t>(attempt),
+                                               static_cast<uint16_t>(position)};
+                replay.checkpoints.push_back(checkpoint);
+                positions.push_back(position);
+            }
+        }
+    }
+    // Checks that need the rules, which may come after the checkpoints
+    size_t tablePositions = (replay.rules.word.size() + 1) * (replay.rules.word.size() + 1) * 2;
+    for (size_t c = 0; c < positions.size(); c++) {
+        if (positions[c] >= tablePositions) {
+            return false;
+        }
+    }
+    return line == "end";
+}
+
+#endif // SKATE_REPLAY_H
@@ -0,0 +1,129 @@
+// Game of Skate - rule variants
+// The word that spells a loss (SKATE, HORSE, PIG), the success formula and the optional
+// "two tries on the last letter" rule.
+//
+// Every variant is also a compile-time Rules type, so the simulator runs a loop made for it:
+// the word length is a constant and the second-try check is compiled out when the rule is off.
+// The curve is not: players' chances come into the loop already worked out (trickThreshold). withRules() picks the instantiation that matches a RuleSet chosen at runtime.
+
+#ifndef SKATE_RULES_H
+#define SKATE_RULES_H
+
+#include <string>
+
+#include "skate_core.h"
+
+struct RuleVariant {
+    const char* name;
+    const char* word;
+    int letters; // length of word
+    SuccessCurve curve;
+};
+
+// Add a variant by adding a row here; everything else picks it up
+constexpr RuleVariant kRuleVariants[] = {
+    {"skate", "SKATE", 5, {95, 8}},
+    {"horse", "HORSE", 5, {95, 8}},
+    {"pig", "PIG", 3, {95, 8}},
+};
+
+constexpr int kRuleVariantCount = sizeof(kRuleVariants) / sizeof(kRuleVariants[0]);
+
+constexpr int longestWord(int from = 0) {
+    return from == kRuleVariantCount ? 0
+        : (kRuleVariants[from].letters > longestWord(from + 1) ? kRuleVariants[from].letters : longestWord(from + 1));
+}
+
+// Most letters any variant needs, for fixed-size tables
+constexpr int kMaxRuleLetters = longestWord();
+
+// Rules chosen at runtime
+struct RuleSet {
+    int variant;          // index into kRuleVariants
+    bool lastLetterRetry; // a responder on their last letter gets a second try
+
+    RuleSet() : variant(0), lastLetterRetry(false) {}
+
+    const RuleVariant& info() const {
+        return kRuleVariants[variant];
+    }
+
+    int letters() const {
+        return kRuleVariants[variant].letters;
+    }
+
+    std::string word() const {
+        return kRuleVariants[variant].word;
+    }
+
+    std::string name() const {
+        return std::string(kRuleVariants[variant].name) + (lastLetterRetry ? ":retry" : "");
+    }
+
+    // Is the responder one letter from losing and allowed a second try?
+    bool secondTry(int responderLetters) const {
+        return lastLetterRetry && responderLetters == letters() - 1;
+    }
+};
+
+// Parses a variant name, optionally followed by ":retry", e.g. "pig" or "skate:retry"
+inline bool parseRuleSet(const std::string& text, RuleSet& rules) {
+    std::string name = text;
+    rules.lastLetterRetry = false;
+    size_t colon = text.find(':');
+    if (colon != std::string::npos) {
+        if (text.substr(colon + 1) != "retry") {
+            return false;
+        }
+        name = text.substr(0, colon);
+        rules.lastLetterRetry = true;
+    }
+    for (int i = 0; i < kRuleVariantCount; i++) {
+        if (name == kRuleVariants[i].name) {
+            rules.variant = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The same rules as compile-time constants
+template <int Variant, bool LastLetterRetry>
+struct Rules {
+    static constexpr int kVariant = Variant;
+    static constexpr int kLetters = kRuleVariants[Variant].letters;
+    static constexpr bool kLastLetterRetry = LastLetterRetry;
+
+    static constexpr bool secondTry(int responderLetters) {
+        return kLastLetterRetry && responderLetters == kLetters - 1;
+    }
+};
+
+typedef Rules<0, false> SkateRules;
+
+template <int Variant>
+struct RuleDispatch {
+    template <typename Visitor>
+    static auto visit(const RuleSet& rules, Visitor& visitor) -> decltype(visitor(SkateRules())) {
+        if (rules.variant == Variant) {
+            return rules.lastLetterRetry ? visitor(Rules<Variant, true>()) : visitor(Rules<Variant, false>());
+        }
+        return RuleDispatch<Variant + 1>::visit(rules, visitor);
+    }
+};
+
+template <>
+struct RuleDispatch<kRuleVariantCount> {
+    template <typename Visitor>
+    static auto visit(const RuleSet&, Visitor& visitor) -> decltype(visitor(SkateRules())) {
+        return visitor(SkateRules());
+    }
+};
+
+// Calls visitor(Rules<...>()) with the compile-time rules matching `rules`
+template <typename Visitor>
+auto withRules(const RuleSet& rules, Visitor visitor) -> decltype(visitor(SkateRules())) {
+    return RuleDispatch<0>::visit(rules, visitor);
+}
+
+#endif // SKATE_RULES_H
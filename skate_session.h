@@ -0,0 +1,102 @@
+// Game of Skate - sessions with more than two skaters
+// A jam: skaters take turns setting in a fixed rotation. The setter keeps setting until they
+// miss their own trick, and then the next skater still in takes over. When the setter lands,
+// every other skater still in tries to match it in rotation order and takes a letter on a miss.
+// Spelling the whole word knocks a skater out; the last one standing wins. With two skaters
+// this is exactly the game Game::playRound plays.
+//
+// A position is a bitmask of the skaters still in plus their letter counts packed four bits
+// each, so even a 32-skater session fits in 24 bytes and copies like a couple of integers.
+
+#ifndef SKATE_SESSION_H
+#define SKATE_SESSION_H
+
+#include <bitset>
+#include <cstdint>
+
+// Most skaters in one session: one bit each in SessionState::active
+const int kMaxSessionPlayers = 32;
+
+// Most letters a word may have in a session: four bits per skater
+const int kMaxSessionLetters = 15;
+
+struct SessionState {
+    uint32_t active;     // bit i: skater i is still in
+    uint64_t letters[2]; // 4 bits per skater: skaters 0-15 in [0], 16-31 in [1]
+    int setter;
+
+    bool isActive(int player) const {
+        return (active >> player) & 1u;
+    }
+
+    int lettersOf(int player) const {
+        return static_cast<int>((letters[player >> 4] >> ((player & 15) * 4)) & 15u);
+    }
+
+    void setLetters(int player, int count) {
+        int shift = (player & 15) * 4;
+        letters[player >> 4] = (letters[player >> 4] & ~(15ULL << shift)) | (static_cast<uint64_t>(count) << shift);
+    }
+
+    int remaining() const {
+        return static_cast<int>(std::bitset<kMaxSessionPlayers>(active).count());
+    }
+
+    bool isOver() const {
+        return remaining() <= 1;
+    }
+
+    // The last skater standing, or -1 while the session goes on
+    int winner() const {
+        if (!isOver() || active == 0) {
+            return -1;
+        }
+        int player = 0;
+        while (!isActive(player)) {
+            player++;
+        }
+        return player;
+    }
+
+    // The next skater still in after `player` in the rotation, or -1 if there is none
+    int nextActive(int player) const {
+        for (int step = 1; step <= kMaxSessionPlayers; step++) {
+            int next = (player + step) % kMaxSessionPlayers;
+            if (isActive(next)) {
+                return next;
+            }
+        }
+        return -1;
+    }
+};
+
+inline SessionState startSession(int players, int firstSetter = 0) {
+    uint32_t active = players >= kMaxSessionPlayers ? 0xFFFFFFFFu : (1u << players) - 1u;
+    SessionState state = {active, {0, 0}, firstSetter};
+    return state;
+}
+
+// Hands `count` letters to a skater; spelling the whole word of `word` letters knocks them out
+inline SessionState addLetters(SessionState state, int player, int count, int word) {
+    int letters = state.lettersOf(player) + count;
+    if (letters >= word) {
+        letters = word;
+        state.active &= ~(1u << player);
+    }
+    state.setLetters(player, letters);
+    return state;
+}
+
+// The setter missed their own trick: they take `penalty` letters and the next skater sets
+inline SessionState setterMissed(SessionState state, int penalty, int word) {
+    int next = state.nextActive(state.setter);
+    if (penalty > 0) {
+        state = addLetters(state, state.setter, penalty, word);
+    }
+    if (next >= 0) {
+        state.setter = next;
+    }
+    return state;
+}
+
+#endif // SKATE_SESSION_H
@@ -0,0 +1,500 @@
+// Game of Skate - simulation driver
+// Estimates matchup odds from simulated games, without anybody at the keyboard.
+//
+// Usage:
+//   skate_sim estimate [options]            chance that player 1 wins
+//   skate_sim compare --vs STRATEGY [opts]  how much player 1 gains with --p1 instead of --vs
+//   skate_sim sweep [sweep options] [opts]  try many success formulas, both players using --p1
+//   skate_sim solve [--state A:B:S] [opts]   exact chance that player 1 wins when both play perfectly
+//   skate_sim session [--skaters N] [opts]   share of sessions each of N skaters wins (see skate_session.h)
+//   skate_sim handicap [opts]                the handicap that makes the game closest to 50/50 (see skate_handicap.h)
+//
+// Options:
+//   --games N            games to simulate (default 100000, or at most 1e9 with --precision)
+//   --precision P        stop once the answer (for session, every skater's share) is known to +/- P, e.g. 0.002
+//   --confidence C       confidence level of the reported interval (default 0.95)
+//   --p1 STRATEGY        how player 1 sets tricks: random, greedy, safest or trick:N (default greedy)
+//   --p2 STRATEGY        the same for player 2
+//   --skill FILE         use a fitted skill model ...
+//   --players A B        ... for these two players
+//   --plain              plain Monte Carlo (no antithetic games, no control variates)
+//   --no-antithetic      turn off antithetic games
+//   --no-control         turn off the control variates
+//   --seed N             random seed (default 1)
+//   --threads N          worker threads (default: all hardware threads)
+//   --pin                pin every worker to its own CPU, spread over the NUMA nodes (Linux)
+//   --workers            show every worker's CPU, node and throughput
+//   --trace FILE         write a Chrome trace of the simulation batches (needs -DSKATE_TRACE, see skate_trace.h)
+//   --rules R            skate, horse or pig, with :retry for two tries on the last letter (default skate)
+//   --house FILE         play by the house rules in FILE (see skate_house.h) instead of --rules
+//   --cache FILE         reuse earlier estimate and solve results stored in FILE, and add new ones
+//   --state A:B:S        solve from A letters for player 1, B for player 2, player S (1 or 2) setting
+//   --skaters N|A,B,...  session: N skaters on the difficulty formula, or these named ones (default 4);
+//                        all of them set tricks like --p1
+//
+// Sweep options (ranges are FROM:TO:STEP, or a single value):
+//   --base R             base of the success formula (default 95)
+//   --slope R            chance lost per difficulty point (default 8)
+//   --scale R            top of the difficulty scale (default 10)
+//   --lhs N              N Latin hypercube points in the ranges instead of the full grid
+//   --out FILE           write the results table as CSV (default: standard output)
+//   --games and --precision apply to each point; the default is 20000 games per point
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+
+#include "skate_core.h"
+#include "skate_skill.h"
+#include "skate_sim.h"
+#include "skate_sweep.h"
+#include "skate_solver.h"
+#include "skate_cache.h"
+#include "skate_handicap.h"
+#include "skate_trace.h"
+
+void printUsage() {
+    std::cout << "Usage: skate_sim estimate|compare [--games N] [--precision P] [--confidence C]" << std::endl;
+    std::cout << "                 [--p1 STRATEGY] [--p2 STRATEGY]" << std::endl;
+    std::cout << "                 [--vs STRATEGY] [--skill FILE --players A B] [--plain]" << std::endl;
+    std::cout << "                 [--no-antithetic] [--no-control] [--seed N] [--threads N]" << std::endl;
+    std::cout << "       any simulation: [--pin] [--workers] [--trace FILE]" << std::endl;
+    std::cout << "       skate_sim sweep [--base R] [--slope R] [--scale R] [--lhs N] [--out FILE]" << std::endl;
+    std::cout << "       skate_sim solve [--state A:B:S] [--skill FILE --players A B]" << std::endl;
+    std::cout << "       skate_sim session [--skaters N|A,B,...] [--skill FILE] [--p1 STRATEGY]" << std::endl;
+    std::cout << "       skate_sim handicap [--skill FILE --players A B] [--threads N]" << std::endl;
+    std::cout << "       any command but sweep: [--rules skate|horse|pig[:retry]] [--cache FILE]" << std::endl;
+    std::cout << "       estimate and compare: [--house FILE]" << std::endl;
+    std::cout << "Strategies: random, greedy, safest, trick:N; ranges: FROM:TO:STEP" << std::endl;
+}
+
+bool parseRange(const std::string& text, SweepRange& range) {
+    int values[3] = {0, 0, 1};
+    int count = 0;
+    size_t start = 0;
+    while (count < 3) {
+        size_t colon = text.find(':', start);
+        std::string part = text.substr(start, colon == std::string::npos ? std::string::npos : colon - start);
+        if (part.empty()) {
+            return false;
+        }
+        values[count++] = std::atoi(part.c_str());
+        if (colon == std::string::npos) {
+            break;
+        }
+        start = colon + 1;
+    }
+    range.from = values[0];
+    range.to = count > 1 ? values[1] : values[0];
+    range.step = count > 2 ? std::max(1, values[2]) : 1;
+    return range.to >= range.from;
+}
+
+// Chances of a named player: fitted if the model knows them, the difficulty formula otherwise
+std::vector<int> playerChances(const SkillModel& model, const std::string& name, const SuccessCurve& curve) {
+    std::vector<int> chances;
+    int row = model.playerRow(name);
+    for (int trick = 0; trick < kDefaultTrickCount; trick++) {
+        if (row >= 0 && trick < model.trickCount()) {
+            chances.push_back(model.successChance(row, trick));
+        } else {
+            chances.push_back(trickThreshold(kDefaultTricks[trick], curve));
+        }
+    }
+    return chances;
+}
+
+bool parseState(const std::string& text, BotState& state) {
+    int setter = 0;
+    if (std::sscanf(text.c_str(), "%d:%d:%d", &state.letters[0], &state.letters[1], &setter) != 3) {
+        return false;
+    }
+    state.setter = setter - 1;
+    return state.letters[0] >= 0 && state.letters[1] >= 0 && (setter == 1 || setter == 2);
+}
+
+// Everything an estimate depends on (the thread count only changes where it stops)
+uint64_t estimateKey(const Matchup& matchup, const SimOptions& options) {
+    CacheKey key;
+    key.add(rulesetKey(matchup.rules)).add(matchup.chances[0]).add(matchup.chances[1]).add(matchup.firstSetter);
+    for (int player = 0; player < 2; player++) {
+        key.add(matchup.strategy[player].policy).add(matchup.strategy[player].trick);
+    }
+    if (matchup.house) {
+        const CompiledRules& house = *matchup.house;
+        key.add(std::vector<int>(house.next.begin(), house.next.end()));
+        key.add(std::vector<int>(house.tries.begin(), house.tries.end()));
+        key.add(std::vector<int>(house.missEvent.begin(), house.missEvent.end())).add(house.tricks);
+    }
+    uint64_t precision;
+    uint64_t confidence;
+    std::memcpy(&precision, &options.precision, sizeof(precision));
+    std::memcpy(&confidence, &options.confidence, sizeof(confidence));
+    key.add(options.games).add(precision).add(confidence).add(options.seed);
+    key.add(options.antithetic).add(options.controlVariate);
+    return key.value();
+}
+
+void printEstimate(const std::string& label, const WinEstimate& estimate, const SimOptions& options,
+                   double seconds) {
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << label << " = " << estimate.value << " +/- " << estimate.stdError << " ("
+              << std::setprecision(1) << 100.0 * options.confidence << "% interval +/- "
+              << std::setprecision(4) << estimate.halfWidth << ")" << std::endl;
+    if (options.precision > 0.0) {
+        std::cout << (estimate.precisionReached ? "Target precision reached" : "Target precision NOT reached")
+                  << " (+/- " << options.precision << ")" << std::endl;
+    }
+    std::cout << std::setprecision(1);
+    std::cout << "Simulated " << estimate.games << " games in " << std::setprecision(2) << seconds
+              << " s, " << std::setprecision(1) << estimate.averageRounds << " rounds per game" << std::endl;
+    std::cout << "Variance reduction: " << std::setprecision(1) << estimate.varianceReduction
+              << "x (plain Monte Carlo would give +/- " << std::setprecision(4) << estimate.plainStdError
+              << "), effective sample size " << std::setprecision(0) << estimate.effectiveGames
+              << " games" << std::endl;
+}
+
+// One line per worker, and how evenly the work was spread
+void printWorkers(const std::vector<SimWorkerStats>& workers) {
+    double slowest = 0.0;
+    double total = 0.0;
+    for (size_t w = 0; w < workers.size(); w++) {
+        const SimWorkerStats& worker = workers[w];
+        std::cout << "Worker " << w << ": cpu " << worker.cpu << ", node " << worker.node << ", " << worker.games
+                  << " games, " << std::fixed << std::setprecision(2) << worker.gamesPerSecond() / 1e6
+                  << " M games/s" << std::endl;
+        slowest = std::max(slowest, worker.seconds);
+        total += worker.seconds;
+    }
+    if (!workers.empty() && slowest > 0.0) {
+        std::cout << "Workers busy " << std::setprecision(1) << 100.0 * total / (slowest * workers.size())
+                  << "% of the time" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command != "estimate" && command != "compare" && command != "sweep" && command != "solve" &&
+        command != "session" && command != "handicap") {
+        printUsage();
+        return 1;
+    }
+
+    Matchup matchup = defaultMatchup();
+    SimOptions options;
+    Strategy alternative = matchup.strategy[0];
+    bool haveAlternative = false;
+    SkillModel skillModel;
+    std::string names[2] = {"Player 1", "Player 2"};
+    bool gamesGiven = false;
+    SweepRange ranges[3] = {{kDefaultCurve.base, kDefaultCurve.base, 1},
+                            {kDefaultCurve.slope, kDefaultCurve.slope, 1},
+                            {10, 10, 1}};
+    int lhsPoints = 0;
+    std::string outPath;
+    std::string cachePath;
+    BotState state = {{0, 0}, 0};
+    HouseRules houseRules;
+    CompiledRules compiledHouse;
+    std::vector<std::string> skaters;
+    bool showWorkers = false;
+    std::string tracePath;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) {
+            options.games = std::atol(argv[++i]);
+            gamesGiven = true;
+        } else if (arg == "--precision" && hasValue) {
+            options.precision = std::atof(argv[++i]);
+        } else if (arg == "--confidence" && hasValue) {
+            options.confidence = std::atof(argv[++i]);
+            // Accept 99 as well as 0.99
+            if (options.confidence > 1.0) {
+                options.confidence /= 100.0;
+            }
+            if (options.confidence <= 0.0 || options.confidence >= 1.0) {
+                std::cout << "Confidence must be between 0 and 1" << std::endl;
+                return 1;
+            }
+        } else if ((arg == "--p1" || arg == "--p2" || arg == "--vs") && hasValue) {
+            Strategy strategy;
+            if (!parseStrategy(argv[++i], strategy)) {
+                std::cout << "Unknown strategy " << argv[i] << std::endl;
+                return 1;
+            }
+            if (arg == "--vs") {
+                alternative = strategy;
+                haveAlternative = true;
+            } else {
+                matchup.strategy[arg == "--p1" ? 0 : 1] = strategy;
+            }
+        } else if (arg == "--skill" && hasValue) {
+            std::ifstream in(argv[++i]);
+            if (!skillModel.load(in)) {
+                std::cout << "Could not read skill model " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--players" && i + 2 < argc) {
+            names[0] = argv[++i];
+            names[1] = argv[++i];
+        } else if (arg == "--plain") {
+            options.antithetic = false;
+            options.controlVariate = false;
+        } else if (arg == "--no-antithetic") {
+            options.antithetic = false;
+        } else if (arg == "--no-control") {
+            options.controlVariate = false;
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--pin") {
+            options.pin = true;
+        } else if (arg == "--workers") {
+            showWorkers = true;
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+            if (!kTraceEnabled) {
+                std::cout << "skate_sim was built without tracing (-DSKATE_TRACE); the trace will be empty" << std::endl;
+            }
+        } else if ((arg == "--base" || arg == "--slope" || arg == "--scale") && hasValue) {
+            SweepRange& range = ranges[arg == "--base" ? 0 : (arg == "--slope" ? 1 : 2)];
+            if (!parseRange(argv[++i], range)) {
+                std::cout << "Bad range " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--lhs" && hasValue) {
+            lhsPoints = std::atoi(argv[++i]);
+        } else if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--rules" && hasValue) {
+            if (!parseRuleSet(argv[++i], matchup.rules)) {
+                std::cout << "Unknown rules " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--house" && hasValue) {
+            std::ifstream in(argv[++i]);
+            std::string error;
+            if (!in || !loadHouseRules(in, houseRules, error)) {
+                std::cout << "Could not read house rules " << argv[i] << (error.empty() ? "" : ": ") << error
+                          << std::endl;
+                return 1;
+            }
+            compiledHouse = compileHouseRules(houseRules);
+            if (compiledHouse.tricks.empty()) {
+                std::cout << "The house rules in " << argv[i] << " leave no trick to set" << std::endl;
+                return 1;
+            }
+            matchup.house = &compiledHouse;
+        } else if (arg == "--skaters" && hasValue) {
+            std::string list = argv[++i];
+            skaters.clear();
+            if (list.find(',') == std::string::npos) {
+                for (int s = 0; s < std::atoi(list.c_str()); s++) {
+                    skaters.push_back("Skater " + std::to_string(s + 1));
+                }
+            } else {
+                for (size_t start = 0; start <= list.size();) {
+                    size_t comma = std::min(list.find(',', start), list.size());
+                    skaters.push_back(list.substr(start, comma - start));
+                    start = comma + 1;
+                }
+            }
+            if (skaters.size() < 2 || skaters.size() > static_cast<size_t>(kMaxSessionPlayers)) {
+                std::cout << "A session needs 2 to " << kMaxSessionPlayers << " skaters" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--cache" && hasValue) {
+            cachePath = argv[++i];
+        } else if (arg == "--state" && hasValue) {
+            if (!parseState(argv[++i], state)) {
+                std::cout << "Bad state " << argv[i] << " (expected letters:letters:setter, e.g. 2:3:1)" << std::endl;
+                return 1;
+            }
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (command == "sweep" && !gamesGiven) {
+        options.games = options.precision > 0.0 ? 1000000L : 20000L;
+    } else if (options.precision > 0.0 && !gamesGiven) {
+        options.games = 1000000000L;
+    }
+    if (matchup.house && (command == "solve" || command == "sweep" || command == "session" || command == "handicap")) {
+        std::cout << command << " does not support --house" << std::endl;
+        return 1;
+    }
+    SuccessCurve curve = matchup.house ? matchup.house->curve : matchup.rules.info().curve;
+    matchup.chances[0] = playerChances(skillModel, names[0], curve);
+    matchup.chances[1] = playerChances(skillModel, names[1], curve);
+    if (std::max(state.letters[0], state.letters[1]) >= matchup.rules.letters()) {
+        std::cout << "The game is already over at " << state.letters[0] << ":" << state.letters[1] << std::endl;
+        return 1;
+    }
+
+    ResultCache cache;
+    if (!cachePath.empty() && !cache.load(cachePath)) {
+        std::cout << "Could not read cache " << cachePath << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (command == "session") {
+        if (skaters.empty()) {
+            for (int s = 0; s < 4; s++) {
+                skaters.push_back("Skater " + std::to_string(s + 1));
+            }
+        }
+        SessionMatchup session = defaultSessionMatchup(static_cast<int>(skaters.size()), matchup.rules);
+        for (size_t s = 0; s < skaters.size(); s++) {
+            session.chances[s] = playerChances(skillModel, skaters[s], curve);
+            session.strategy[s] = matchup.strategy[0];
+        }
+        SessionOdds odds = estimateSessionOdds(session, options);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::fixed << std::setprecision(4);
+        for (size_t s = 0; s < skaters.size(); s++) {
+            std::cout << "P(" << skaters[s] << " wins) = " << odds.winShare[s] << " +/- " << odds.stdError[s]
+                      << std::endl;
+        }
+        if (options.precision > 0.0) {
+            std::cout << (odds.precisionReached ? "Target precision reached" : "Target precision NOT reached")
+                      << " (+/- " << options.precision << ", widest interval +/- " << odds.halfWidth << ")"
+                      << std::endl;
+        }
+        std::cout << "Simulated " << odds.games << " sessions in " << std::setprecision(2) << seconds << " s, "
+                  << std::setprecision(1) << odds.averageRounds << " rounds per session" << std::endl;
+        if (showWorkers) {
+            printWorkers(odds.workers);
+        }
+    } else if (command == "sweep") {
+        std::vector<SweepPoint> points = lhsPoints > 0
+            ? latinHypercubePoints(ranges[0], ranges[1], ranges[2], lhsPoints, options.seed)
+            : gridPoints(ranges[0], ranges[1], ranges[2]);
+        std::vector<SweepResult> results = runSweep(points, matchup.strategy[0], options);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (outPath.empty()) {
+            writeSweepTable(std::cout, results);
+        } else {
+            std::ofstream out(outPath);
+            writeSweepTable(out, results);
+            if (!out) {
+                std::cout << "Could not write " << outPath << std::endl;
+                return 1;
+            }
+        }
+        long games = 0;
+        int reused = 0;
+        for (const auto& result : results) {
+            games += result.games;
+            reused += result.reused ? 1 : 0;
+        }
+        std::cerr << "Swept " << points.size() << " points (" << reused << " reused an earlier result), "
+                  << games << " games in " << std::fixed << std::setprecision(2) << seconds << " s" << std::endl;
+    } else if (command == "compare") {
+        if (!haveAlternative) {
+            std::cout << "compare needs --vs STRATEGY" << std::endl;
+            return 1;
+        }
+        WinEstimate estimate = compareStrategies(matchup, 0, matchup.strategy[0], alternative, options);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printEstimate("P(" + names[0] + " wins | " + strategyName(matchup.strategy[0]) + ") - P(" +
+                      names[0] + " wins | " + strategyName(alternative) + ")", estimate, options, seconds);
+        if (showWorkers) {
+            printWorkers(estimate.workers);
+        }
+    } else if (command == "handicap") {
+        std::vector<int> difficulties;
+        for (int trick = 0; trick < kDefaultTrickCount; trick++) {
+            difficulties.push_back(kDefaultTricks[trick].difficulty);
+        }
+        HandicapResult result = balanceHandicap(matchup.chances, difficulties, matchup.rules, options.threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const Handicap& handicap = result.handicap;
+        const std::string& strong = names[1 - result.weaker];
+        const std::string& weak = names[result.weaker];
+        std::cout << std::fixed << std::setprecision(4);
+        std::cout << "P(" << names[0] << " wins) = " << result.evenChance << " without a handicap" << std::endl;
+        std::cout << "Closest to an even game (" << weak << " is the weaker player):" << std::endl;
+        bool any = false;
+        if (handicap.startLetters[1 - result.weaker] > 0) {
+            std::cout << "  " << strong << " starts with " << handicap.startLetters[1 - result.weaker]
+                      << " letter(s)" << std::endl;
+            any = true;
+        }
+        int top = *std::max_element(difficulties.begin(), difficulties.end());
+        if (handicap.maxDifficulty[1 - result.weaker] < top) {
+            std::cout << "  " << strong << " may only set tricks up to difficulty "
+                      << handicap.maxDifficulty[1 - result.weaker] << std::endl;
+            any = true;
+        }
+        if (handicap.tries[result.weaker] > 1) {
+            std::cout << "  " << weak << " gets " << handicap.tries[result.weaker] << " tries to match" << std::endl;
+            any = true;
+        }
+        if (handicap.firstSetter != 0) {
+            std::cout << "  " << names[handicap.firstSetter] << " sets first" << std::endl;
+            any = true;
+        }
+        if (!any) {
+            std::cout << "  no handicap" << std::endl;
+        }
+        std::cout << "P(" << names[0] << " wins) = " << result.winChance << " with it" << std::endl;
+        std::cout << "Compared " << result.evaluated << " handicaps from " << result.solves << " solves in "
+                  << std::setprecision(2) << seconds * 1000.0 << " ms" << std::endl;
+    } else if (command == "solve") {
+        SolvedMatchup solved = cachedSolve(cache, matchup.chances, matchup.rules);
+        std::vector<double> tricks = trickWinChances(matchup.chances, solved, state);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int best = static_cast<int>(std::max_element(tricks.begin(), tricks.end()) - tricks.begin());
+        std::cout << std::fixed << std::setprecision(4);
+        std::cout << "P(" << names[0] << " wins) = " << solved.winChance(state) << " with perfect play from "
+                  << state.letters[0] << ":" << state.letters[1] << ", " << names[state.setter] << " setting"
+                  << std::endl;
+        std::cout << "Best trick for " << names[state.setter] << ": " << best + 1 << " (wins "
+                  << tricks[best] << ")" << std::endl;
+        std::cout << "Answered in " << std::setprecision(3) << seconds * 1000.0 << " ms" << std::endl;
+    } else {
+        uint64_t key = estimateKey(matchup, options);
+        CachedResult cached;
+        if (cache.find(key, cached)) {
+            std::cout << std::fixed << std::setprecision(4);
+            std::cout << "P(" << names[0] << " wins) = " << cached.value << " +/- " << cached.stdError
+                      << " (from cache)" << std::endl;
+        } else {
+            WinEstimate estimate = estimateWinProbability(matchup, options);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printEstimate("P(" + names[0] + " wins)", estimate, options, seconds);
+            if (showWorkers) {
+                printWorkers(estimate.workers);
+            }
+            CachedResult result = {estimate.value, estimate.stdError};
+            cache.insert(key, result, seconds);
+        }
+    }
+
+    if (!tracePath.empty()) {
+        std::ofstream out(tracePath);
+        writeChromeTrace(out);
+        if (!out) {
+            std::cout << "Could not write trace " << tracePath << std::endl;
+            return 1;
+        }
+    }
+    if (!cachePath.empty() && !cache.save(cachePath)) {
+        std::cout << "Could not write cache " << cachePath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,771 @@
+// Game of Skate - headless simulation
+// Plays complete games with no input or output, so win odds can be estimated from millions of them.
+//
+// Estimates use three variance reduction tricks:
+//  - common random numbers: strategies being compared play on exactly the same rolls
+//  - antithetic variates: every game is paired with a mirrored one (roll -> 101 - roll)
+//  - control variates: the letters actually handed out, and the setter turns actually lost,
+//    minus what the exact per-round chances predicted. Both average to zero and move with
+//    the result, so regressing them out takes away most of the luck of the rolls.
+//
+// Instead of a fixed number of games an estimate can be given a target precision; the
+// workers then check the confidence interval after every batch and stop once it is tight enough.
+//
+// Workers are laid out for big machines as described in skate_workers.h.
+
+#ifndef SKATE_SIM_H
+#define SKATE_SIM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skate_core.h"
+#include "skate_bot.h"
+#include "skate_rules.h"
+#include "skate_house.h"
+#include "skate_session.h"
+#include "skate_trace.h"
+#include "skate_workers.h"
+
+// Small and fast random number generator (SplitMix64). Every simulated game seeds its own
+// from the game number, so any game can be replayed exactly.
+struct SimRng {
+    uint64_t state;
+
+    explicit SimRng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform number between 0 and n - 1
+    int below(int n) {
+        return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32);
+    }
+
+    // Random number between 1-100, like attemptTrick
+    int roll() {
+        return 1 + below(100);
+    }
+};
+
+inline uint64_t mixSeed(uint64_t seed, uint64_t stream) {
+    SimRng rng(seed ^ (stream * 0xD1B54A32D192ED03ULL));
+    return rng.next();
+}
+
+// How a simulated player chooses the trick to set
+enum SetterPolicy {
+    POLICY_RANDOM, // any trick
+    POLICY_GREEDY, // the trick most likely to give the responder a letter this round
+    POLICY_SAFEST, // the trick the setter is most likely to land
+    POLICY_FIXED   // always the same trick
+};
+
+struct Strategy {
+    SetterPolicy policy;
+    int trick; // only used by POLICY_FIXED
+};
+
+// Parses "random", "greedy", "safest" or "trick:N" (N counted from 1, as in the game menu)
+inline bool parseStrategy(const std::string& text, Strategy& strategy) {
+    strategy.trick = 0;
+    if (text == "random") {
+        strategy.policy = POLICY_RANDOM;
+    } else if (text == "greedy") {
+        strategy.policy = POLICY_GREEDY;
+    } else if (text == "safest") {
+        strategy.policy = POLICY_SAFEST;
+    } else if (text.compare(0, 6, "trick:") == 0 && text.size() > 6) {
+        strategy.policy = POLICY_FIXED;
+        strategy.trick = std::atoi(text.c_str() + 6) - 1;
+        return strategy.trick >= 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline std::string strategyName(const Strategy& strategy) {
+    switch (strategy.policy) {
+    case POLICY_RANDOM:
+        return "random";
+    case POLICY_GREEDY:
+        return "greedy";
+    case POLICY_SAFEST:
+        return "safest";
+    default:
+        return "trick:" + std::to_string(strategy.trick + 1);
+    }
+}
+
+// Everything that decides how a game between two players plays out
+struct Matchup {
+    std::vector<std::vector<int>> chances; // [player][trick], in percent
+    Strategy strategy[2];
+    int firstSetter;
+    RuleSet rules;
+    const CompiledRules* house; // house rules to play by instead of `rules`, if any
+};
+
+// Two players on the difficulty formula, both setting greedily
+inline Matchup defaultMatchup() {
+    std::vector<int> chances;
+    for (const TrickInfo& trick : kDefaultCatalog) {
+        chances.push_back(trick.threshold);
+    }
+    Matchup matchup;
+    matchup.chances.assign(2, chances);
+    matchup.strategy[0].policy = POLICY_GREEDY;
+    matchup.strategy[0].trick = 0;
+    matchup.strategy[1] = matchup.strategy[0];
+    matchup.firstSetter = 0;
+    matchup.house = nullptr;
+    return matchup;
+}
+
+inline int chooseTrick(const Matchup& matchup, const BotState& state, SimRng& choices) {
+    const Strategy& strategy = matchup.strategy[state.setter];
+    const std::vector<int>& own = matchup.chances[state.setter];
+    switch (strategy.policy) {
+    case POLICY_RANDOM:
+        return choices.below(static_cast<int>(own.size()));
+    case POLICY_GREEDY:
+        return greedyTrick(matchup.chances, state);
+    case POLICY_SAFEST:
+        return static_cast<int>(std::max_element(own.begin(), own.end()) - own.begin());
+    default:
+        return std::min(strategy.trick, static_cast<int>(own.size()) - 1);
+    }
+}
+
+// Random numbers used by one game. Rolls and policy choices come from separate streams,
+// so two strategies that choose differently still see the same rolls.
+struct GameDice {
+    SimRng rolls;
+    SimRng choices;
+    bool mirrored; // antithetic copy: every roll r becomes 101 - r
+
+    GameDice(uint64_t rollSeed, uint64_t choiceSeed, bool mirror)
+        : rolls(rollSeed), choices(choiceSeed), mirrored(mirror) {}
+
+    int roll() {
+        int r = rolls.roll();
+        return mirrored ? 101 - r : r;
+    }
+};
+
+// Number of control variates tracked per game
+const int kSimControls = 2;
+
+struct GameResult {
+    int winner; // 0 or 1, -1 if the game hit the round limit
+    int rounds;
+    // Each averages to zero: [0] letters handed out in player 0's favour minus their expectation,
+    // [1] setter turns lost in player 0's favour minus their expectation
+    double control[kSimControls];
+};
+
+// Games longer than this are called a draw
+const int kMaxSimRounds = 10000;
+
+inline double chanceToProbability(int chance) {
+    return std::min(100, std::max(0, chance)) / 100.0;
+}
+
+// One game under the compile-time rules R; everything about the rules is a constant here
+template <typename R>
+inline GameResult simulateGame(const Matchup& matchup, GameDice& dice, R) {
+    GameResult result = {-1, 0, {0.0, 0.0}};
+    BotState state = {{0, 0}, matchup.firstSetter};
+    while (state.letters[0] < R::kLetters && state.letters[1] < R::kLetters) {
+        if (result.rounds == kMaxSimRounds) {
+            return result;
+        }
+        int trick = chooseTrick(matchup, state, dice.choices);
+        int setterChance = matchup.chances[state.setter][trick];
+        int responderChance = matchup.chances[1 - state.setter][trick];
+        bool secondTry = R::secondTry(state.letters[1 - state.setter]);
+
+        int outcome = BOTH_LANDED;
+        if (dice.roll() > setterChance) {
+            outcome = SETTER_MISSED;
+        } else if (dice.roll() > responderChance && (!secondTry || dice.roll() > responderChance)) {
+            outcome = RESPONDER_MISSED;
+        }
+
+        // A letter for player 1 is good for player 0, and so is player 1 losing the setter role
+        double swing = state.setter == 0 ? 1.0 : -1.0;
+        double setterLands = chanceToProbability(setterChance);
+        double responderMisses = 1.0 - chanceToProbability(responderChance);
+        if (secondTry) {
+            responderMisses *= responderMisses;
+        }
+        result.control[0] += swing * ((outcome == RESPONDER_MISSED ? 1.0 : 0.0) - setterLands * responderMisses);
+        result.control[1] -= swing * ((outcome == SETTER_MISSED ? 1.0 : 0.0) - (1.0 - setterLands));
+
+        state = applyOutcome(state, outcome);
+        result.rounds++;
+    }
+    result.winner = state.letters[0] >= R::kLetters ? 1 : 0;
+    return result;
+}
+
+// Compiled house rules, in place of compile-time Rules
+struct HousePlay {
+    const CompiledRules* rules;
+};
+
+// One game under house rules. The matchup's tricks must be the settable ones (see houseMatchup).
+inline GameResult simulateGame(const Matchup& matchup, GameDice& dice, HousePlay house) {
+    const CompiledRules& rules = *house.rules;
+    GameResult result = {-1, 0, {0.0, 0.0}};
+    int position = matchup.firstSetter; // nobody has a letter yet
+    while (rules.winner[position] < 0) {
+        if (result.rounds == kMaxSimRounds) {
+            return result;
+        }
+        const BotState& state = rules.positions[position];
+        int trick = chooseTrick(matchup, state, dice.choices);
+        int setterChance = matchup.chances[state.setter][trick];
+        int responderChance = matchup.chances[1 - state.setter][trick];
+        int tries = rules.tries[position];
+
+        int event = HOUSE_BOTH_LANDED;
+        if (dice.roll() > setterChance) {
+            event = HOUSE_SETTER_MISSED;
+        } else {
+            int missed = 0;
+            while (missed < tries && dice.roll() > responderChance) {
+                missed++;
+            }
+            if (missed == tries) {
+                event = rules.missEvent[trick];
+            }
+        }
+
+        double swing = state.setter == 0 ? 1.0 : -1.0;
+        double setterLands = chanceToProbability(setterChance);
+        double missOnce = 1.0 - chanceToProbability(responderChance);
+        double responderMisses = missOnce;
+        for (int t = 1; t < tries; t++) {
+            responderMisses *= missOnce;
+        }
+        result.control[0] += swing * ((event >= HOUSE_RESPONDER_MISSED ? 1.0 : 0.0) - setterLands * responderMisses);
+        result.control[1] -= swing * ((event == HOUSE_SETTER_MISSED ? 1.0 : 0.0) - (1.0 - setterLands));
+
+        position = rules.after(position, event);
+        result.rounds++;
+    }
+    result.winner = rules.winner[position];
+    return result;
+}
+
+// The matchup cut down to the tricks its house rules let players set
+inline Matchup houseMatchup(const Matchup& matchup) {
+    Matchup result = matchup;
+    for (int player = 0; player < 2; player++) {
+        result.chances[player].clear();
+        for (int trick : matchup.house->tricks) {
+            result.chances[player].push_back(matchup.chances[player][trick]);
+        }
+        if (matchup.strategy[player].policy == POLICY_FIXED) {
+            result.strategy[player].trick = std::max(0, matchup.house->settable(matchup.strategy[player].trick));
+        }
+    }
+    return result;
+}
+
+// One game under the matchup's rules
+inline GameResult simulateGame(const Matchup& matchup, GameDice& dice) {
+    if (matchup.house) {
+        HousePlay house = {matchup.house};
+        return simulateGame(houseMatchup(matchup), dice, house);
+    }
+    return withRules(matchup.rules, [&](auto rules) { return simulateGame(matchup, dice, rules); });
+}
+
+struct SimOptions {
+    long games;          // games to simulate (counting every arm and every mirrored copy);
+                         // with a target precision, the most games to spend trying to reach it
+    bool antithetic;
+    bool controlVariate;
+    uint64_t seed;
+    int threads;         // 0 uses every hardware thread
+    double precision;    // stop once the confidence interval is +/- this much (0 = run all games)
+    double confidence;   // confidence level of the interval, e.g. 0.99
+    bool pin;            // pin every worker to its own CPU (see skate_workers.h)
+
+    SimOptions()
+        : games(100000), antithetic(true), controlVariate(true), seed(1), threads(0),
+          precision(0.0), confidence(0.95), pin(false) {}
+};
+
+// Two-sided normal quantile: the z for which the interval +/- z * stdError has the given confidence.
+// Rational approximation by Peter Acklam, good to about 1e-9.
+inline double confidenceZ(double confidence) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    double p = 1.0 - (1.0 - confidence) / 2.0;
+    if (p >= 1.0) {
+        return 40.0;
+    }
+    if (p > 0.97575) {
+        double q = std::sqrt(-2.0 * std::log(1.0 - p));
+        return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+struct WinEstimate {
+    double value;             // the estimated probability (or difference of probabilities)
+    double stdError;
+    double plainStdError;     // what plain Monte Carlo would get from the same number of games
+    double varianceReduction; // plain variance / achieved variance
+    double effectiveGames;    // games plain Monte Carlo would need for the same precision
+    long games;
+    double averageRounds;
+    double halfWidth;         // of the confidence interval at SimOptions::confidence
+    bool precisionReached;    // a target precision was given and met
+    std::vector<SimWorkerStats> workers;
+};
+
+// Running sums over independent samples. A sample is one game, or with antithetic variates
+// a mirrored pair, for every arm being compared.
+struct SimAccumulator {
+    long samples;
+    long games;
+    long rounds;
+    double sumY, sumYY;
+    double sumC[kSimControls];
+    double sumCC[kSimControls][kSimControls];
+    double sumYC[kSimControls];
+    double armWins[2]; // per arm, for the plain Monte Carlo variance
+
+    SimAccumulator() : samples(0), games(0), rounds(0), sumY(0), sumYY(0) {
+        for (int i = 0; i < kSimControls; i++) {
+            sumC[i] = sumYC[i] = 0.0;
+            for (int j = 0; j < kSimControls; j++) {
+                sumCC[i][j] = 0.0;
+            }
+        }
+        armWins[0] = armWins[1] = 0.0;
+    }
+
+    void add(double y, const double* c) {
+        samples++;
+        sumY += y;
+        sumYY += y * y;
+        for (int i = 0; i < kSimControls; i++) {
+            sumC[i] += c[i];
+            sumYC[i] += y * c[i];
+            for (int j = 0; j < kSimControls; j++) {
+                sumCC[i][j] += c[i] * c[j];
+            }
+        }
+    }
+
+    void merge(const SimAccumulator& other) {
+        samples += other.samples;
+        games += other.games;
+        rounds += other.rounds;
+        sumY += other.sumY;
+        sumYY += other.sumYY;
+        for (int i = 0; i < kSimControls; i++) {
+            sumC[i] += other.sumC[i];
+            sumYC[i] += other.sumYC[i];
+            for (int j = 0; j < kSimControls; j++) {
+                sumCC[i][j] += other.sumCC[i][j];
+            }
+        }
+        armWins[0] += other.armWins[0];
+        armWins[1] += other.armWins[1];
+    }
+
+    WinEstimate estimate(int arms, bool controlVariate) const {
+        WinEstimate result = {0.0, 0.0, 0.0, 1.0, 0.0, games, 0.0, 0.0, false, std::vector<SimWorkerStats>()};
+        if (samples < 2) {
+            return result;
+        }
+        double n = static_cast<double>(samples);
+        double meanY = sumY / n;
+        double varY = std::max(0.0, (sumYY - n * meanY * meanY) / (n - 1));
+        result.value = meanY;
+        double variance = varY;
+
+        if (controlVariate) {
+            // Regress the result on the two controls: solve var(C) * beta = cov(C, Y)
+            double meanC[kSimControls], cov[kSimControls], var[kSimControls][kSimControls];
+            for (int i = 0; i < kSimControls; i++) {
+                meanC[i] = sumC[i] / n;
+            }
+            for (int i = 0; i < kSimControls; i++) {
+                cov[i] = (sumYC[i] - n * meanY * meanC[i]) / (n - 1);
+                for (int j = 0; j < kSimControls; j++) {
+                    var[i][j] = (sumCC[i][j] - n * meanC[i] * meanC[j]) / (n - 1);
+                }
+            }
+            double det = var[0][0] * var[1][1] - var[0][1] * var[1][0];
+            if (det > 1e-12 * var[0][0] * var[1][1] && det > 0.0) {
+                double beta0 = (var[1][1] * cov[0] - var[0][1] * cov[1]) / det;
+                double beta1 = (var[0][0] * cov[1] - var[1][0] * cov[0]) / det;
+                // The controls average to exactly zero, so only their deviation is subtracted
+                result.value = meanY - beta0 * meanC[0] - beta1 * meanC[1];
+                variance = std::max(0.0, varY - beta0 * cov[0] - beta1 * cov[1]);
+            }
+        }
+        result.stdError = std::sqrt(variance / n);
+
+        // Plain Monte Carlo spends the same games on independent runs of each arm
+        double gamesPerArm = static_cast<double>(games) / arms;
+        double plainVariance = 0.0;
+        for (int arm = 0; arm < arms; arm++) {
+            double p = armWins[arm] / gamesPerArm;
+            plainVariance += p * (1.0 - p) / gamesPerArm;
+        }
+        result.plainStdError = std::sqrt(plainVariance);
+        if (result.stdError > 0.0) {
+            result.varianceReduction = plainVariance / (result.stdError * result.stdError);
+        }
+        result.effectiveGames = games * result.varianceReduction;
+        result.averageRounds = games > 0 ? static_cast<double>(rounds) / games : 0.0;
+        return result;
+    }
+};
+
+// Simulates the sample with the given number on every arm and adds it to the sums.
+// arms[0] is scored as a win for `player`; with two arms the sample is the difference.
+template <typename R>
+inline void simulateSample(const Matchup* arms, int armCount, int player, const SimOptions& options,
+                           uint64_t sample, SimAccumulator& sums, R rules) {
+    uint64_t rollSeed = mixSeed(options.seed, 2 * sample);
+    uint64_t choiceSeed = mixSeed(options.seed, 2 * sample + 1);
+    int copies = options.antithetic ? 2 : 1;
+    double y = 0.0;
+    double c[kSimControls] = {0.0, 0.0};
+    for (int arm = 0; arm < armCount; arm++) {
+        double sign = arm == 0 ? 1.0 : -1.0;
+        for (int copy = 0; copy < copies; copy++) {
+            GameDice dice(rollSeed, choiceSeed, copy == 1);
+            GameResult game = simulateGame(arms[arm], dice, rules);
+            double win = game.winner == player ? 1.0 : 0.0;
+            y += sign * win / copies;
+            for (int i = 0; i < kSimControls; i++) {
+                c[i] += sign * game.control[i] / copies;
+            }
+            sums.armWins[arm] += win;
+            sums.rounds += game.rounds;
+            sums.games++;
+        }
+    }
+    sums.add(y, c);
+}
+
+inline int simThreads(const SimOptions& options) {
+    return options.threads > 0 ? options.threads
+                               : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+// All arms play under the rules of the first one
+template <typename R>
+inline WinEstimate runSamples(const Matchup* arms, int armCount, int player, const SimOptions& options, R rules) {
+    // Samples handed out per claim; results are merged and the interval checked once per batch
+    const uint64_t kBatchSamples = 256;
+    // Too few samples give a variance estimate that cannot be trusted for stopping
+    const long kMinSamplesToStop = 2000;
+
+    int gamesPerSample = armCount * (options.antithetic ? 2 : 1);
+    uint64_t samples = static_cast<uint64_t>(std::max(2L, options.games / gamesPerSample));
+    int threads = simThreads(options);
+    double z = confidenceZ(options.confidence);
+
+    // Claimed by every worker, read by every worker and written once: each on its own line
+    CachePadded<std::atomic<uint64_t>> nextBatch;
+    CachePadded<std::atomic<bool>> stop;
+    nextBatch.value = 0;
+    stop.value = false;
+    std::mutex totalLock;
+    SimAccumulator total;
+    bool reached = false;
+
+    // Samples are seeded by their number, so which thread runs them does not change the result
+    auto worker = [&](int) {
+        // The worker's own copy of the arms and its sums, allocated on its own node
+        std::vector<Matchup> mine(arms, arms + armCount);
+        SimAccumulator local;
+        long games = 0;
+        while (!stop.value.load(std::memory_order_relaxed)) {
+            uint64_t first = nextBatch.value.fetch_add(1, std::memory_order_relaxed) * kBatchSamples;
+            if (first >= samples) {
+                break;
+            }
+            SKATE_TRACE_SCOPE("sim batch");
+            uint64_t last = std::min(samples, first + kBatchSamples);
+            for (uint64_t s = first; s < last; s++) {
+                simulateSample(mine.data(), armCount, player, options, s, local, rules);
+            }
+            // Without a target precision nothing needs the total before the end
+            if (options.precision <= 0.0) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> guard(totalLock);
+            games += local.games;
+            total.merge(local);
+            local = SimAccumulator();
+            if (!reached && total.samples >= kMinSamplesToStop) {
+                WinEstimate sofar = total.estimate(armCount, options.controlVariate);
+                if (z * sofar.stdError <= options.precision) {
+                    reached = true;
+                    stop.value.store(true, std::memory_order_relaxed);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> guard(totalLock);
+        games += local.games;
+        total.merge(local);
+        return games;
+    };
+    std::vector<SimWorkerStats> workers = runWorkers(threads, options.pin, worker);
+
+    WinEstimate result = total.estimate(armCount, options.controlVariate);
+    result.halfWidth = z * result.stdError;
+    result.precisionReached = reached;
+    result.workers = workers;
+    return result;
+}
+
+inline WinEstimate runSamples(const Matchup* arms, int armCount, int player, const SimOptions& options) {
+    if (arms[0].house) {
+        std::vector<Matchup> settable;
+        for (int arm = 0; arm < armCount; arm++) {
+            settable.push_back(houseMatchup(arms[arm]));
+        }
+        HousePlay house = {arms[0].house};
+        return runSamples(settable.data(), armCount, player, options, house);
+    }
+    return withRules(arms[0].rules, [&](auto rules) { return runSamples(arms, armCount, player, options, rules); });
+}
+
+// Probability that player 0 wins the matchup
+inline WinEstimate estimateWinProbability(const Matchup& matchup, const SimOptions& options) {
+    return runSamples(&matchup, 1, 0, options);
+}
+
+// How much more often `player` wins with strategy a than with strategy b (same opponent)
+inline WinEstimate compareStrategies(const Matchup& matchup, int player, const Strategy& a,
+                                     const Strategy& b, const SimOptions& options) {
+    Matchup arms[2] = {matchup, matchup};
+    arms[0].strategy[player] = a;
+    arms[1].strategy[player] = b;
+    return runSamples(arms, 2, player, options);
+}
+
+// Everything that decides how a session of more than two skaters plays out
+struct SessionMatchup {
+    std::vector<std::vector<int>> chances; // [skater][trick], in percent
+    std::vector<Strategy> strategy;        // per skater
+    int firstSetter;
+    RuleSet rules;
+};
+
+// `players` skaters on the difficulty formula of the rules, all setting greedily
+inline SessionMatchup defaultSessionMatchup(int players, const RuleSet& rules = RuleSet()) {
+    std::vector<int> chances;
+    for (const TrickInfo& trick : kDefaultCatalog) {
+        chances.push_back(trickThreshold(trick, rules.info().curve));
+    }
+    Strategy greedy = {POLICY_GREEDY, 0};
+    SessionMatchup matchup;
+    matchup.chances.assign(players, chances);
+    matchup.strategy.assign(players, greedy);
+    matchup.firstSetter = 0;
+    matchup.rules = rules;
+    return matchup;
+}
+
+// Greedy sets the trick that hands out the most letters this round on average
+inline int chooseSessionTrick(const SessionMatchup& matchup, const SessionState& state, SimRng& choices) {
+    const Strategy& strategy = matchup.strategy[state.setter];
+    const std::vector<int>& own = matchup.chances[state.setter];
+    switch (strategy.policy) {
+    case POLICY_RANDOM:
+        return choices.below(static_cast<int>(own.size()));
+    case POLICY_GREEDY: {
+        int best = 0;
+        long bestScore = -1;
+        for (size_t trick = 0; trick < own.size(); trick++) {
+            long misses = 0;
+            for (int p = state.nextActive(state.setter); p != state.setter && p >= 0; p = state.nextActive(p)) {
+                misses += 100 - matchup.chances[p][trick];
+            }
+            long score = own[trick] * misses;
+            if (score > bestScore) {
+                bestScore = score;
+                best = static_cast<int>(trick);
+            }
+        }
+        return best;
+    }
+    case POLICY_SAFEST:
+        return static_cast<int>(std::max_element(own.begin(), own.end()) - own.begin());
+    default:
+        return std::min(strategy.trick, static_cast<int>(own.size()) - 1);
+    }
+}
+
+// One session; returns the winner, or -1 if it hit the round limit
+inline int simulateSession(const SessionMatchup& matchup, GameDice& dice, int& rounds) {
+    const int word = matchup.rules.letters();
+    SessionState state = startSession(static_cast<int>(matchup.chances.size()), matchup.firstSetter);
+    for (rounds = 0; !state.isOver(); rounds++) {
+        if (rounds == kMaxSimRounds) {
+            return -1;
+        }
+        int trick = chooseSessionTrick(matchup, state, dice.choices);
+        if (dice.roll() > matchup.chances[state.setter][trick]) {
+            state = setterMissed(state, 0, word);
+            continue;
+        }
+        // Everyone still in at the start of the round gets to respond, in rotation order
+        SessionState before = state;
+        for (int p = before.nextActive(before.setter); p != before.setter; p = before.nextActive(p)) {
+            int chance = matchup.chances[p][trick];
+            bool secondTry = matchup.rules.secondTry(before.lettersOf(p));
+            if (dice.roll() > chance && (!secondTry || dice.roll() > chance)) {
+                state = addLetters(state, p, 1, word);
+            }
+        }
+    }
+    return state.winner();
+}
+
+struct SessionOdds {
+    std::vector<double> winShare; // per skater
+    std::vector<double> stdError;
+    long games;
+    double averageRounds;
+    double halfWidth;      // of the widest skater's interval at options.confidence
+    bool precisionReached; // every share is known to options.precision
+    std::vector<SimWorkerStats> workers;
+};
+
+// Share of sessions each skater wins. Plain Monte Carlo: the antithetic games and control
+// variates of the two-player estimates do not carry over, so only games, precision, confidence,
+// seed and threads apply. With a precision, the sessions stop once every skater's share is known
+// to within it.
+inline SessionOdds estimateSessionOdds(const SessionMatchup& matchup, const SimOptions& options) {
+    const uint64_t kBatchGames = 256;
+    // As in runSamples, too few sessions give a standard error that cannot be trusted for stopping
+    const long kMinGamesToStop = 2000;
+    const size_t players = matchup.chances.size();
+    uint64_t games = static_cast<uint64_t>(std::max(1L, options.games));
+    double z = confidenceZ(options.confidence);
+    CachePadded<std::atomic<uint64_t>> nextBatch;
+    CachePadded<std::atomic<bool>> stop;
+    nextBatch.value = 0;
+    stop.value = false;
+    std::mutex totalLock;
+    std::vector<long> wins(players, 0);
+    long finished = 0;
+    long rounds = 0;
+    bool reached = false;
+
+    // Widest interval of any skater's share
+    auto widest = [&]() {
+        double width = 0.0;
+        for (size_t p = 0; p < players; p++) {
+            double share = static_cast<double>(wins[p]) / finished;
+            width = std::max(width, z * std::sqrt(share * (1.0 - share) / (finished - 1)));
+        }
+        return width;
+    };
+
+    // Games are seeded by their number, so which thread runs them does not change the result
+    auto worker = [&](int) {
+        // The worker's own copy of the matchup and its counts, allocated on its own node
+        SessionMatchup mine = matchup;
+        std::vector<long> localWins(players, 0);
+        long localFinished = 0;
+        long localRounds = 0;
+        long played = 0;
+        auto merge = [&]() {
+            for (size_t p = 0; p < players; p++) {
+                wins[p] += localWins[p];
+                localWins[p] = 0;
+            }
+            finished += localFinished;
+            rounds += localRounds;
+            played += localFinished;
+            localFinished = 0;
+            localRounds = 0;
+        };
+        while (!stop.value.load(std::memory_order_relaxed)) {
+            uint64_t first = nextBatch.value.fetch_add(1, std::memory_order_relaxed) * kBatchGames;
+            if (first >= games) {
+                break;
+            }
+            SKATE_TRACE_SCOPE("session batch");
+            uint64_t last = std::min(games, first + kBatchGames);
+            for (uint64_t g = first; g < last; g++) {
+                GameDice dice(mixSeed(options.seed, 2 * g), mixSeed(options.seed, 2 * g + 1), false);
+                int length = 0;
+                int winner = simulateSession(mine, dice, length);
+                if (winner >= 0) {
+                    localWins[winner]++;
+                }
+                localFinished++;
+                localRounds += length;
+            }
+            // Without a target precision nothing needs the total before the end
+            if (options.precision <= 0.0) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> guard(totalLock);
+            merge();
+            if (!reached && finished >= kMinGamesToStop && widest() <= options.precision) {
+                reached = true;
+                stop.value.store(true, std::memory_order_relaxed);
+            }
+        }
+        std::lock_guard<std::mutex> guard(totalLock);
+        merge();
+        return played;
+    };
+
+    SessionOdds odds;
+    odds.workers = runWorkers(simThreads(options), options.pin, worker);
+    odds.games = finished;
+    odds.averageRounds = finished > 0 ? static_cast<double>(rounds) / finished : 0.0;
+    for (size_t p = 0; p < players; p++) {
+        double share = finished > 0 ? static_cast<double>(wins[p]) / finished : 0.0;
+        odds.winShare.push_back(share);
+        odds.stdError.push_back(finished > 1 ? std::sqrt(share * (1.0 - share) / (finished - 1)) : 0.0);
+    }
+    odds.halfWidth = finished > 1 ? widest() : 0.0;
+    odds.precisionReached = reached;
+    return odds;
+}
+
+#endif // SKATE_SIM_H
@@ -0,0 +1,324 @@
+// Game of Skate - player skill model
+// Holds how likely each player is to land each trick, and fits those chances from logged attempts.
+//
+// Attempt log format (one attempt per line, as written by the console game with --log):
+//     <player name> TAB <trick index> TAB <1 if landed, 0 if not> [TAB <s|r> TAB <unix time>]
+// The optional fields (setter or responder, and when) are for skate_store.h; fitting ignores them.
+//
+// Model file format:
+//     skate-skill-model <number of tricks>
+//     <player name> TAB <probability for trick 0> TAB ... TAB <probability for the last trick>
+
+#ifndef SKATE_SKILL_H
+#define SKATE_SKILL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "skate_core.h"
+
+class SkillModel {
+public:
+    SkillModel() : numTricks(0) {}
+
+    SkillModel(const std::vector<std::string>& players, int tricks, const std::vector<float>& probabilities)
+        : numTricks(tricks) {
+        for (size_t i = 0; i < players.size(); i++) {
+            addRow(players[i], &probabilities[i * tricks]);
+        }
+    }
+
+    int trickCount() const {
+        return numTricks;
+    }
+
+    int playerCount() const {
+        return static_cast<int>(names.size());
+    }
+
+    const std::string& playerName(int row) const {
+        return names[row];
+    }
+
+    // Row of the named player, or -1 if the model knows nothing about them
+    int playerRow(const std::string& name) const {
+        auto it = rows.find(name);
+        return it == rows.end() ? -1 : it->second;
+    }
+
+    double probability(int row, int trick) const {
+        return probabilities[static_cast<size_t>(row) * numTricks + trick];
+    }
+
+    // Success chance in percent, comparable with a 1-100 roll like successChance()
+    int successChance(int row, int trick) const {
+        return chances[static_cast<size_t>(row) * numTricks + trick];
+    }
+
+    void save(std::ostream& out) const {
+        out << "skate-skill-model " << numTricks << "\n";
+        for (int row = 0; row < playerCount(); row++) {
+            out << names[row];
+            for (int trick = 0; trick < numTricks; trick++) {
+                out << "\t" << probability(row, trick);
+            }
+            out << "\n";
+        }
+    }
+
+    bool load(std::istream& in) {
+        std::string header;
+        int tricks = 0;
+        if (!(in >> header >> tricks) || header != "skate-skill-model" || tricks <= 0) {
+            return false;
+        }
+        in.ignore(1, '\n');
+
+        SkillModel loaded;
+        loaded.numTricks = tricks;
+        std::string line;
+        std::vector<float> row(tricks);
+        while (std::getline(in, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            std::istringstream fields(line);
+            std::string name;
+            std::getline(fields, name, '\t');
+            for (int trick = 0; trick < tricks; trick++) {
+                if (!(fields >> row[trick])) {
+                    return false;
+                }
+            }
+            loaded.addRow(name, row.data());
+        }
+        *this = loaded;
+        return true;
+    }
+
+private:
+    int numTricks;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, int> rows;
+    std::vector<float> probabilities; // [player * numTricks + trick]
+    std::vector<int> chances;         // the same, rounded to percent
+
+    void addRow(const std::string& name, const float* row) {
+        rows[name] = static_cast<int>(names.size());
+        names.push_back(name);
+        for (int trick = 0; trick < numTricks; trick++) {
+            float p = std::min(1.0f, std::max(0.0f, row[trick]));
+            probabilities.push_back(p);
+            chances.push_back(static_cast<int>(std::lround(p * 100.0f)));
+        }
+    }
+};
+
+// One logged attempt, with the player already resolved to an index
+struct AttemptRecord {
+    uint32_t player;
+    uint16_t trick;
+    uint16_t landed; // 0 or 1
+};
+
+// Estimates every player's chance on every trick from attempt counts.
+// Each estimate is the maximum likelihood landed/attempts, pulled towards the difficulty
+// formula by priorAttempts imaginary attempts so rarely tried tricks stay sensible.
+class SkillFitter {
+public:
+    SkillFitter(const std::vector<int>& difficulties, double priorAttempts = 10.0)
+        : numTricks(static_cast<int>(difficulties.size())), priorWeight(priorAttempts) {
+        for (int difficulty : difficulties) {
+            float chance = static_cast<float>(successChance(difficulty)) / 100.0f;
+            prior.push_back(std::min(1.0f, std::max(0.0f, chance)));
+        }
+    }
+
+    // Index of the named player, adding them if they are new
+    int addPlayer(const std::string& name) {
+        auto it = playerIndex.find(name);
+        if (it != playerIndex.end()) {
+            return it->second;
+        }
+        int index = static_cast<int>(names.size());
+        playerIndex[name] = index;
+        names.push_back(name);
+        attempts.resize(names.size() * numTricks, 0);
+        landed.resize(names.size() * numTricks, 0);
+        return index;
+    }
+
+    void add(int player, int trick, bool success) {
+        size_t cell = static_cast<size_t>(player) * numTricks + trick;
+        attempts[cell]++;
+        landed[cell] += success ? 1 : 0;
+    }
+
+    // Count a batch of attempts. Large batches are split across threads, each counting into
+    // its own table, and the tables are summed at the end.
+    void addBatch(const AttemptRecord* records, size_t count, int threads = 1) {
+        const size_t kMinPerThread = 1 << 20;
+        size_t cells = attempts.size();
+        threads = static_cast<int>(std::min<size_t>(std::max(1, threads), count / kMinPerThread + 1));
+        // Private tables only pay off when they are small next to the batch
+        if (threads == 1 || cells * threads > count) {
+            countInto(records, count, attempts.data(), landed.data());
+            return;
+        }
+
+        std::vector<std::vector<uint64_t>> localAttempts(threads, std::vector<uint64_t>(cells, 0));
+        std::vector<std::vector<uint64_t>> localLanded(threads, std::vector<uint64_t>(cells, 0));
+        std::vector<std::thread> workers;
+        size_t chunk = (count + threads - 1) / threads;
+        for (int t = 0; t < threads; t++) {
+            size_t begin = std::min(count, t * chunk);
+            size_t end = std::min(count, begin + chunk);
+            workers.emplace_back([this, records, begin, end, t, &localAttempts, &localLanded]() {
+                countInto(records + begin, end - begin, localAttempts[t].data(), localLanded[t].data());
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (int t = 0; t < threads; t++) {
+            const uint64_t* a = localAttempts[t].data();
+            const uint64_t* l = localLanded[t].data();
+            for (size_t cell = 0; cell < cells; cell++) {
+                attempts[cell] += a[cell];
+                landed[cell] += l[cell];
+            }
+        }
+    }
+
+    // Stream an attempt log into the counts; returns the number of attempts read.
+    // Lines that do not parse or name an unknown trick are skipped.
+    size_t readLog(std::istream& in, int threads = 1) {
+        const size_t kBatchSize = 1 << 20;
+        LogReader reader;
+        reader.batch.reserve(kBatchSize);
+        size_t total = 0;
+
+        // Read big blocks and cut them into lines in place; a partial last line is
+        // carried over to the front of the next block
+        std::vector<char> buffer(1 << 20);
+        size_t carry = 0;
+        while (true) {
+            in.read(buffer.data() + carry, static_cast<std::streamsize>(buffer.size() - carry));
+            size_t filled = carry + static_cast<size_t>(in.gcount());
+            bool atEnd = !in;
+            const char* p = buffer.data();
+            const char* end = p + filled;
+            while (p < end) {
+                const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+                if (!newline) {
+                    if (atEnd) {
+                        parseLine(reader, p, end);
+                        p = end;
+                    }
+                    break;
+                }
+                parseLine(reader, p, newline);
+                p = newline + 1;
+            }
+            if (reader.batch.size() >= kBatchSize || atEnd) {
+                addBatch(reader.batch.data(), reader.batch.size(), threads);
+                total += reader.batch.size();
+                reader.batch.clear();
+            }
+            if (atEnd) {
+                break;
+            }
+            carry = static_cast<size_t>(end - p);
+            std::memmove(buffer.data(), p, carry);
+            if (carry == buffer.size()) {
+                // A single line longer than the buffer
+                buffer.resize(buffer.size() * 2);
+            }
+        }
+        return total;
+    }
+
+    SkillModel fit() const {
+        std::vector<float> probabilities(attempts.size());
+        float k = static_cast<float>(priorWeight);
+        for (size_t player = 0; player < names.size(); player++) {
+            const uint64_t* a = &attempts[player * numTricks];
+            const uint64_t* l = &landed[player * numTricks];
+            float* p = &probabilities[player * numTricks];
+            for (int trick = 0; trick < numTricks; trick++) {
+                float n = static_cast<float>(a[trick]) + k;
+                p[trick] = n > 0.0f ? (static_cast<float>(l[trick]) + k * prior[trick]) / n : prior[trick];
+            }
+        }
+        return SkillModel(names, numTricks, probabilities);
+    }
+
+private:
+    int numTricks;
+    double priorWeight;
+    std::vector<float> prior;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, int> playerIndex;
+    std::vector<uint64_t> attempts; // [player * numTricks + trick]
+    std::vector<uint64_t> landed;
+
+    struct LogReader {
+        std::vector<AttemptRecord> batch;
+        std::string lastName;
+        int lastPlayer = -1;
+    };
+
+    void parseLine(LogReader& reader, const char* begin, const char* end) {
+        const char* tab = static_cast<const char*>(std::memchr(begin, '\t', end - begin));
+        if (!tab) {
+            return;
+        }
+        const char* p = tab + 1;
+        int trick = 0;
+        int digits = 0;
+        while (p < end && *p >= '0' && *p <= '9' && digits < 6) {
+            trick = trick * 10 + (*p - '0');
+            p++;
+            digits++;
+        }
+        if (digits == 0 || p >= end || *p != '\t' || trick >= numTricks) {
+            return;
+        }
+        bool success = p + 1 < end && p[1] == '1';
+
+        // Consecutive attempts usually come from the same game, so remember the last player
+        size_t nameLength = static_cast<size_t>(tab - begin);
+        if (reader.lastPlayer < 0 || reader.lastName.size() != nameLength ||
+            std::memcmp(reader.lastName.data(), begin, nameLength) != 0) {
+            reader.lastName.assign(begin, nameLength);
+            reader.lastPlayer = addPlayer(reader.lastName);
+        }
+
+        AttemptRecord record;
+        record.player = static_cast<uint32_t>(reader.lastPlayer);
+        record.trick = static_cast<uint16_t>(trick);
+        record.landed = success ? 1 : 0;
+        reader.batch.push_back(record);
+    }
+
+    // Branch-free counting pass
+    void countInto(const AttemptRecord* records, size_t count, uint64_t* a, uint64_t* l) const {
+        for (size_t i = 0; i < count; i++) {
+            size_t cell = static_cast<size_t>(records[i].player) * numTricks + records[i].trick;
+            a[cell] += 1;
+            l[cell] += records[i].landed;
+        }
+    }
+};
+
+#endif // SKATE_SKILL_H
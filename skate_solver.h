@@ -0,0 +1,137 @@
+// Game of Skate - exact solver
+// Works out the exact chance of winning from every position when both players set the trick
+// that is best for them, under the rules of Game::playRound and any of the rule variants.
+// The GUI's players take turns setting whatever happens, which the solver can play too.
+//
+// Letters never go away, so positions are solved from the most letters down. The only loops
+// are "both landed" (same position again) and "setter missed" (same letters, other setter);
+// the first is summed up in closed form and the second settled by iterating the pair.
+
+#ifndef SKATE_SOLVER_H
+#define SKATE_SOLVER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "skate_core.h"
+#include "skate_bot.h"
+#include "skate_rules.h"
+
+struct SolvedMatchup {
+    // value[a][b][setter]: chance that player 0 wins with a and b letters and that setter to play
+    double value[kMaxRuleLetters + 1][kMaxRuleLetters + 1][2];
+    RuleSet rules;
+    bool takeTurns = false; // the setter changes after every round, as in the GUI
+
+    double winChance(const BotState& state) const {
+        return value[state.letters[0]][state.letters[1]][state.setter];
+    }
+};
+
+inline double solverProbability(int chance) {
+    return std::min(100, std::max(0, chance)) / 100.0;
+}
+
+// Chance that player 0 wins if the setter sets `trick` now and both play perfectly afterwards.
+// `other` is the value with the setter switched, `letter` the value after the responder's letter.
+// With a second try the responder only takes the letter after missing twice. When the players
+// take turns, both landing moves on to `other` and `letter` is the value with the setter switched.
+inline double trickValue(double setterLands, double responderLands, double other, double letter,
+                         bool secondTry = false, bool takeTurns = false) {
+    double responderMisses = 1.0 - responderLands;
+    if (secondTry) {
+        responderMisses *= responderMisses;
+    }
+    if (takeTurns) {
+        double given = setterLands * responderMisses;
+        return (1.0 - given) * other + given * letter;
+    }
+    double repeat = setterLands * (1.0 - responderMisses);
+    if (repeat >= 1.0) {
+        // Both always land: the game never moves on, call it even
+        return 0.5;
+    }
+    return ((1.0 - setterLands) * other + setterLands * responderMisses * letter) / (1.0 - repeat);
+}
+
+// chances[player][trick] in percent, as used by attemptTrick
+inline SolvedMatchup solveMatchup(const std::vector<std::vector<int>>& chances, const RuleSet& rules = RuleSet(),
+                                  bool takeTurns = false) {
+    SolvedMatchup solved;
+    solved.rules = rules;
+    solved.takeTurns = takeTurns;
+    const int full = rules.letters();
+    size_t tricks = chances[0].size();
+
+    // Finished games
+    for (int a = 0; a <= full; a++) {
+        for (int b = 0; b <= full; b++) {
+            for (int setter = 0; setter < 2; setter++) {
+                solved.value[a][b][setter] = b == full ? 1.0 : (a == full ? 0.0 : 0.5);
+            }
+        }
+    }
+
+    for (int total = 2 * (full - 1); total >= 0; total--) {
+        for (int a = std::min(full - 1, total); a >= 0 && total - a < full; a--) {
+            int b = total - a;
+            // Player 0 setting hands out letters to player 1 and the other way round
+            double letterFor1 = solved.value[a][b + 1][takeTurns ? 1 : 0];
+            double letterFor0 = solved.value[a + 1][b][takeTurns ? 0 : 1];
+            double v0 = 0.5;
+            double v1 = 0.5;
+            for (int iteration = 0; iteration < 10000; iteration++) {
+                double best0 = 0.0;
+                double best1 = 1.0;
+                for (size_t t = 0; t < tricks; t++) {
+                    double p0 = solverProbability(chances[0][t]);
+                    double p1 = solverProbability(chances[1][t]);
+                    best0 = std::max(best0, trickValue(p0, p1, v1, letterFor1, rules.secondTry(b), takeTurns));
+                    best1 = std::min(best1, trickValue(p1, p0, v0, letterFor0, rules.secondTry(a), takeTurns));
+                }
+                double change = std::fabs(best0 - v0) + std::fabs(best1 - v1);
+                v0 = best0;
+                v1 = best1;
+                if (change < 1e-13) {
+                    break;
+                }
+            }
+            solved.value[a][b][0] = v0;
+            solved.value[a][b][1] = v1;
+        }
+    }
+    return solved;
+}
+
+// The setter's own chance of winning for `count` of the tricks they could set in this position,
+// starting at `first`
+inline std::vector<double> trickWinChances(const std::vector<std::vector<int>>& chances, const SolvedMatchup& solved,
+                                           const BotState& state, size_t first, size_t count) {
+    std::vector<double> result;
+    int setter = state.setter;
+    BotState switched = applyOutcome(state, SETTER_MISSED);
+    BotState letter = applyOutcome(state, RESPONDER_MISSED);
+    if (solved.takeTurns) {
+        letter.setter = switched.setter;
+    }
+    double other = solved.winChance(switched);
+    double afterLetter = solved.winChance(letter);
+    bool secondTry = solved.rules.secondTry(state.letters[1 - setter]);
+    size_t last = std::min(chances[setter].size(), first + count);
+    for (size_t t = first; t < last; t++) {
+        double forPlayer0 = trickValue(solverProbability(chances[setter][t]),
+                                       solverProbability(chances[1 - setter][t]),
+                                       other, afterLetter, secondTry, solved.takeTurns);
+        result.push_back(setter == 0 ? forPlayer0 : 1.0 - forPlayer0);
+    }
+    return result;
+}
+
+// The setter's own chance of winning for each trick they could set in this position
+inline std::vector<double> trickWinChances(const std::vector<std::vector<int>>& chances,
+                                           const SolvedMatchup& solved, const BotState& state) {
+    return trickWinChances(chances, solved, state, 0, chances[state.setter].size());
+}
+
+#endif // SKATE_SOLVER_H
@@ -0,0 +1,393 @@
+// Game of Skate - attempt statistics driver
+// Builds a columnar attempt store (see skate_store.h) from attempt logs and answers questions
+// about land rates from it.
+//
+// Usage:
+//   skate_stats import STORE LOG...          build STORE from attempt logs written with --log, or archives
+//   skate_stats pack ARCHIVE LOG...          compress attempt logs into an archive (see skate_codec.h)
+//   skate_stats unpack ARCHIVE [FIRST COUNT] write attempts of an archive back out as a log
+//   skate_stats generate STORE ROWS [opts]   build STORE from ROWS made-up attempts, for benchmarks
+//   skate_stats info STORE                   rows, blocks, players and size of STORE
+//   skate_stats query STORE [opts]           attempts, landings and land rate, as CSV
+//
+// Query options:
+//   --by LIST            group by any of player,month,difficulty,role,trick (comma separated)
+//   --player NAME        only this player's attempts
+//   --trick N            only attempts at trick N
+//   --from YYYY-MM       only attempts from the start of this month ...
+//   --to YYYY-MM         ... up to the end of this month
+//   --role R             only setter or responder attempts
+//   --difficulty A:B     only tricks of difficulty A to B
+//   --threads N          worker threads (default: all hardware threads)
+//
+// Generate options:
+//   --players N          made-up players (default 1000)
+//   --months N           months the attempts spread over, ending now (default 24)
+//   --seed N             random seed (default 1)
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <chrono>
+
+#include "skate_core.h"
+#include "skate_sim.h"
+#include "skate_store.h"
+#include "skate_codec.h"
+
+void printUsage() {
+    std::cout << "Usage: skate_stats import STORE LOG..." << std::endl;
+    std::cout << "       skate_stats pack ARCHIVE LOG..." << std::endl;
+    std::cout << "       skate_stats unpack ARCHIVE [FIRST COUNT]" << std::endl;
+    std::cout << "       skate_stats generate STORE ROWS [--players N] [--months N] [--seed N]" << std::endl;
+    std::cout << "       skate_stats info STORE" << std::endl;
+    std::cout << "       skate_stats query STORE [--by player,month,difficulty,role,trick] [--player NAME]" << std::endl;
+    std::cout << "                   [--trick N] [--from YYYY-MM] [--to YYYY-MM] [--role setter|responder]" << std::endl;
+    std::cout << "                   [--difficulty A:B] [--threads N]" << std::endl;
+}
+
+// "2024-03" as a monthIndex, or false
+bool parseMonth(const std::string& text, int& index) {
+    int year = 0;
+    int month = 0;
+    if (std::sscanf(text.c_str(), "%d-%d", &year, &month) != 2 || month < 1 || month > 12) {
+        return false;
+    }
+    index = (year - 1970) * 12 + month - 1;
+    return true;
+}
+
+std::string monthName(int index) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d-%02d", 1970 + index / 12, index % 12 + 1);
+    return text;
+}
+
+// One line of an attempt log; old logs without role and time count as responder attempts at time 0
+bool parseAttempt(const std::string& line, std::string& name, AttemptEvent& event) {
+    size_t a = line.find('\t');
+    size_t b = a == std::string::npos ? a : line.find('\t', a + 1);
+    if (b == std::string::npos) {
+        return false;
+    }
+    int trick = std::atoi(line.c_str() + a + 1);
+    if (trick < 0 || trick >= kDefaultTrickCount) {
+        return false;
+    }
+    name.assign(line, 0, a);
+    event.trick = static_cast<TrickId>(trick);
+    event.difficulty = static_cast<uint8_t>(kDefaultTricks[trick].difficulty);
+    event.landed = line.compare(b + 1, 1, "1") == 0 ? 1 : 0;
+    event.role = ROLE_RESPONDER;
+    event.time = 0;
+    size_t c = line.find('\t', b + 1);
+    if (c != std::string::npos && c + 1 < line.size()) {
+        event.role = line[c + 1] == 's' ? ROLE_SETTER : ROLE_RESPONDER;
+        size_t d = line.find('\t', c + 1);
+        if (d != std::string::npos) {
+            event.time = std::atoll(line.c_str() + d + 1);
+        }
+    }
+    return true;
+}
+
+int importLogs(const std::string& path, const std::vector<std::string>& logs) {
+    AttemptStoreWriter writer;
+    if (!writer.open(path)) {
+        std::cout << "Could not write " << path << std::endl;
+        return 1;
+    }
+    long rows = 0;
+    std::string line;
+    std::string name;
+    for (const std::string& log : logs) {
+        if (AttemptArchive::isArchive(log)) {
+            AttemptArchive archive;
+            std::vector<AttemptEvent> events;
+            if (!archive.open(log)) {
+                std::cout << "Could not read archive " << log << std::endl;
+                return 1;
+            }
+            for (size_t block = 0; block < archive.blocks(); block++) {
+                events.clear();
+                if (!archive.decodeBlock(block, events)) {
+                    std::cout << "Archive " << log << " is damaged" << std::endl;
+                    return 1;
+                }
+                for (AttemptEvent& event : events) {
+                    event.actor = writer.actor(archive.actorName(event.actor));
+                    writer.add(event);
+                }
+                rows += static_cast<long>(events.size());
+            }
+            continue;
+        }
+        std::ifstream in(log);
+        if (!in) {
+            std::cout << "Could not read attempt log " << log << std::endl;
+            return 1;
+        }
+        while (std::getline(in, line)) {
+            AttemptEvent event;
+            if (parseAttempt(line, name, event)) {
+                event.actor = writer.actor(name);
+                writer.add(event);
+                rows++;
+            }
+        }
+    }
+    if (!writer.close()) {
+        std::cout << "Could not write " << path << std::endl;
+        return 1;
+    }
+    std::cout << "Stored " << rows << " attempts in " << path << std::endl;
+    return 0;
+}
+
+int packLogs(const std::string& path, const std::vector<std::string>& logs) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cout << "Could not write " << path << std::endl;
+        return 1;
+    }
+    AttemptEncoder encoder(out);
+    long rows = 0;
+    uint64_t logBytes = 0;
+    std::string line;
+    std::string name;
+    for (const std::string& log : logs) {
+        std::ifstream in(log);
+        if (!in) {
+            std::cout << "Could not read attempt log " << log << std::endl;
+            return 1;
+        }
+        while (std::getline(in, line)) {
+            AttemptEvent event;
+            logBytes += line.size() + 1;
+            if (parseAttempt(line, name, event)) {
+                event.actor = encoder.actor(name);
+                encoder.add(event);
+                rows++;
+            }
+        }
+    }
+    if (!encoder.finish()) {
+        std::cout << "Could not write " << path << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << rows << " attempts (" << logBytes << " bytes of log) into " << encoder.bytesWritten()
+              << " bytes" << std::endl;
+    return 0;
+}
+
+// Writes attempts [first, first + count) of an archive as attempt log lines
+int unpack(const std::string& path, uint64_t first, uint64_t count) {
+    AttemptArchive archive;
+    if (!archive.open(path)) {
+        std::cout << "Could not read archive " << path << std::endl;
+        return 1;
+    }
+    count = std::min(count, archive.events() - std::min(first, archive.events()));
+    std::vector<AttemptEvent> events;
+    if (!archive.read(first, count, events)) {
+        std::cout << "Archive " << path << " is damaged" << std::endl;
+        return 1;
+    }
+    for (const AttemptEvent& event : events) {
+        std::cout << archive.actorName(event.actor) << '\t' << event.trick << '\t' << int(event.landed) << '\t'
+                  << (event.role == ROLE_SETTER ? 's' : 'r') << '\t' << event.time << '\n';
+    }
+    return 0;
+}
+
+// Made-up games: each one a run of attempts by two players within a few minutes, in time order
+int generate(const std::string& path, long rows, int players, int months, uint64_t seed) {
+    AttemptStoreWriter writer;
+    if (!writer.open(path)) {
+        std::cout << "Could not write " << path << std::endl;
+        return 1;
+    }
+    for (int p = 0; p < players; p++) {
+        writer.actor("Skater " + std::to_string(p + 1));
+    }
+    SimRng rng(seed);
+    int64_t end = static_cast<int64_t>(std::time(nullptr));
+    int64_t start = monthStart(monthIndex(end) - months + 1);
+    double step = static_cast<double>(end - start) / static_cast<double>(std::max(1L, rows));
+    for (long row = 0; row < rows;) {
+        uint32_t pair[2] = {static_cast<uint32_t>(rng.below(players)), static_cast<uint32_t>(rng.below(players))};
+        int length = 10 + rng.below(30);
+        for (int i = 0; i < length && row < rows; i++, row++) {
+            int trick = rng.below(kDefaultTrickCount);
+            AttemptEvent event;
+            event.role = static_cast<uint8_t>(i % 3 == 0 ? ROLE_SETTER : ROLE_RESPONDER);
+            event.actor = pair[(i / 3) & 1];
+            event.trick = static_cast<TrickId>(trick);
+            event.difficulty = static_cast<uint8_t>(kDefaultTricks[trick].difficulty);
+            event.landed = rng.roll() <= kDefaultTricks[trick].threshold ? 1 : 0;
+            event.time = start + static_cast<int64_t>(row * step);
+            writer.add(event);
+        }
+    }
+    if (!writer.close()) {
+        std::cout << "Could not write " << path << std::endl;
+        return 1;
+    }
+    std::cout << "Stored " << rows << " attempts in " << path << std::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if ((command != "import" && command != "pack" && command != "unpack" && command != "generate" &&
+         command != "info" && command != "query") || argc < 3) {
+        printUsage();
+        return 1;
+    }
+    std::string path = argv[2];
+
+    if (command == "import") {
+        return importLogs(path, std::vector<std::string>(argv + 3, argv + argc));
+    }
+    if (command == "pack") {
+        return packLogs(path, std::vector<std::string>(argv + 3, argv + argc));
+    }
+    if (command == "unpack") {
+        uint64_t first = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+        uint64_t count = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : ~0ULL;
+        return unpack(path, first, count);
+    }
+    if (command == "generate") {
+        if (argc < 4) {
+            printUsage();
+            return 1;
+        }
+        int players = 1000;
+        int months = 24;
+        uint64_t seed = 1;
+        for (int i = 4; i + 1 < argc; i += 2) {
+            std::string arg = argv[i];
+            if (arg == "--players") {
+                players = std::max(1, std::atoi(argv[i + 1]));
+            } else if (arg == "--months") {
+                months = std::max(1, std::atoi(argv[i + 1]));
+            } else if (arg == "--seed") {
+                seed = std::strtoull(argv[i + 1], nullptr, 10);
+            }
+        }
+        return generate(path, std::atol(argv[3]), players, months, seed);
+    }
+
+    AttemptStore store;
+    if (!store.open(path)) {
+        std::cout << "Could not read attempt store " << path << std::endl;
+        return 1;
+    }
+    if (command == "info") {
+        std::cout << store.rows() << " attempts by " << store.playerCount() << " players in " << store.blocks()
+                  << " blocks, " << store.bytes() << " bytes" << std::endl;
+        return 0;
+    }
+
+    AttemptQuery query;
+    int threads = 0;
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--by" && hasValue) {
+            std::string list = std::string(argv[++i]) + ",";
+            for (size_t from = 0, comma; (comma = list.find(',', from)) != std::string::npos; from = comma + 1) {
+                std::string column = list.substr(from, comma - from);
+                if (column == "player") {
+                    query.byActor = true;
+                } else if (column == "month") {
+                    query.byMonth = true;
+                } else if (column == "difficulty") {
+                    query.byDifficulty = true;
+                } else if (column == "role") {
+                    query.byRole = true;
+                } else if (column == "trick") {
+                    query.byTrick = true;
+                } else {
+                    std::cout << "Unknown column " << column << std::endl;
+                    return 1;
+                }
+            }
+        } else if (arg == "--player" && hasValue) {
+            query.actor = store.actor(argv[++i]);
+            if (query.actor < 0) {
+                std::cout << "No attempts by " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--trick" && hasValue) {
+            query.trick = std::atoi(argv[++i]);
+        } else if ((arg == "--from" || arg == "--to") && hasValue) {
+            int month;
+            if (!parseMonth(argv[++i], month)) {
+                std::cout << "Months look like 2024-03" << std::endl;
+                return 1;
+            }
+            if (arg == "--from") {
+                query.from = monthStart(month);
+            } else {
+                query.to = monthStart(month + 1);
+            }
+        } else if (arg == "--role" && hasValue) {
+            std::string role = argv[++i];
+            query.role = role == "setter" ? ROLE_SETTER : ROLE_RESPONDER;
+        } else if (arg == "--difficulty" && hasValue) {
+            if (std::sscanf(argv[++i], "%d:%d", &query.minDifficulty, &query.maxDifficulty) != 2) {
+                query.maxDifficulty = query.minDifficulty;
+            }
+        } else if (arg == "--threads" && hasValue) {
+            threads = std::atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    QueryStats stats;
+    std::vector<AttemptGroup> groups = store.query(query, threads, &stats);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::string header;
+    header += query.byActor ? "player," : "";
+    header += query.byMonth ? "month," : "";
+    header += query.byDifficulty ? "difficulty," : "";
+    header += query.byRole ? "role," : "";
+    header += query.byTrick ? "trick," : "";
+    std::cout << header << "attempts,landed,land_rate" << std::endl;
+    for (const AttemptGroup& group : groups) {
+        if (query.byActor) {
+            std::cout << store.actorName(group.actor) << ',';
+        }
+        if (query.byMonth) {
+            std::cout << monthName(group.month) << ',';
+        }
+        if (query.byDifficulty) {
+            std::cout << group.difficulty << ',';
+        }
+        if (query.byRole) {
+            std::cout << (group.role == ROLE_SETTER ? "setter" : "responder") << ',';
+        }
+        if (query.byTrick) {
+            std::cout << group.trick << ',';
+        }
+        std::cout << group.attempts << ',' << group.landed << ',' << std::fixed << std::setprecision(4)
+                  << static_cast<double>(group.landed) / static_cast<double>(group.attempts) << '\n';
+    }
+    std::cout.flush();
+    std::fprintf(stderr, "%llu of %llu attempts read from %llu blocks (%llu answered from zone maps, %llu skipped) in %.3f s\n",
+                 static_cast<unsigned long long>(stats.rowsScanned), static_cast<unsigned long long>(store.rows()),
+                 static_cast<unsigned long long>(stats.blocksScanned),
+                 static_cast<unsigned long long>(stats.blocksCounted),
+                 static_cast<unsigned long long>(stats.blocksSkipped), seconds);
+    return 0;
+}
@@ -0,0 +1,763 @@
+// Game of Skate - attempt store
+// Keeps every attempt ever logged in a columnar file for questions like "land rate by
+// difficulty by month by player".
+//
+// Attempts are cut into blocks of up to 64K rows and every block stores each column on its
+// own: trick, difficulty, player, landed, role and time. Each column is bit-packed at the
+// width its values need within the block, counted from the block's smallest value (players
+// are numbers from the file's name dictionary). A typical attempt takes about 5 bytes.
+//
+// The directory at the end of the file keeps a zone map per block: row and landed counts
+// and the range of every column. Queries skip blocks whose ranges cannot match, answer
+// blocks that match as a whole from the counts alone, and decode the rest 1024 rows at a
+// time into flat arrays, where filtering and counting are simple loops the compiler can
+// vectorize. Blocks are shared out to worker threads.
+
+#ifndef SKATE_STORE_H
+#define SKATE_STORE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "skate_core.h"
+
+// Rows per block
+const int kStoreBlockRows = 65536;
+
+// Rows a query decodes at a time
+const int kStoreChunkRows = 1024;
+
+// Tricks fit in the 7 bits a query key has for them
+const int kStoreMaxTricks = 128;
+
+enum AttemptRole {
+    ROLE_SETTER = 0,
+    ROLE_RESPONDER = 1
+};
+
+struct AttemptEvent {
+    uint32_t actor;     // index into the store's player dictionary
+    uint16_t trick;     // TrickId
+    uint8_t difficulty;
+    uint8_t landed;     // 0 or 1
+    uint8_t role;       // AttemptRole
+    int64_t time;       // seconds since 1970 (UTC)
+};
+
+// Months since January 1970 of a time in seconds since 1970 (UTC).
+// Days to civil date after Howard Hinnant's days_from_civil inverse.
+inline int monthIndex(int64_t time) {
+    int64_t days = (time >= 0 ? time : time - 86399) / 86400 + 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t shifted = (5 * dayOfYear + 2) / 153; // months from March
+    int64_t month = shifted < 10 ? shifted + 3 : shifted - 9;
+    int64_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    return static_cast<int>((year - 1970) * 12 + month - 1);
+}
+
+// First second of a month counted like monthIndex
+inline int64_t monthStart(int index) {
+    int64_t year = 1970 + (index >= 0 ? index / 12 : (index - 11) / 12);
+    int64_t month = index - (year - 1970) * 12 + 1;
+    year -= month <= 2 ? 1 : 0;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return (era * 146097 + dayOfEra - 719468) * 86400;
+}
+
+// Bits needed for values up to maxValue
+inline int bitsFor(uint64_t maxValue) {
+    int bits = 0;
+    while (bits < 64 && (maxValue >> bits) != 0) {
+        bits++;
+    }
+    return bits;
+}
+
+// Appends values - base, `width` bits each, to out (plus a spare word so reads never run off)
+inline void packBits(const std::vector<uint64_t>& values, uint64_t base, int width, std::vector<uint64_t>& out) {
+    if (width == 0) {
+        return;
+    }
+    size_t first = out.size();
+    out.resize(first + (values.size() * width + 63) / 64 + 1, 0);
+    uint64_t* words = out.data() + first;
+    for (size_t i = 0; i < values.size(); i++) {
+        uint64_t value = values[i] - base;
+        size_t bit = i * width;
+        size_t word = bit >> 6;
+        int offset = static_cast<int>(bit & 63);
+        words[word] |= value << offset;
+        if (offset + width > 64) {
+            words[word + 1] |= value >> (64 - offset);
+        }
+    }
+}
+
+// Reads count values starting at row `first` back into out
+template <typename T>
+inline void unpackBits(const uint64_t* words, size_t first, size_t count, int width, uint64_t base, T* out) {
+    if (width == 0) {
+        std::fill(out, out + count, static_cast<T>(base));
+        return;
+    }
+    uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    for (size_t i = 0; i < count; i++) {
+        size_t bit = (first + i) * width;
+        size_t word = bit >> 6;
+        int offset = static_cast<int>(bit & 63);
+        uint64_t value = words[word] >> offset;
+        if (offset + width > 64) {
+            value |= words[word + 1] << (64 - offset);
+        }
+        out[i] = static_cast<T>((value & mask) + base);
+    }
+}
+
+// Columns of a block, in file order
+enum StoreColumn {
+    COLUMN_TRICK,
+    COLUMN_DIFFICULTY,
+    COLUMN_ACTOR,
+    COLUMN_LANDED,
+    COLUMN_ROLE,
+    COLUMN_TIME,
+    kStoreColumns
+};
+
+// Directory entry of a block: where it is, and the zone map
+struct StoreZone {
+    uint64_t offset;                 // of the block in the file, in bytes
+    uint32_t column[kStoreColumns];  // start of each column, in words from the block
+    uint32_t rows;
+    uint32_t landed;
+    uint32_t minActor;
+    uint32_t maxActor;
+    int64_t minTime;
+    int64_t maxTime;
+    uint16_t minTrick;
+    uint16_t maxTrick;
+    uint8_t minDifficulty;
+    uint8_t maxDifficulty;
+    uint8_t roles;                   // bit 0: has setter attempts, bit 1: has responder attempts
+    uint8_t bits[kStoreColumns];     // packed width of each column
+    uint8_t padding[7];
+};
+
+struct StoreHeader {
+    char magic[8];
+    uint64_t rows;
+    uint64_t blocks;
+    uint64_t directoryOffset;
+    uint64_t dictionaryOffset; // player names, each a uint32 length and the bytes
+    uint64_t players;
+};
+
+// Empty slot of a query's group table; no group key has every bit set
+const uint64_t kNoGroup = ~0ULL;
+
+const char kStoreMagic[8] = {'S', 'K', 'C', 'O', 'L', 'S', '0', '1'};
+
+class AttemptStoreWriter {
+public:
+    AttemptStoreWriter() : rows(0), position(0) {}
+
+    bool open(const std::string& path) {
+        out.open(path, std::ios::binary | std::ios::trunc);
+        StoreHeader header = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        position = sizeof(header);
+        return static_cast<bool>(out);
+    }
+
+    // Dictionary number of a player, adding them if they are new
+    uint32_t actor(const std::string& name) {
+        std::unordered_map<std::string, uint32_t>::const_iterator it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(names.size());
+        ids[name] = id;
+        names.push_back(name);
+        return id;
+    }
+
+    // Tricks past kStoreMaxTricks are not stored
+    bool add(const AttemptEvent& event) {
+        if (event.trick >= kStoreMaxTricks) {
+            return false;
+        }
+        pending.push_back(event);
+        if (pending.size() == static_cast<size_t>(kStoreBlockRows)) {
+            flushBlock();
+        }
+        return true;
+    }
+
+    // Writes the last block, the directory and the dictionary
+    bool close() {
+        flushBlock();
+        StoreHeader header;
+        std::memcpy(header.magic, kStoreMagic, sizeof(kStoreMagic));
+        header.rows = rows;
+        header.blocks = zones.size();
+        header.directoryOffset = position;
+        out.write(reinterpret_cast<const char*>(zones.data()), zones.size() * sizeof(StoreZone));
+        header.dictionaryOffset = position + zones.size() * sizeof(StoreZone);
+        header.players = names.size();
+        for (const std::string& name : names) {
+            uint32_t length = static_cast<uint32_t>(name.size());
+            out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.write(name.data(), length);
+        }
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    void flushBlock() {
+        if (pending.empty()) {
+            return;
+        }
+        StoreZone zone = {};
+        zone.offset = position;
+        zone.rows = static_cast<uint32_t>(pending.size());
+        zone.minActor = zone.maxActor = pending[0].actor;
+        zone.minTime = zone.maxTime = pending[0].time;
+        zone.minTrick = zone.maxTrick = pending[0].trick;
+        zone.minDifficulty = zone.maxDifficulty = pending[0].difficulty;
+        for (const AttemptEvent& event : pending) {
+            zone.landed += event.landed;
+            zone.minActor = std::min(zone.minActor, event.actor);
+            zone.maxActor = std::max(zone.maxActor, event.actor);
+            zone.minTime = std::min(zone.minTime, event.time);
+            zone.maxTime = std::max(zone.maxTime, event.time);
+            zone.minTrick = std::min(zone.minTrick, event.trick);
+            zone.maxTrick = std::max(zone.maxTrick, event.trick);
+            zone.minDifficulty = std::min(zone.minDifficulty, event.difficulty);
+            zone.maxDifficulty = std::max(zone.maxDifficulty, event.difficulty);
+            zone.roles |= static_cast<uint8_t>(1 << event.role);
+        }
+
+        const uint64_t bases[kStoreColumns] = {zone.minTrick, zone.minDifficulty, zone.minActor, 0, 0,
+                                               static_cast<uint64_t>(zone.minTime)};
+        const uint64_t spans[kStoreColumns] = {
+            static_cast<uint64_t>(zone.maxTrick - zone.minTrick),
+            static_cast<uint64_t>(zone.maxDifficulty - zone.minDifficulty),
+            static_cast<uint64_t>(zone.maxActor - zone.minActor), 1, 1,
+            static_cast<uint64_t>(zone.maxTime) - static_cast<uint64_t>(zone.minTime)};
+        std::vector<uint64_t> words;
+        std::vector<uint64_t> values(pending.size());
+        for (int column = 0; column < kStoreColumns; column++) {
+            for (size_t i = 0; i < pending.size(); i++) {
+                values[i] = columnValue(pending[i], column);
+            }
+            zone.column[column] = static_cast<uint32_t>(words.size());
+            zone.bits[column] = static_cast<uint8_t>(bitsFor(spans[column]));
+            packBits(values, bases[column], zone.bits[column], words);
+        }
+        out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+        position += words.size() * sizeof(uint64_t);
+        rows += pending.size();
+        zones.push_back(zone);
+        pending.clear();
+    }
+
+    static uint64_t columnValue(const AttemptEvent& event, int column) {
+        switch (column) {
+        case COLUMN_TRICK:
+            return event.trick;
+        case COLUMN_DIFFICULTY:
+            return event.difficulty;
+        case COLUMN_ACTOR:
+            return event.actor;
+        case COLUMN_LANDED:
+            return event.landed;
+        case COLUMN_ROLE:
+            return event.role;
+        default:
+            return static_cast<uint64_t>(event.time);
+        }
+    }
+
+    std::ofstream out;
+    std::vector<AttemptEvent> pending;
+    std::vector<StoreZone> zones;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+    uint64_t rows;
+    uint64_t position;
+};
+
+// Which attempts to count and how to group them. Filters left at their defaults match everything.
+struct AttemptQuery {
+    int64_t from = std::numeric_limits<int64_t>::min(); // times in [from, to)
+    int64_t to = std::numeric_limits<int64_t>::max();
+    int64_t actor = -1; // dictionary number
+    int trick = -1;
+    int minDifficulty = 0;
+    int maxDifficulty = 255;
+    int role = -1;      // AttemptRole
+    bool byActor = false;
+    bool byMonth = false;
+    bool byDifficulty = false;
+    bool byRole = false;
+    bool byTrick = false;
+};
+
+// One group of a query's answer; columns not grouped by are 0
+struct AttemptGroup {
+    uint32_t actor;
+    int month; // months since January 1970
+    int difficulty;
+    int role;
+    int trick;
+    uint64_t attempts;
+    uint64_t landed;
+};
+
+struct QueryStats {
+    uint64_t blocksSkipped; // ruled out by their zone maps
+    uint64_t blocksCounted; // answered from their zone maps
+    uint64_t blocksScanned; // decoded
+    uint64_t rowsScanned;
+};
+
+class AttemptStore {
+public:
+    AttemptStore() : data(nullptr), size(0), mapped(false), header(nullptr), zones(nullptr) {}
+
+    ~AttemptStore() {
+        close();
+    }
+
+    AttemptStore(const AttemptStore&) = delete;
+    AttemptStore& operator=(const AttemptStore&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        void* map = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            size = static_cast<size_t>(info.st_size);
+            map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const char*>(map);
+        mapped = true;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data = copy.data();
+        size = copy.size();
+#endif
+        if (size < sizeof(StoreHeader)) {
+            return false;
+        }
+        header = reinterpret_cast<const StoreHeader*>(data);
+        if (std::memcmp(header->magic, kStoreMagic, sizeof(kStoreMagic)) != 0 || header->directoryOffset > size ||
+            header->directoryOffset % sizeof(uint64_t) != 0 ||
+            header->blocks > (size - header->directoryOffset) / sizeof(StoreZone) || header->dictionaryOffset > size) {
+            return false;
+        }
+        zones = reinterpret_cast<const StoreZone*>(data + header->directoryOffset);
+        for (uint64_t b = 0; b < header->blocks; b++) {
+            if (!zoneFits(zones[b])) {
+                return false;
+            }
+        }
+        const char* p = data + header->dictionaryOffset;
+        for (uint64_t i = 0; i < header->players; i++) {
+            uint32_t length;
+            if (sizeof(length) > static_cast<size_t>(data + size - p)) {
+                return false;
+            }
+            std::memcpy(&length, p, sizeof(length));
+            p += sizeof(length);
+            if (length > static_cast<size_t>(data + size - p)) {
+                return false;
+            }
+            names.push_back(std::string(p, length));
+            ids[names.back()] = static_cast<uint32_t>(i);
+            p += length;
+        }
+        return true;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (mapped) {
+            ::munmap(const_cast<char*>(data), size);
+        }
+#endif
+        copy.clear();
+        names.clear();
+        ids.clear();
+        data = nullptr;
+        size = 0;
+        mapped = false;
+        header = nullptr;
+        zones = nullptr;
+    }
+
+    uint64_t rows() const {
+        return header ? header->rows : 0;
+    }
+
+    uint64_t blocks() const {
+        return header ? header->blocks : 0;
+    }
+
+    size_t bytes() const {
+        return size;
+    }
+
+    size_t playerCount() const {
+        return names.size();
+    }
+
+    // Dictionary number of a player, or -1
+    int64_t actor(const std::string& name) const {
+        std::unordered_map<std::string, uint32_t>::const_iterator it = ids.find(name);
+        return it == ids.end() ? -1 : static_cast<int64_t>(it->second);
+    }
+
+    const std::string& actorName(uint32_t actor) const {
+        return names[actor];
+    }
+
+    // Attempts and landings per group, sorted by group. threads = 0 uses every hardware thread.
+    std::vector<AttemptGroup> query(const AttemptQuery& query, int threads = 0, QueryStats* stats = nullptr) const {
+        if (threads <= 0) {
+            threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+        threads = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(threads), std::max<uint64_t>(1, blocks())));
+        std::vector<GroupTable> tables(threads);
+        std::vector<QueryStats> counts(threads, QueryStats{0, 0, 0, 0});
+        std::atomic<uint64_t> nextBlock(0);
+        auto worker = [&](int t) {
+            for (uint64_t block = nextBlock++; block < blocks(); block = nextBlock++) {
+                scanBlock(zones[block], query, tables[t], counts[t]);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; t++) {
+            workers.emplace_back(worker, t);
+        }
+        worker(0);
+        for (auto& thread : workers) {
+            thread.join();
+        }
+
+        GroupTable& total = tables[0];
+        for (int t = 1; t < threads; t++) {
+            tables[t].mergeInto(total);
+        }
+        if (stats) {
+            *stats = QueryStats{0, 0, 0, 0};
+            for (const QueryStats& c : counts) {
+                stats->blocksSkipped += c.blocksSkipped;
+                stats->blocksCounted += c.blocksCounted;
+                stats->blocksScanned += c.blocksScanned;
+                stats->rowsScanned += c.rowsScanned;
+            }
+        }
+
+        std::vector<AttemptGroup> groups;
+        for (size_t slot = 0; slot < total.keys.size(); slot++) {
+            if (total.keys[slot] != kNoGroup) {
+                groups.push_back(groupOf(total.keys[slot], total.attempts[slot], total.landed[slot]));
+            }
+        }
+        std::sort(groups.begin(), groups.end(), [](const AttemptGroup& a, const AttemptGroup& b) {
+            if (a.actor != b.actor) return a.actor < b.actor;
+            if (a.month != b.month) return a.month < b.month;
+            if (a.difficulty != b.difficulty) return a.difficulty < b.difficulty;
+            if (a.role != b.role) return a.role < b.role;
+            return a.trick < b.trick;
+        });
+        return groups;
+    }
+
+private:
+    // Does every column of the block lie inside the file? The scan trusts the zone after this.
+    bool zoneFits(const StoreZone& zone) const {
+        if (zone.offset > size || zone.offset % sizeof(uint64_t) != 0 ||
+            zone.rows > static_cast<uint32_t>(kStoreBlockRows)) {
+            return false;
+        }
+        uint64_t words = (size - zone.offset) / sizeof(uint64_t);
+        for (int column = 0; column < kStoreColumns; column++) {
+            if (zone.bits[column] > 64) {
+                return false;
+            }
+            uint64_t needed = (static_cast<uint64_t>(zone.rows) * zone.bits[column] + 63) / 64;
+            if (zone.column[column] > words || needed > words - zone.column[column]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Group key: actor (32 bits), month (16), difficulty (8), role (1), trick (7)
+    static uint64_t groupKey(uint64_t actor, uint64_t month, uint64_t difficulty, uint64_t role, uint64_t trick) {
+        return (actor << 32) | (month << 16) | (difficulty << 8) | (role << 7) | trick;
+    }
+
+    static AttemptGroup groupOf(uint64_t key, uint64_t attempts, uint64_t landed) {
+        AttemptGroup group = {static_cast<uint32_t>(key >> 32), static_cast<int>((key >> 16) & 0xFFFF),
+                              static_cast<int>((key >> 8) & 0xFF), static_cast<int>((key >> 7) & 1),
+                              static_cast<int>(key & 0x7F), attempts, landed};
+        return group;
+    }
+
+    // Open addressing hash table of group counts
+    struct GroupTable {
+        std::vector<uint64_t> keys;
+        std::vector<uint64_t> attempts;
+        std::vector<uint64_t> landed;
+        size_t used = 0;
+
+        GroupTable() : keys(64, kNoGroup), attempts(64, 0), landed(64, 0) {}
+
+        void add(uint64_t key, uint64_t tries, uint64_t lands) {
+            size_t mask = keys.size() - 1;
+            size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 20) & mask;
+            while (keys[slot] != key && keys[slot] != kNoGroup) {
+                slot = (slot + 1) & mask;
+            }
+            if (keys[slot] == kNoGroup) {
+                keys[slot] = key;
+                if (++used * 2 > keys.size()) {
+                    attempts[slot] += tries;
+                    landed[slot] += lands;
+                    grow();
+                    return;
+                }
+            }
+            attempts[slot] += tries;
+            landed[slot] += lands;
+        }
+
+        void grow() {
+            GroupTable bigger;
+            bigger.keys.assign(keys.size() * 2, kNoGroup);
+            bigger.attempts.assign(keys.size() * 2, 0);
+            bigger.landed.assign(keys.size() * 2, 0);
+            mergeInto(bigger);
+            std::swap(*this, bigger);
+        }
+
+        void mergeInto(GroupTable& other) const {
+            for (size_t slot = 0; slot < keys.size(); slot++) {
+                if (keys[slot] != kNoGroup) {
+                    other.add(keys[slot], attempts[slot], landed[slot]);
+                }
+            }
+        }
+    };
+
+    void scanBlock(const StoreZone& zone, const AttemptQuery& query, GroupTable& table, QueryStats& stats) const {
+        // Zone map: can anything in the block match?
+        bool wantsRole = query.role >= 0;
+        if (zone.maxTime < query.from || zone.minTime >= query.to ||
+            (query.actor >= 0 && (query.actor < zone.minActor || query.actor > zone.maxActor)) ||
+            (query.trick >= 0 && (query.trick < zone.minTrick || query.trick > zone.maxTrick)) ||
+            zone.maxDifficulty < query.minDifficulty || zone.minDifficulty > query.maxDifficulty ||
+            (wantsRole && !(zone.roles & (1 << query.role)))) {
+            stats.blocksSkipped++;
+            return;
+        }
+
+        // Does everything in the block match, and fall in one group? Then the counts answer it.
+        int firstMonth = monthIndex(zone.minTime);
+        bool allMatch = zone.minTime >= query.from && zone.maxTime < query.to &&
+                        (query.actor < 0 || (zone.minActor == query.actor && zone.maxActor == query.actor)) &&
+                        (query.trick < 0 || (zone.minTrick == query.trick && zone.maxTrick == query.trick)) &&
+                        zone.minDifficulty >= query.minDifficulty && zone.maxDifficulty <= query.maxDifficulty &&
+                        (!wantsRole || zone.roles == (1 << query.role));
+        bool oneGroup = (!query.byActor || zone.minActor == zone.maxActor) &&
+                        (!query.byMonth || firstMonth == monthIndex(zone.maxTime)) &&
+                        (!query.byDifficulty || zone.minDifficulty == zone.maxDifficulty) &&
+                        (!query.byRole || zone.roles != 3) &&
+                        (!query.byTrick || zone.minTrick == zone.maxTrick);
+        if (allMatch && oneGroup) {
+            table.add(groupKey(query.byActor ? zone.minActor : 0, query.byMonth ? std::max(0, firstMonth) : 0,
+                               query.byDifficulty ? zone.minDifficulty : 0, query.byRole ? (zone.roles >> 1) : 0,
+                               query.byTrick ? zone.minTrick : 0),
+                      zone.rows, zone.landed);
+            stats.blocksCounted++;
+            return;
+        }
+        stats.blocksScanned++;
+        stats.rowsScanned += zone.rows;
+
+        const uint64_t* words = reinterpret_cast<const uint64_t*>(data + zone.offset);
+        const bool readTime = query.byMonth || zone.minTime < query.from || zone.maxTime >= query.to;
+        const bool sameMonth = firstMonth == monthIndex(zone.maxTime);
+        // Only the columns the query filters or groups on here are decoded
+        const bool readDifficulty = query.byDifficulty || zone.minDifficulty < query.minDifficulty ||
+                                  zone.maxDifficulty > query.maxDifficulty;
+        const bool readActor = query.byActor || query.actor >= 0;
+        const bool readTrick = query.byTrick || query.trick >= 0;
+        const bool readRole = query.byRole || wantsRole;
+        int64_t times[kStoreChunkRows];
+        uint32_t actors[kStoreChunkRows];
+        uint32_t tricks[kStoreChunkRows];
+        uint32_t difficulties[kStoreChunkRows];
+        uint32_t roles[kStoreChunkRows];
+        uint32_t landed[kStoreChunkRows];
+        uint32_t months[kStoreChunkRows];
+        uint8_t keep[kStoreChunkRows];
+
+        for (uint32_t first = 0; first < zone.rows; first += kStoreChunkRows) {
+            size_t count = std::min<size_t>(kStoreChunkRows, zone.rows - first);
+            unpackColumn(zone, words, COLUMN_LANDED, 0, first, count, landed);
+            if (readDifficulty) {
+                unpackColumn(zone, words, COLUMN_DIFFICULTY, zone.minDifficulty, first, count, difficulties);
+            }
+            if (readActor) {
+                unpackColumn(zone, words, COLUMN_ACTOR, zone.minActor, first, count, actors);
+            }
+            if (readTrick) {
+                unpackColumn(zone, words, COLUMN_TRICK, zone.minTrick, first, count, tricks);
+            }
+            if (readRole) {
+                unpackColumn(zone, words, COLUMN_ROLE, 0, first, count, roles);
+            }
+            if (readTime) {
+                unpackColumn(zone, words, COLUMN_TIME, static_cast<uint64_t>(zone.minTime), first, count, times);
+            }
+
+            // Filters: branch-free, one pass per column
+            const uint32_t minDifficulty = static_cast<uint32_t>(std::max(0, query.minDifficulty));
+            const uint32_t maxDifficulty = static_cast<uint32_t>(std::max(0, query.maxDifficulty));
+            std::fill(keep, keep + count, static_cast<uint8_t>(1));
+            if (readDifficulty) {
+                for (size_t i = 0; i < count; i++) {
+                    keep[i] = static_cast<uint8_t>((difficulties[i] >= minDifficulty) & (difficulties[i] <= maxDifficulty));
+                }
+            }
+            if (readTime) {
+                for (size_t i = 0; i < count; i++) {
+                    keep[i] &= static_cast<uint8_t>((times[i] >= query.from) & (times[i] < query.to));
+                }
+            }
+            if (query.actor >= 0) {
+                const uint32_t actor = static_cast<uint32_t>(query.actor);
+                for (size_t i = 0; i < count; i++) {
+                    keep[i] &= static_cast<uint8_t>(actors[i] == actor);
+                }
+            }
+            if (query.trick >= 0) {
+                const uint32_t trick = static_cast<uint32_t>(query.trick);
+                for (size_t i = 0; i < count; i++) {
+                    keep[i] &= static_cast<uint8_t>(tricks[i] == trick);
+                }
+            }
+            if (wantsRole) {
+                const uint32_t role = static_cast<uint32_t>(query.role);
+                for (size_t i = 0; i < count; i++) {
+                    keep[i] &= static_cast<uint8_t>(roles[i] == role);
+                }
+            }
+
+            bool grouped = query.byActor || query.byMonth || query.byDifficulty || query.byRole || query.byTrick;
+            if (!grouped) {
+                uint64_t tries = 0;
+                uint64_t lands = 0;
+                for (size_t i = 0; i < count; i++) {
+                    tries += keep[i];
+                    lands += keep[i] & landed[i];
+                }
+                if (tries > 0) {
+                    table.add(0, tries, lands);
+                }
+                continue;
+            }
+
+            if (query.byMonth) {
+                for (size_t i = 0; i < count; i++) {
+                    months[i] = static_cast<uint32_t>(std::max(0, sameMonth ? firstMonth : monthIndex(times[i])));
+                }
+            }
+            // Runs of rows in the same group (one player's game, say) are added in one go
+            uint64_t runKey = kNoGroup;
+            uint64_t runTries = 0;
+            uint64_t runLands = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (!keep[i]) {
+                    continue;
+                }
+                uint64_t key = groupKey(query.byActor ? actors[i] : 0, query.byMonth ? months[i] : 0,
+                                        query.byDifficulty ? difficulties[i] : 0, query.byRole ? roles[i] : 0,
+                                        query.byTrick ? tricks[i] : 0);
+                if (key != runKey) {
+                    if (runTries > 0) {
+                        table.add(runKey, runTries, runLands);
+                    }
+                    runKey = key;
+                    runTries = 0;
+                    runLands = 0;
+                }
+                runTries++;
+                runLands += landed[i];
+            }
+            if (runTries > 0) {
+                table.add(runKey, runTries, runLands);
+            }
+        }
+    }
+
+    template <typename T>
+    static void unpackColumn(const StoreZone& zone, const uint64_t* words, int column, uint64_t base,
+                             size_t first, size_t count, T* out) {
+        unpackBits(words + zone.column[column], first, count, zone.bits[column], base, out);
+    }
+
+    const char* data;
+    size_t size;
+    bool mapped;
+    std::vector<char> copy;
+    const StoreHeader* header;
+    const StoreZone* zones;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+#endif // SKATE_STORE_H
@@ -0,0 +1,206 @@
+// Game of Skate - balance sweeps
+// Simulates many variants of the success formula (base, slope and the top of the difficulty
+// scale) and measures how balanced, how long and how varied the resulting games are.
+//
+// Points are shared out to worker threads. Variants that end up with exactly the same
+// success table (common once chances are clamped to 0-100 and difficulties rounded) are
+// simulated once and the result is reused. Every point plays on the same seed, so
+// neighbouring points are compared on the same rolls.
+
+#ifndef SKATE_SWEEP_H
+#define SKATE_SWEEP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skate_core.h"
+#include "skate_sim.h"
+
+struct SweepPoint {
+    SuccessCurve curve;
+    int maxDifficulty; // the default tricks' 1-10 difficulties are stretched onto 1-maxDifficulty
+};
+
+struct SweepResult {
+    SweepPoint point;
+    double firstSetterWins; // chance that the player who sets first wins
+    double stdError;
+    double balance;         // distance of firstSetterWins from 50/50
+    double averageRounds;
+    int viableTricks;       // tricks worth setting, see viableTricks()
+    long games;
+    bool reused;            // same success table as an earlier point, not simulated again
+};
+
+// An inclusive range of integer values: from, from + step, ... up to to
+struct SweepRange {
+    int from;
+    int to;
+    int step;
+};
+
+inline int scaleDifficulty(int difficulty, int maxDifficulty) {
+    return static_cast<int>(std::lround(1.0 + (difficulty - 1) * (maxDifficulty - 1) / 9.0));
+}
+
+// Success chances of the default tricks under a sweep point, clamped to 0-100
+inline std::vector<int> sweepChances(const SweepPoint& point) {
+    std::vector<int> chances;
+    for (int difficulty : kDefaultTrickDifficulties) {
+        int chance = successChance(scaleDifficulty(difficulty, point.maxDifficulty), point.curve);
+        chances.push_back(std::min(100, std::max(0, chance)));
+    }
+    return chances;
+}
+
+// Number of tricks whose chance of handing out a letter is within 10% of the best trick's.
+// One means every sensible setter sets the same trick; higher means more variety.
+inline int viableTricks(const std::vector<int>& chances) {
+    int best = 0;
+    for (int chance : chances) {
+        best = std::max(best, chance * (100 - chance));
+    }
+    if (best == 0) {
+        return 0;
+    }
+    int viable = 0;
+    for (int chance : chances) {
+        if (chance * (100 - chance) * 10 >= best * 9) {
+            viable++;
+        }
+    }
+    return viable;
+}
+
+inline std::vector<SweepPoint> gridPoints(const SweepRange& base, const SweepRange& slope,
+                                          const SweepRange& scale) {
+    std::vector<SweepPoint> points;
+    for (int b = base.from; b <= base.to; b += std::max(1, base.step)) {
+        for (int s = slope.from; s <= slope.to; s += std::max(1, slope.step)) {
+            for (int m = scale.from; m <= scale.to; m += std::max(1, scale.step)) {
+                SweepPoint point = {{b, s}, m};
+                points.push_back(point);
+            }
+        }
+    }
+    return points;
+}
+
+// Latin hypercube: every parameter's range is cut into `count` strata and each stratum is
+// used by exactly one point, so a few points still cover every range evenly
+inline std::vector<SweepPoint> latinHypercubePoints(const SweepRange& base, const SweepRange& slope,
+                                                    const SweepRange& scale, int count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> within(0.0, 1.0);
+    const SweepRange* ranges[3] = {&base, &slope, &scale};
+    std::vector<std::vector<int>> values(3, std::vector<int>(count));
+    for (int dim = 0; dim < 3; dim++) {
+        std::vector<int> strata(count);
+        for (int i = 0; i < count; i++) {
+            strata[i] = i;
+        }
+        std::shuffle(strata.begin(), strata.end(), rng);
+        double span = ranges[dim]->to - ranges[dim]->from;
+        for (int i = 0; i < count; i++) {
+            double x = (strata[i] + within(rng)) / count;
+            values[dim][i] = ranges[dim]->from + static_cast<int>(std::lround(x * span));
+        }
+    }
+    std::vector<SweepPoint> points;
+    for (int i = 0; i < count; i++) {
+        SweepPoint point = {{values[0][i], values[1][i]}, values[2][i]};
+        points.push_back(point);
+    }
+    return points;
+}
+
+// Simulates every point with both players setting by `strategy`.
+// Each point runs on a single thread; options.threads is the number of points in flight.
+inline std::vector<SweepResult> runSweep(const std::vector<SweepPoint>& points, const Strategy& strategy,
+                                         const SimOptions& options) {
+    struct Measured {
+        double firstSetterWins;
+        double stdError;
+        double averageRounds;
+        long games;
+    };
+
+    std::vector<SweepResult> results(points.size());
+    std::map<std::vector<int>, std::shared_future<Measured>> measured;
+    std::mutex measuredLock;
+    std::atomic<size_t> next(0);
+
+    auto worker = [&](int) {
+        // The sweep's workers are the ones pinned
+        SimOptions pointOptions = options;
+        pointOptions.threads = 1;
+        pointOptions.pin = false;
+        long games = 0;
+        while (true) {
+            size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= points.size()) {
+                return games;
+            }
+            std::vector<int> chances = sweepChances(points[index]);
+
+            // The first thread to reach a success table simulates it; later ones wait for its result
+            std::promise<Measured> promise;
+            std::shared_future<Measured> result;
+            bool owner = false;
+            {
+                std::lock_guard<std::mutex> guard(measuredLock);
+                auto it = measured.find(chances);
+                if (it == measured.end()) {
+                    result = promise.get_future().share();
+                    measured[chances] = result;
+                    owner = true;
+                } else {
+                    result = it->second;
+                }
+            }
+            if (owner) {
+                Matchup matchup = defaultMatchup();
+                matchup.chances.assign(2, chances);
+                matchup.strategy[0] = strategy;
+                matchup.strategy[1] = strategy;
+                WinEstimate estimate = estimateWinProbability(matchup, pointOptions);
+                Measured m = {estimate.value, estimate.stdError, estimate.averageRounds, estimate.games};
+                promise.set_value(m);
+            }
+
+            const Measured& m = result.get();
+            SweepResult& out = results[index];
+            out.point = points[index];
+            out.firstSetterWins = m.firstSetterWins;
+            out.stdError = m.stdError;
+            out.balance = std::fabs(m.firstSetterWins - 0.5);
+            out.averageRounds = m.averageRounds;
+            out.viableTricks = viableTricks(chances);
+            out.games = owner ? m.games : 0;
+            out.reused = !owner;
+            games += out.games;
+        }
+    };
+    runWorkers(simThreads(options), options.pin, worker);
+    return results;
+}
+
+inline void writeSweepTable(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "base,slope,max_difficulty,first_setter_wins,std_error,balance,average_rounds,viable_tricks,games,reused\n";
+    for (const auto& r : results) {
+        out << r.point.curve.base << ',' << r.point.curve.slope << ',' << r.point.maxDifficulty << ','
+            << r.firstSetterWins << ',' << r.stdError << ',' << r.balance << ',' << r.averageRounds << ','
+            << r.viableTricks << ',' << r.games << ',' << (r.reused ? 1 : 0) << '\n';
+    }
+}
+
+#endif // SKATE_SWEEP_H
@@ -1,7 +1,38 @@
 #include <iostream>
+#include <atomic>
 #include <cassert>
 #include <sstream>
 #include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "skate_bot.h"
+#include "skate_skill.h"
+#include "skate_sim.h"
+#include "skate_sweep.h"
+#include "skate_rules.h"
+#include "skate_house.h"
+#include "skate_solver.h"
+#include "skate_cache.h"
+#include "skate_session.h"
+#include "skate_turns.h"
+#include "skate_broadcast.h"
+#include "skate_leaderboard.h"
+#include "skate_store.h"
+#include "skate_codec.h"
+#include "skate_replay.h"
+#include "skate_odds.h"
+#include "skate_handicap.h"
+#include "skate_trace.h"
+#include "skate_latency.h"
+#include "skate_arena.h"
 
 
 class TestTrick {
@@ -17,18 +48,23 @@ class TestPlayer {
 public:
     std::string name;
     std::string letters;
+    std::string word;
+
+    TestPlayer(std::string n, std::string w = RuleSet().word()) : name(n), letters(""), word(w) {}
 
-    TestPlayer(std::string n) : name(n), letters("") {}
+    void reset(const std::string& n) {
+        name = n;
+        letters.clear();
+    }
 
     void addLetter() {
-        std::string skate = "SKATE";
-        if (letters.length() < 5) {
-            letters += skate[letters.length()];
+        if (letters.length() < word.length()) {
+            letters += word[letters.length()];
         }
     }
 
     bool hasLost() {
-        return letters == "SKATE";
+        return letters == word;
     }
 };
 
@@ -65,6 +101,11 @@ void testHasLost() {
     assert(!player.hasLost());
     player.letters = "SKATE";
     assert(player.hasLost());
+    
+    // A reused player slot starts clean
+    player.reset("NextPlayer");
+    assert(player.name == "NextPlayer");
+    assert(player.letters.empty() && !player.hasLost());
     std::cout << "✅ Has lost test passed" << std::endl;
 }
 
@@ -124,6 +165,40 @@ void testTrickSuccess() {
     std::cout << "✅ Trick success calculation test passed" << std::endl;
 }
 
+// Test the built-in trick catalog and its precomputed thresholds
+void testTrickCatalog() {
+    // Worked out by the compiler
+    static_assert(kDefaultTricks[0].threshold == 87, "Ollie threshold");
+    static_assert(kDefaultTricks[17].threshold == 23, "Impossible Late Flip threshold");
+    
+    assert(kDefaultCatalog.size() == static_cast<size_t>(kDefaultTrickCount));
+    for (int i = 0; i < kDefaultTrickCount; i++) {
+        const TrickInfo& trick = kDefaultCatalog[i];
+        assert(trick.difficulty == kDefaultTrickDifficulties[i]);
+        assert(trick.threshold == 95 - trick.difficulty * 8);
+        assert(trickThreshold(trick, kDefaultCurve) == trick.threshold);
+    }
+    assert(std::string(kDefaultCatalog[1].name) == "Kickflip");
+    
+    // Handles are two bytes and every view hands out the same interned name
+    static_assert(sizeof(TrickId) == 2, "TrickId stays compact");
+    TrickId kickflip = 1;
+    assert(kDefaultCatalog.name(kickflip) == kDefaultTricks[1].name);
+    
+    // Every game shares the one catalog
+    std::shared_ptr<const TrickCatalog> first = sharedDefaultCatalog();
+    std::shared_ptr<const TrickCatalog> second = sharedDefaultCatalog();
+    assert(first.get() == second.get());
+    assert(first.use_count() >= 3);
+    assert(first->name(kickflip) == kDefaultCatalog.name(kickflip));
+    assert((*first)[0].threshold == kDefaultTricks[0].threshold);
+    
+    SuccessCurve kinder = {100, 5};
+    assert(trickThreshold(kDefaultCatalog[0], kinder) == 95);
+    
+    std::cout << "✅ Trick catalog test passed" << std::endl;
+}
+
 // Integration test that simulates a simple game
 void testGameFlow() {
     TestPlayer player1("Player1");
@@ -185,6 +260,1672 @@ void testEdgeCases() {
     std::cout << "✅ Edge cases test passed" << std::endl;
 }
 
+// Test the round outcomes the computer opponent searches over
+void testBotRoundOutcomes() {
+    BotState state = {{0, 0}, 0};
+    
+    // Setter misses: roles switch
+    BotState next = applyOutcome(state, SETTER_MISSED);
+    assert(next.setter == 1);
+    assert(next.letters[0] == 0 && next.letters[1] == 0);
+    
+    // Responder misses: responder gets a letter, setter keeps setting
+    next = applyOutcome(state, RESPONDER_MISSED);
+    assert(next.setter == 0);
+    assert(next.letters[1] == 1);
+    
+    // Both land: nothing changes
+    next = applyOutcome(state, BOTH_LANDED);
+    assert(next.setter == 0 && next.letters[0] == 0 && next.letters[1] == 0);
+    
+    // Fifth letter ends the game
+    state.letters[1] = 4;
+    next = applyOutcome(state, RESPONDER_MISSED);
+    assert(next.isOver());
+    assert(next.winner() == 0);
+    
+    std::cout << "✅ Bot round outcome test passed" << std::endl;
+}
+
+// Test the greedy baseline and the tree search on a position with an obvious best trick
+void testBotChoosesTrick() {
+    // At 4 letters each, trick 0 wins on the spot: player 1 always lands it, player 2 never does
+    std::vector<std::vector<int>> chances = {{100, 50, 10}, {0, 90, 90}};
+    BotState state = {{4, 4}, 0};
+    
+    assert(greedyTrick(chances, state) == 0);
+    
+    MctsBot bot(chances, 2, 1 << 12);
+    bot.setSeed(42);
+    int choice = bot.chooseTrick(state, std::chrono::milliseconds(5000), 2000);
+    assert(choice == 0);
+    assert(bot.lastStats().iterations == 2000);
+    assert(bot.lastStats().nodesUsed <= (1 << 12));
+    
+    // Trick 0 should have soaked up most of the search
+    std::vector<int> visits = bot.rootVisits();
+    assert(visits[0] > visits[1] && visits[0] > visits[2]);
+    
+    std::cout << "✅ Bot trick choice test passed" << std::endl;
+}
+
+// Test that the tree search plays by the house rules of the game, not by SKATE
+void testBotPlaysHouseRules() {
+    const TrickInfo tricks[] = {{"Easy", 1, successChance(1)}, {"Hard", 7, successChance(7)},
+                                {"Trap", 1, successChance(1)}};
+    TrickCatalog catalog = {tricks, 3};
+    // Player 2 always lands the trap trick and player 1 never does, so once player 1 stops
+    // setting they lose. Setting Easy wins after two letters (64%), Hard after one (70%).
+    std::vector<std::vector<int>> chances = {{80, 70, 0}, {0, 0, 100}};
+    HouseRules house;
+    house.word = "SKATEBRD";
+    house.award[7] = house.award[8] = house.award[9] = house.award[10] = 2;
+    CompiledRules table = compileHouseRules(house, catalog);
+    BotState state = {{7, 6}, 0};
+    
+    MctsBot bot(chances, table, 1, 1 << 12);
+    bot.setSeed(7);
+    assert(bot.chooseTrick(state, std::chrono::milliseconds(5000), 20000) == 1);
+    
+    // Hard only hands out one letter by the plain rules, and then Easy is the better trick
+    house.award[7] = house.award[8] = house.award[9] = house.award[10] = 1;
+    MctsBot plain(chances, compileHouseRules(house, catalog), 1, 1 << 12);
+    plain.setSeed(7);
+    assert(plain.chooseTrick(state, std::chrono::milliseconds(5000), 20000) == 0);
+    
+    // Tricks the rules forbid are never set
+    house.maxDifficulty = 6;
+    MctsBot limited(chances, compileHouseRules(house, catalog), 1, 1 << 12);
+    limited.setSeed(7);
+    assert(limited.chooseTrick(state, std::chrono::milliseconds(5000), 2000) == 0);
+    assert(limited.rootVisits()[1] == 0);
+    
+    std::cout << "✅ Bot house rules test passed" << std::endl;
+}
+
+// Test that the tree search counts the second try on the last letter
+void testBotLastLetterRetry() {
+    const TrickInfo tricks[] = {{"Sure", 2, successChance(2)}, {"Shaky", 4, successChance(4)},
+                                {"Trap", 1, successChance(1)}};
+    TrickCatalog catalog = {tricks, 3};
+    // At 4 letters each, whoever stops setting loses to the trap trick. With one try, setting Sure
+    // wins 82% of the time before player 1 misses it, Shaky 75%; a second try drops Sure to 69%.
+    std::vector<std::vector<int>> chances = {{90, 75, 0}, {50, 0, 100}};
+    BotState state = {{4, 4}, 0};
+    RuleSet rules;
+    
+    MctsBot oneTry(chances, compileHouseRules(houseRulesFor(rules), catalog), 1, 1 << 12);
+    oneTry.setSeed(11);
+    assert(oneTry.chooseTrick(state, std::chrono::milliseconds(5000), 20000) == 0);
+    
+    rules.lastLetterRetry = true;
+    MctsBot twoTries(chances, compileHouseRules(houseRulesFor(rules), catalog), 1, 1 << 12);
+    twoTries.setSeed(11);
+    assert(twoTries.chooseTrick(state, std::chrono::milliseconds(5000), 20000) == 1);
+    
+    std::cout << "✅ Bot last letter retry test passed" << std::endl;
+}
+
+// Test fitting per-player chances from attempt counts
+void testSkillFitter() {
+    // Two tricks: an Ollie (formula says 87%) and an Impossible Late Flip (23%)
+    std::vector<int> difficulties = {1, 9};
+    
+    // Without a prior the estimate is plain landed / attempts
+    SkillFitter plain(difficulties, 0.0);
+    int jon = plain.addPlayer("Jon");
+    for (int i = 0; i < 10; i++) {
+        plain.add(jon, 0, i < 8);
+    }
+    SkillModel model = plain.fit();
+    assert(model.playerRow("Jon") == 0);
+    assert(model.playerRow("Nobody") == -1);
+    assert(model.successChance(0, 0) == 80);
+    // A trick never tried falls back to the formula
+    assert(model.successChance(0, 1) == 23);
+    
+    // With a prior of 10 attempts, 30 landed out of 30 gives (30 + 8.7) / 40
+    SkillFitter smoothed(difficulties, 10.0);
+    int amy = smoothed.addPlayer("Amy");
+    std::vector<AttemptRecord> records(30);
+    for (auto& record : records) {
+        record.player = amy;
+        record.trick = 0;
+        record.landed = 1;
+    }
+    smoothed.addBatch(records.data(), records.size(), 4);
+    assert(smoothed.fit().successChance(0, 0) == 97);
+    
+    std::cout << "✅ Skill fitter test passed" << std::endl;
+}
+
+// Test reading an attempt log and saving/loading the fitted model
+void testSkillLogAndModelFile() {
+    std::istringstream log("Jon\t0\t1\n"
+                           "Jon\t0\t0\n"
+                           "Amy\t1\t1\n"
+                           "garbage line\n"
+                           "Amy\t7\t1\n"   // no such trick
+                           "Jon\t1\t0\n");
+    SkillFitter fitter({1, 9}, 0.0);
+    assert(fitter.readLog(log) == 4);
+    SkillModel model = fitter.fit();
+    assert(model.playerCount() == 2);
+    assert(model.successChance(model.playerRow("Jon"), 0) == 50);
+    assert(model.successChance(model.playerRow("Jon"), 1) == 0);
+    assert(model.successChance(model.playerRow("Amy"), 1) == 100);
+    
+    std::stringstream file;
+    model.save(file);
+    SkillModel loaded;
+    assert(loaded.load(file));
+    assert(loaded.trickCount() == 2);
+    assert(loaded.playerCount() == 2);
+    assert(loaded.successChance(loaded.playerRow("Jon"), 0) == 50);
+    assert(loaded.successChance(loaded.playerRow("Amy"), 0) == 87);
+    
+    std::istringstream bad("not a model");
+    assert(!loaded.load(bad));
+    assert(loaded.playerCount() == 2);
+    
+    std::cout << "✅ Skill log and model file test passed" << std::endl;
+}
+
+// Test the headless game against a matchup with a known result
+void testSimulateGame() {
+    // One trick that player 1 always lands and player 2 always misses
+    Matchup matchup = defaultMatchup();
+    matchup.chances = {{100}, {0}};
+    GameDice dice(1, 2, false);
+    GameResult result = simulateGame(matchup, dice);
+    assert(result.winner == 0);
+    assert(result.rounds == 5);
+    // Every round went exactly as the chances predicted
+    assert(result.control[0] == 0.0 && result.control[1] == 0.0);
+    
+    // The same dice replay the same game, mirrored dice roll 101 - r
+    Matchup normal = defaultMatchup();
+    GameDice first(7, 8, false);
+    GameDice again(7, 8, false);
+    GameResult a = simulateGame(normal, first);
+    GameResult b = simulateGame(normal, again);
+    assert(a.winner == b.winner && a.rounds == b.rounds);
+    GameDice plain(11, 12, false);
+    GameDice mirrored(11, 12, true);
+    for (int i = 0; i < 100; i++) {
+        assert(plain.roll() + mirrored.roll() == 101);
+    }
+    
+    std::cout << "✅ Simulated game test passed" << std::endl;
+}
+
+// Test that the variance reduced estimate agrees with plain Monte Carlo and is tighter
+void testVarianceReducedEstimate() {
+    Matchup matchup = defaultMatchup();
+    SimOptions options;
+    options.games = 40000;
+    options.threads = 2;
+    WinEstimate reduced = estimateWinProbability(matchup, options);
+    
+    options.antithetic = false;
+    options.controlVariate = false;
+    options.seed = 2;
+    WinEstimate plain = estimateWinProbability(matchup, options);
+    
+    double combined = std::sqrt(reduced.stdError * reduced.stdError + plain.stdError * plain.stdError);
+    assert(std::fabs(reduced.value - plain.value) < 5 * combined);
+    assert(reduced.stdError < plain.stdError);
+    assert(reduced.varianceReduction > 2.0);
+    assert(reduced.effectiveGames > reduced.games);
+    
+    // With common random numbers a strategy compared with itself differs by exactly nothing
+    Strategy greedy = matchup.strategy[0];
+    WinEstimate same = compareStrategies(matchup, 0, greedy, greedy, options);
+    assert(same.value == 0.0 && same.stdError == 0.0);
+    
+    std::cout << "✅ Variance reduced estimate test passed" << std::endl;
+}
+
+// Test that simulations stop on their own once the confidence interval is tight enough
+void testSequentialStopping() {
+    assert(std::fabs(confidenceZ(0.95) - 1.959964) < 1e-5);
+    assert(std::fabs(confidenceZ(0.99) - 2.575829) < 1e-5);
+    
+    Matchup matchup = defaultMatchup();
+    SimOptions options;
+    options.games = 10000000;
+    options.threads = 2;
+    options.precision = 0.01;
+    options.confidence = 0.99;
+    WinEstimate estimate = estimateWinProbability(matchup, options);
+    assert(estimate.precisionReached);
+    assert(estimate.halfWidth <= 0.01);
+    assert(estimate.games < options.games);
+    
+    // A target that cannot be met within the game budget runs the whole budget
+    options.games = 8000;
+    options.precision = 0.0001;
+    estimate = estimateWinProbability(matchup, options);
+    assert(!estimate.precisionReached);
+    assert(estimate.games == 8000);
+    
+    std::cout << "✅ Sequential stopping test passed" << std::endl;
+}
+
+// Test the balance sweep over success formula variants
+void testBalanceSweep() {
+    // The default point reproduces the game's own chances
+    SweepPoint standard = {kDefaultCurve, 10};
+    std::vector<int> chances = sweepChances(standard);
+    for (int i = 0; i < kDefaultTrickCount; i++) {
+        assert(chances[i] == successChance(kDefaultTrickDifficulties[i]));
+    }
+    assert(scaleDifficulty(1, 5) == 1);
+    assert(scaleDifficulty(10, 5) == 5);
+    
+    // Chances are clamped to 0-100
+    SweepPoint extreme = {{120, 30}, 10};
+    chances = sweepChances(extreme);
+    assert(chances[0] == 90);
+    assert(chances[17] == 0); // difficulty 9
+    
+    SweepRange base = {90, 100, 5};
+    SweepRange slope = {8, 8, 1};
+    SweepRange scale = {5, 10, 5};
+    assert(gridPoints(base, slope, scale).size() == 6);
+    
+    // Every stratum of every range is used exactly once
+    SweepRange wide = {0, 99, 1};
+    std::vector<SweepPoint> lhs = latinHypercubePoints(wide, wide, wide, 10, 3);
+    std::vector<int> perStratum(10, 0);
+    for (const auto& point : lhs) {
+        perStratum[std::min(9, point.curve.base / 10)]++;
+    }
+    for (int count : perStratum) {
+        assert(count == 1);
+    }
+    
+    // Repeated success tables are simulated once
+    SimOptions options;
+    options.games = 2000;
+    options.threads = 2;
+    std::vector<SweepPoint> points = {standard, standard, extreme};
+    std::vector<SweepResult> results = runSweep(points, defaultMatchup().strategy[0], options);
+    assert(results.size() == 3);
+    assert(results[0].reused != results[1].reused);
+    assert(results[0].firstSetterWins == results[1].firstSetterWins);
+    assert(!results[2].reused && results[2].games > 0);
+    assert(results[0].viableTricks >= 1);
+    
+    std::cout << "✅ Balance sweep test passed" << std::endl;
+}
+
+// Test the rule variants and the compile-time rules picked for them
+void testRuleVariants() {
+    RuleSet rules;
+    assert(rules.word() == "SKATE" && !rules.lastLetterRetry);
+    assert(parseRuleSet("pig:retry", rules));
+    assert(rules.word() == "PIG" && rules.letters() == 3 && rules.lastLetterRetry);
+    assert(rules.name() == "pig:retry");
+    assert(rules.secondTry(2) && !rules.secondTry(1));
+    assert(!parseRuleSet("pig:twice", rules));
+    assert(!parseRuleSet("basketball", rules));
+    assert(kMaxRuleLetters == 5);
+    
+    TestPlayer player("TestPlayer", "PIG");
+    player.addLetter();
+    player.addLetter();
+    player.addLetter();
+    player.addLetter();
+    assert(player.letters == "PIG");
+    assert(player.hasLost());
+    
+    // The runtime choice reaches the matching instantiation
+    for (int variant = 0; variant < kRuleVariantCount; variant++) {
+        for (int retry = 0; retry < 2; retry++) {
+            RuleSet chosen;
+            chosen.variant = variant;
+            chosen.lastLetterRetry = retry == 1;
+            int letters = withRules(chosen, [](auto r) { return decltype(r)::kLetters; });
+            bool secondTry = withRules(chosen, [](auto r) { return decltype(r)::kLastLetterRetry; });
+            assert(letters == kRuleVariants[variant].letters);
+            assert(secondTry == chosen.lastLetterRetry);
+        }
+    }
+    
+    // Shorter words make shorter games; a second try makes them longer
+    Matchup matchup = defaultMatchup();
+    SimOptions options;
+    options.games = 20000;
+    options.threads = 2;
+    double skateRounds = estimateWinProbability(matchup, options).averageRounds;
+    parseRuleSet("pig", matchup.rules);
+    double pigRounds = estimateWinProbability(matchup, options).averageRounds;
+    parseRuleSet("pig:retry", matchup.rules);
+    double retryRounds = estimateWinProbability(matchup, options).averageRounds;
+    assert(pigRounds < skateRounds);
+    assert(retryRounds > pigRounds);
+    
+    std::cout << "✅ Rule variants test passed" << std::endl;
+}
+
+// Test house rules files and the tables they compile to
+void testHouseRules() {
+    std::istringstream file("# Friday night\nword = PIG\nsetter_penalty = 1\nlast_letter_tries = 3\n"
+                            "max_difficulty = 7   # nothing silly\naward = 6:2\n\n");
+    HouseRules house;
+    std::string error;
+    assert(loadHouseRules(file, house, error));
+    assert(house.word == "PIG" && house.setterPenalty == 1 && house.lastLetterTries == 3);
+    assert(house.award[5] == 1 && house.award[6] == 2 && house.award[10] == 2);
+    
+    std::istringstream unknown("word = PIG\nlives = 3\n");
+    HouseRules ignored;
+    assert(!loadHouseRules(unknown, ignored, error));
+    assert(error == "line 2: unknown rule lives");
+    std::istringstream tooLong("word = SUPERCALIFRAGILISTIC\n");
+    assert(!loadHouseRules(tooLong, ignored, error));
+    
+    const TrickInfo tricks[] = {{"Easy", 1, successChance(1)}, {"Hard", 6, successChance(6)},
+                                {"Silly", 9, successChance(9)}};
+    TrickCatalog catalog = {tricks, 3};
+    CompiledRules table = compileHouseRules(house, catalog);
+    assert(table.tricks.size() == 2 && table.tricks[1] == 1);
+    assert(table.settable(1) == 1 && table.settable(2) == -1 && table.settable(3) == -1);
+    assert(table.missEvent[0] == HOUSE_RESPONDER_MISSED && table.missEvent[1] == HOUSE_RESPONDER_MISSED + 1);
+    
+    // Missing your own trick costs a letter and the setter role
+    BotState start = {{0, 0}, 0};
+    BotState after = table.positions[table.after(table.position(start), HOUSE_SETTER_MISSED)];
+    assert(after.letters[0] == 1 && after.letters[1] == 0 && after.setter == 1);
+    // A hard trick hands out two letters and the setter keeps setting
+    after = table.positions[table.after(table.position(start), HOUSE_RESPONDER_MISSED + 1)];
+    assert(after.letters[1] == 2 && after.setter == 0);
+    assert(table.tries[table.position(after)] == 3); // the responder is on their last letter
+    after.setter = 1;
+    assert(table.tries[table.position(after)] == 1);
+    BotState lost = {{0, 3}, 0};
+    assert(table.winner[table.position(lost)] == 0);
+    assert(table.after(table.position(lost), HOUSE_SETTER_MISSED) == table.position(lost));
+    
+    // The built-in variants played from tables give exactly the compiled loop's games
+    Matchup matchup = defaultMatchup();
+    parseRuleSet("skate:retry", matchup.rules);
+    CompiledRules same = compileHouseRules(houseRulesFor(matchup.rules));
+    SimOptions options;
+    options.games = 4000;
+    options.threads = 2;
+    WinEstimate compiled = estimateWinProbability(matchup, options);
+    matchup.house = &same;
+    WinEstimate tabled = estimateWinProbability(matchup, options);
+    assert(compiled.value == tabled.value && compiled.averageRounds == tabled.averageRounds);
+    
+    std::cout << "✅ House rules test passed" << std::endl;
+}
+
+// Test the exact solver against simulated games
+void testSolver() {
+    // With a single trick there is nothing to choose, so the solver must agree with simulation
+    Matchup matchup = defaultMatchup();
+    matchup.chances[0] = std::vector<int>(1, 70);
+    matchup.chances[1] = std::vector<int>(1, 50);
+    matchup.strategy[0].policy = POLICY_FIXED;
+    matchup.strategy[0].trick = 0;
+    matchup.strategy[1] = matchup.strategy[0];
+    SolvedMatchup solved = solveMatchup(matchup.chances);
+    SimOptions options;
+    options.games = 200000;
+    options.threads = 2;
+    WinEstimate estimate = estimateWinProbability(matchup, options);
+    BotState start = {{0, 0}, 0};
+    assert(std::fabs(solved.winChance(start) - estimate.value) < 4 * estimate.stdError + 1e-9);
+    
+    // Also with a shorter word and a second try on the last letter
+    parseRuleSet("pig:retry", matchup.rules);
+    SolvedMatchup pig = solveMatchup(matchup.chances, matchup.rules);
+    estimate = estimateWinProbability(matchup, options);
+    assert(std::fabs(pig.winChance(start) - estimate.value) < 4 * estimate.stdError + 1e-9);
+    
+    BotState won = {{2, kSkateLetters}, 0};
+    assert(solved.winChance(won) == 1.0);
+    
+    // Taking turns as in the GUI: the setter changes after every round
+    SolvedMatchup turns = solveMatchup(matchup.chances, RuleSet(), true);
+    SimRng rng(5);
+    int wins = 0;
+    const int games = 200000;
+    for (int game = 0; game < games; game++) {
+        BotState state = start;
+        while (!state.isOver()) {
+            int setter = state.setter;
+            if (rng.roll() <= matchup.chances[setter][0] && rng.roll() > matchup.chances[1 - setter][0]) {
+                state.letters[1 - setter]++;
+            }
+            state.setter = 1 - setter;
+        }
+        wins += state.letters[1] >= kSkateLetters ? 1 : 0;
+    }
+    double p = turns.winChance(start);
+    assert(std::fabs(p - static_cast<double>(wins) / games) < 4 * std::sqrt(p * (1 - p) / games));
+    assert(std::fabs(turns.winChance(start) - solved.winChance(start)) > 0.01);
+    
+    // Perfect play is at least as good as any single trick
+    std::vector<std::vector<int>> chances(2, std::vector<int>(kDefaultTrickDifficulties,
+                                                                kDefaultTrickDifficulties + kDefaultTrickCount));
+    for (auto& row : chances) {
+        for (int& chance : row) {
+            chance = successChance(chance);
+        }
+    }
+    solved = solveMatchup(chances);
+    std::vector<double> tricks = trickWinChances(chances, solved, start);
+    assert(tricks.size() == static_cast<size_t>(kDefaultTrickCount));
+    for (double chance : tricks) {
+        assert(chance <= solved.winChance(start) + 1e-9);
+    }
+    
+    std::cout << "✅ Solver test passed" << std::endl;
+}
+
+// Test the result cache: keys, eviction, concurrent readers and the cache file
+void testResultCache() {
+    std::vector<std::vector<int>> chances = {{80, 40, 10}, {60, 60, 60}};
+    std::vector<std::vector<int>> swapped = {chances[1], chances[0]};
+    BotState state = {{1, 3}, 0};
+    BotState mirror = {{3, 1}, 1};
+    bool mirrored;
+    bool swappedMirrored;
+    uint64_t key = matchupKey(chances, rulesetKey(RuleSet()), state, mirrored);
+    assert(matchupKey(swapped, rulesetKey(RuleSet()), mirror, swappedMirrored) == key);
+    assert(mirrored != swappedMirrored);
+    RuleSet pig;
+    parseRuleSet("pig", pig);
+    assert(matchupKey(chances, rulesetKey(pig), state, mirrored) != key);
+    
+    // Solving through the cache gives the same answers, from either side
+    ResultCache cache(1000, 4);
+    SolvedMatchup direct = solveMatchup(chances);
+    SolvedMatchup first = cachedSolve(cache, chances);
+    CacheStats stats = cache.stats();
+    assert(stats.entries == static_cast<size_t>(2 * kSkateLetters * kSkateLetters));
+    SolvedMatchup other = cachedSolve(cache, swapped);
+    assert(cache.stats().entries == stats.entries);
+    assert(cache.stats().hits > stats.hits);
+    assert(std::fabs(first.winChance(state) - direct.winChance(state)) < 1e-12);
+    assert(std::fabs(other.winChance(mirror) - (1.0 - direct.winChance(state))) < 1e-12);
+    
+    // A full cache keeps the results that were expensive to compute
+    ResultCache small(64, 1);
+    CachedResult result = {0.5, 0.0};
+    small.insert(1, result, 100.0);
+    for (uint64_t k = 2; k < 1000; k++) {
+        small.insert(k << 20, result, 0.001);
+    }
+    stats = small.stats();
+    assert(stats.entries == 64);
+    assert(stats.evictions == 1000 - 1 - 64);
+    assert(small.find(1, result));
+    
+    // Concurrent readers see every entry
+    std::vector<std::thread> readers;
+    std::atomic<int> found(0);
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&]() {
+            for (int repeat = 0; repeat < 1000; repeat++) {
+                CachedResult r;
+                found += small.find(1, r) ? 1 : 0;
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    assert(found == 4000);
+    
+    // Entries survive a save and load
+    const char* path = "skate_test_cache.bin";
+    assert(cache.save(path));
+    ResultCache reloaded;
+    assert(reloaded.load(path));
+    assert(reloaded.stats().entries == cache.stats().entries);
+    CachedResult loaded;
+    assert(reloaded.find(key, loaded));
+    assert(std::fabs((mirrored ? 1.0 - loaded.value : loaded.value) - direct.winChance(state)) < 1e-12);
+    std::remove(path);
+    assert(reloaded.load("no_such_cache.bin"));
+    
+    std::cout << "✅ Result cache test passed" << std::endl;
+}
+
+// Test N-skater sessions: packed state, rotation, elimination and simulation
+void testSession() {
+    SessionState state = startSession(30, 2);
+    assert(state.remaining() == 30 && state.setter == 2 && !state.isOver());
+    assert(sizeof(SessionState) <= 32);
+    
+    // Letter counts are packed four bits each and do not disturb their neighbours
+    state.setLetters(17, 4);
+    state.setLetters(16, 2);
+    assert(state.lettersOf(17) == 4 && state.lettersOf(16) == 2 && state.lettersOf(18) == 0);
+    
+    // Spelling the word knocks a skater out and the rotation skips them
+    state = addLetters(state, 3, 1, 5);
+    assert(state.lettersOf(3) == 1 && state.isActive(3));
+    state = addLetters(state, 3, 4, 5);
+    assert(!state.isActive(3) && state.lettersOf(3) == 5);
+    assert(state.nextActive(2) == 4);
+    assert(state.nextActive(29) == 0);
+    
+    // A missed set passes to the next skater still in
+    state = setterMissed(state, 0, 5);
+    assert(state.setter == 4);
+    
+    // Last one standing
+    SessionState three = startSession(3);
+    three = addLetters(three, 0, 5, 5);
+    three = addLetters(three, 2, 5, 5);
+    assert(three.isOver() && three.winner() == 1);
+    
+    // Two skaters play exactly the two-player game
+    Matchup pair = defaultMatchup();
+    SessionMatchup session = defaultSessionMatchup(2);
+    for (int g = 0; g < 200; g++) {
+        GameDice a(g, g + 1000, false);
+        GameDice b(g, g + 1000, false);
+        int rounds = 0;
+        GameResult game = simulateGame(pair, a);
+        assert(simulateSession(session, b, rounds) == game.winner && rounds == game.rounds);
+    }
+    
+    // Nobody is favoured much among equal skaters, and every session has a winner
+    SimOptions options;
+    options.games = 4000;
+    options.threads = 2;
+    SessionOdds odds = estimateSessionOdds(defaultSessionMatchup(5), options);
+    double total = 0.0;
+    for (double share : odds.winShare) {
+        assert(share > 0.1 && share < 0.3);
+        total += share;
+    }
+    assert(std::fabs(total - 1.0) < 1e-9);
+    assert(!odds.precisionReached);
+    
+    // With a precision the sessions stop once every share is known to it
+    options.games = 1000000000L;
+    options.precision = 0.01;
+    odds = estimateSessionOdds(defaultSessionMatchup(5), options);
+    assert(odds.precisionReached && odds.halfWidth <= 0.01);
+    assert(odds.games >= 2000 && odds.games < 100000);
+    
+    std::cout << "✅ Session test passed" << std::endl;
+}
+
+// Test the coroutine turn engine: same games as the simulator, bad input, timeouts, many matches
+void testTurnEngine() {
+    CompiledRules rules = compileHouseRules(houseRulesFor(RuleSet()));
+    std::vector<std::vector<int>> chances(2, rules.thresholds);
+    
+    // Players who always set trick 5 play the same game as the simulator on the same rolls
+    Matchup matchup = defaultMatchup();
+    matchup.house = &rules;
+    matchup.strategy[0].policy = matchup.strategy[1].policy = POLICY_FIXED;
+    matchup.strategy[0].trick = matchup.strategy[1].trick = 4;
+    for (uint64_t seed = 1; seed <= 20; seed++) {
+        TurnScheduler scheduler;
+        int id = scheduler.start(rules, chances, seed);
+        int rounds = 0;
+        while (!scheduler.isOver(id)) {
+            scheduler.runReady();
+            for (const TurnEvent& event : scheduler.events()) {
+                rounds += event.type == TURN_CHOOSE_TRICK ? 1 : 0;
+            }
+            scheduler.clearEvents();
+            if (scheduler.isWaiting(id)) {
+                scheduler.deliver(id, scheduler.waitingFor(id), 4);
+            }
+        }
+        GameDice dice(seed, 0, false);
+        GameResult game = simulateGame(matchup, dice);
+        assert(scheduler.winner(id) == game.winner && rounds == game.rounds);
+    }
+    
+    // A trick the rules do not allow is refused and the setter asked again
+    HouseRules strict;
+    strict.maxDifficulty = 3;
+    CompiledRules strictRules = compileHouseRules(strict);
+    TurnScheduler scheduler(100);
+    int id = scheduler.start(strictRules, chances, 3);
+    scheduler.runReady();
+    assert(scheduler.isWaiting(id) && scheduler.waitingFor(id) == 0);
+    // Input from the player whose turn it is not changes nothing
+    scheduler.clearEvents();
+    assert(!scheduler.deliver(id, 1, 2));
+    scheduler.runReady();
+    assert(scheduler.events().empty() && scheduler.isWaiting(id) && scheduler.waitingFor(id) == 0);
+    assert(scheduler.deliver(id, 0, 17));
+    scheduler.runReady();
+    assert(scheduler.events().back().type == TURN_INVALID_TRICK && scheduler.waitingFor(id) == 0);
+    
+    // A setter who does not answer in time loses the set
+    scheduler.clearEvents();
+    scheduler.fireTimers(TurnScheduler::Clock::now() + std::chrono::seconds(1));
+    scheduler.runReady();
+    assert(scheduler.events()[0].type == TURN_TIMED_OUT);
+    assert(strictRules.positions[scheduler.position(id)].setter == 1 && scheduler.waitingFor(id) == 1);
+    
+    // Time to answer counts from when the player is asked, however long since timers last fired
+    TurnScheduler::Clock::time_point asked = TurnScheduler::Clock::now() + std::chrono::seconds(10);
+    assert(scheduler.deliver(id, 1, 0));
+    scheduler.runReady(asked);
+    scheduler.clearEvents();
+    scheduler.fireTimers(asked + std::chrono::milliseconds(50));
+    scheduler.runReady(asked + std::chrono::milliseconds(50));
+    assert(scheduler.events().empty() && scheduler.isWaiting(id));
+    scheduler.fireTimers(asked + std::chrono::milliseconds(150));
+    scheduler.runReady(asked + std::chrono::milliseconds(150));
+    assert(!scheduler.events().empty() && scheduler.events()[0].type == TURN_TIMED_OUT);
+    
+    // Thousands of matches on this one thread
+    TurnScheduler crowd;
+    const int kMatches = 5000;
+    for (int i = 0; i < kMatches; i++) {
+        crowd.start(rules, chances, i + 1, i % 2);
+    }
+    for (bool waiting = true; waiting;) {
+        crowd.runReady();
+        crowd.clearEvents();
+        waiting = false;
+        for (int i = 0; i < kMatches; i++) {
+            if (crowd.isWaiting(i)) {
+                crowd.deliver(i, crowd.waitingFor(i), i % kDefaultTrickCount);
+                waiting = true;
+            }
+        }
+    }
+    for (int i = 0; i < kMatches; i++) {
+        assert(crowd.isOver(i));
+    }
+    
+    std::cout << "✅ Turn engine test passed" << std::endl;
+}
+
+// Test the spectator broadcast: shared lines, scatter-gather writes and resyncing slow viewers
+void testSpectatorBroadcast() {
+    int fast[2];
+    int slow[2];
+    assert(pipe(fast) == 0 && pipe(slow) == 0);
+    fcntl(fast[1], F_SETFL, O_NONBLOCK);
+    fcntl(slow[1], F_SETFL, O_NONBLOCK);
+    
+    SpectatorHub hub(8);
+    int fastViewer = hub.subscribe(0, fast[1]);
+    int slowViewer = hub.subscribe(0, slow[1]);
+    hub.subscribe(1, slow[1]); // other matches do not reach match 0's viewers
+    assert(hub.backlog(fastViewer) == 1); // the snapshot
+    
+    TurnEvent letter = {0, TURN_LETTERS, 1, 0, 2};
+    hub.publish(letter);
+    assert(hub.statistics().published == 1 && hub.backlog(slowViewer) == 2);
+    hub.flush(fastViewer);
+    char text[256] = {0};
+    ssize_t got = read(fast[0], text, sizeof(text) - 1);
+    assert(got > 0 && std::string(text) == "S 0 0 0 0 -1\nE 0 7 1 0 2\n");
+    
+    // The slow viewer never reads; after a full queue it is sent a snapshot, not the backlog
+    TurnEvent setter = {0, TURN_SETTER_CHANGED, 1, 0, 0};
+    for (int i = 0; i < 10; i++) {
+        hub.publish(setter);
+        hub.flush(fastViewer);
+    }
+    assert(hub.statistics().resyncs >= 1);
+    assert(hub.backlog(slowViewer) < 8 && hub.backlog(fastViewer) == 0);
+    hub.flush(slowViewer);
+    std::memset(text, 0, sizeof(text));
+    got = read(slow[0], text, sizeof(text) - 1);
+    assert(got > 0 && std::string(text).find("S 0 0 2 1 -1\n") != std::string::npos);
+    
+    // One line written, queued to both viewers of the match
+    BroadcastStats before = hub.statistics();
+    hub.publish(letter);
+    assert(hub.statistics().published == before.published + 1 && hub.statistics().queued == before.queued + 2);
+    
+    // A match that opens with player 2 setting shows them as the setter to a late viewer
+    CompiledRules rules = compileHouseRules(houseRulesFor(RuleSet()));
+    std::vector<std::vector<int>> chances(2, rules.thresholds);
+    TurnScheduler scheduler;
+    int match = scheduler.start(rules, chances, 5, 1);
+    scheduler.runReady();
+    assert(scheduler.waitingFor(match) == 1);
+    SpectatorHub opening(8);
+    for (const TurnEvent& event : scheduler.events()) {
+        opening.publish(event);
+    }
+    int late[2];
+    assert(pipe(late) == 0);
+    opening.flush(opening.subscribe(match, late[1]));
+    std::memset(text, 0, sizeof(text));
+    got = read(late[0], text, sizeof(text) - 1);
+    assert(got > 0 && std::string(text) == "S 0 0 0 1 -1\n");
+    
+    // A released match's id goes to a new match, which its old viewer does not see and a new
+    // viewer sees from the start
+    scheduler.clearEvents();
+    while (!scheduler.isOver(match)) {
+        scheduler.deliver(match, scheduler.waitingFor(match), 0);
+        scheduler.runReady();
+    }
+    assert(scheduler.release(match));
+    assert(scheduler.start(rules, chances, 6, 0) == match);
+    scheduler.runReady();
+    for (const TurnEvent& event : scheduler.events()) {
+        opening.publish(event);
+    }
+    std::string seen;
+    while (opening.flush(0) > 0) {
+        std::memset(text, 0, sizeof(text));
+        got = read(late[0], text, sizeof(text) - 1);
+        seen += text;
+    }
+    std::string closed = "E 0 " + std::to_string(static_cast<int>(TURN_MATCH_CLOSED));
+    assert(seen.find(closed) != std::string::npos && seen.find('\n', seen.find(closed)) == seen.size() - 1);
+    int fresh[2];
+    assert(pipe(fresh) == 0);
+    opening.flush(opening.subscribe(match, fresh[1]));
+    std::memset(text, 0, sizeof(text));
+    got = read(fresh[0], text, sizeof(text) - 1);
+    assert(got > 0 && std::string(text) == "S 0 0 0 0 -1\n");
+    
+    // Viewers coming and going by the thousand reuse the slots of those who left
+    SpectatorHub churn(8);
+    std::vector<int> watching;
+    for (int i = 0; i < 10000; i++) {
+        watching.push_back(churn.subscribe(i % 3, fast[1]));
+        churn.publish(letter);
+        if (watching.size() == 4) {
+            churn.unsubscribe(watching[i % 4]);
+            watching.erase(watching.begin() + i % 4);
+        }
+    }
+    assert(churn.spectatorSlots() == 4);
+    churn.flushAll();
+    
+    close(fresh[0]);
+    close(fresh[1]);
+    close(late[0]);
+    close(late[1]);
+    close(fast[0]);
+    close(fast[1]);
+    close(slow[0]);
+    close(slow[1]);
+    std::cout << "✅ Spectator broadcast test passed" << std::endl;
+}
+
+// Test ratings and the leaderboard: Elo, ranks, concurrent reports and snapshot pages
+void testLeaderboard() {
+    assert(eloChange(1500, 1500) == 16);
+    assert(eloChange(1800, 1400) < eloChange(1400, 1800));
+    
+    Leaderboard board;
+    board.report("Amy", "Jon");
+    board.flush();
+    assert(board.rating("Amy") == 1516 && board.rating("Jon") == 1484);
+    assert(board.rank("Amy") == 1 && board.rank("Jon") == 2 && board.rank("Nobody") == 0);
+    
+    // Games finishing on many threads at once
+    std::vector<std::thread> games;
+    for (int t = 0; t < 4; t++) {
+        games.emplace_back([&board, t]() {
+            for (int g = 0; g < 2000; g++) {
+                board.report("P" + std::to_string(t * 2000 + g), "Q" + std::to_string(g % 50));
+            }
+        });
+    }
+    for (auto& thread : games) {
+        thread.join();
+    }
+    board.flush();
+    assert(board.playerCount() == 2 + 8000 + 50);
+    
+    // A snapshot is sorted and its ranks agree with the live ranks
+    std::shared_ptr<const LeaderboardSnapshot> table = board.latest();
+    assert(table->rows.size() == board.playerCount());
+    for (size_t i = 1; i < table->rows.size(); i++) {
+        assert(table->rows[i - 1].rating >= table->rows[i].rating);
+    }
+    for (size_t i = 0; i < table->rows.size(); i += 997) {
+        assert(table->rankAt(i) == board.rank(*table->rows[i].name));
+    }
+    std::vector<LeaderboardRow> top = table->page(1, 10);
+    assert(top.size() == 10 && top[0].rating == table->rows[0].rating);
+    assert(table->page(table->rows.size(), 10).size() == 1);
+    
+    // Later results do not change a snapshot someone is paging through
+    board.report("Q0", "Amy");
+    board.flush();
+    assert(board.latest()->version > table->version);
+    
+    // Lookups go on while a big batch is applied, each from one whole snapshot
+    std::atomic<bool> applying(true);
+    std::thread reporter([&board, &applying]() {
+        for (int g = 0; g < 200000; g++) {
+            board.report("R" + std::to_string(g % 20000), "Amy");
+        }
+        board.flush();
+        applying = false;
+    });
+    long lookups = 0;
+    while (applying) {
+        std::shared_ptr<const LeaderboardSnapshot> now = board.latest();
+        int row = now->find("Amy");
+        assert(row >= 0 && now->rankAt(static_cast<size_t>(row)) >= 1 && now->rows.size() >= 8052);
+        assert(board.rank("Amy") >= 1);
+        lookups++;
+    }
+    reporter.join();
+    assert(lookups > 0 && board.playerCount() == 2 + 8000 + 50 + 20000);
+    assert(board.rank("R0") == board.latest()->rankAt(board.latest()->find("R0")));
+    
+    // Ratings survive a save and load
+    std::stringstream saved;
+    board.save(saved);
+    Leaderboard reloaded;
+    assert(reloaded.load(saved));
+    assert(reloaded.playerCount() == board.playerCount());
+    assert(reloaded.rating("Amy") == board.rating("Amy") && reloaded.rank("Q0") == board.rank("Q0"));
+    
+    std::cout << "✅ Leaderboard test passed" << std::endl;
+}
+
+// Test the attempt store: calendar months, bit packing and queries against a plain count
+void testAttemptStore() {
+    assert(monthIndex(0) == 0 && monthIndex(-1) == -1);
+    assert(monthIndex(1709251200) == (2024 - 1970) * 12 + 2); // 1 March 2024
+    assert(monthIndex(1709251199) == (2024 - 1970) * 12 + 1);
+    for (int month = -30; month < 1200; month += 7) {
+        assert(monthIndex(monthStart(month)) == month && monthIndex(monthStart(month) - 1) == month - 1);
+    }
+    
+    std::vector<uint64_t> values = {5, 9, 1000, 5, 77};
+    std::vector<uint64_t> words;
+    packBits(values, 5, bitsFor(995), words);
+    uint32_t unpacked[3];
+    unpackBits(words.data(), 2, 3, bitsFor(995), 5, unpacked);
+    assert(unpacked[0] == 1000 && unpacked[1] == 5 && unpacked[2] == 77);
+    
+    // Three blocks of made-up attempts over a year, one player only in the last block
+    const char* path = "skate_test_store.bin";
+    AttemptStoreWriter writer;
+    assert(writer.open(path));
+    std::vector<AttemptEvent> events;
+    SimRng rng(5);
+    int64_t start = monthStart((2024 - 1970) * 12);
+    for (int i = 0; i < 2 * kStoreBlockRows + 5000; i++) {
+        AttemptEvent event;
+        event.actor = writer.actor(i < 2 * kStoreBlockRows ? "P" + std::to_string(rng.below(40)) : "Late");
+        event.trick = static_cast<TrickId>(rng.below(kDefaultTrickCount));
+        event.difficulty = static_cast<uint8_t>(kDefaultTricks[event.trick].difficulty);
+        event.landed = rng.roll() <= kDefaultTricks[event.trick].threshold ? 1 : 0;
+        event.role = static_cast<uint8_t>(rng.below(2));
+        event.time = start + static_cast<int64_t>(i) * 200;
+        assert(writer.add(event));
+        events.push_back(event);
+    }
+    assert(writer.close());
+    
+    AttemptStore store;
+    assert(store.open(path));
+    assert(store.rows() == events.size() && store.blocks() == 3 && store.playerCount() == 41);
+    assert(store.bytes() < events.size() * 8);
+    
+    AttemptQuery everything;
+    QueryStats stats;
+    std::vector<AttemptGroup> total = store.query(everything, 2, &stats);
+    assert(total.size() == 1 && total[0].attempts == events.size());
+    assert(stats.blocksCounted == 3 && stats.rowsScanned == 0);
+    
+    // Grouped and filtered queries agree with counting the events one by one
+    AttemptQuery query;
+    query.byMonth = true;
+    query.byDifficulty = true;
+    query.byActor = true;
+    query.role = ROLE_SETTER;
+    query.minDifficulty = 3;
+    query.maxDifficulty = 6;
+    query.from = start + 3600;
+    std::map<std::vector<int>, std::pair<uint64_t, uint64_t>> expected;
+    for (const AttemptEvent& event : events) {
+        if (event.role == ROLE_SETTER && event.difficulty >= 3 && event.difficulty <= 6 && event.time >= query.from) {
+            std::pair<uint64_t, uint64_t>& counts =
+                expected[{static_cast<int>(event.actor), monthIndex(event.time), event.difficulty}];
+            counts.first++;
+            counts.second += event.landed;
+        }
+    }
+    for (int threads = 1; threads <= 3; threads++) {
+        std::vector<AttemptGroup> groups = store.query(query, threads);
+        assert(groups.size() == expected.size());
+        for (const AttemptGroup& group : groups) {
+            std::pair<uint64_t, uint64_t> counts =
+                expected[{static_cast<int>(group.actor), group.month, group.difficulty}];
+            assert(group.attempts == counts.first && group.landed == counts.second);
+        }
+    }
+    
+    // The zone maps rule out the blocks a player never appears in
+    AttemptQuery late;
+    late.actor = store.actor("Late");
+    std::vector<AttemptGroup> lateGroups = store.query(late, 1, &stats);
+    assert(lateGroups.size() == 1 && lateGroups[0].attempts == 5000);
+    assert(stats.blocksSkipped == 2);
+    assert(store.actor("Nobody") == -1);
+    
+    store.close();
+    
+    // A store whose directory or zones point outside the file is refused, not scanned
+    std::string good;
+    {
+        std::ifstream in(path, std::ios::binary);
+        good.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    StoreHeader storeHeader;
+    std::memcpy(&storeHeader, good.data(), sizeof(storeHeader));
+    auto opens = [&](auto damage) {
+        std::string bytes = good;
+        damage(bytes);
+        {
+            std::ofstream out(path, std::ios::binary);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+        AttemptStore damaged;
+        return damaged.open(path);
+    };
+    auto zoneField = [&](size_t block, size_t field) {
+        return storeHeader.directoryOffset + block * sizeof(StoreZone) + field;
+    };
+    assert(opens([](std::string&) {}));
+    assert(!opens([&](std::string& bytes) {
+        uint64_t blocks = ~0ULL / sizeof(StoreZone) + 1; // times the zone size wraps to nothing
+        std::memcpy(&bytes[offsetof(StoreHeader, blocks)], &blocks, sizeof(blocks));
+    }));
+    assert(!opens([&](std::string& bytes) {
+        uint64_t offset = bytes.size();
+        std::memcpy(&bytes[zoneField(1, offsetof(StoreZone, offset))], &offset, sizeof(offset));
+    }));
+    assert(!opens([&](std::string& bytes) { bytes[zoneField(2, offsetof(StoreZone, bits) + COLUMN_TIME)] = 65; }));
+    assert(!opens([&](std::string& bytes) {
+        uint32_t rows = kStoreBlockRows + 1;
+        std::memcpy(&bytes[zoneField(0, offsetof(StoreZone, rows))], &rows, sizeof(rows));
+    }));
+    assert(!opens([&](std::string& bytes) {
+        uint32_t column = 1u << 30;
+        std::memcpy(&bytes[zoneField(0, offsetof(StoreZone, column) + 4 * COLUMN_ACTOR)], &column, sizeof(column));
+    }));
+    std::remove(path);
+    assert(!store.open("no_such_store.bin"));
+    
+    std::cout << "✅ Attempt store test passed" << std::endl;
+}
+
+// Test the attempt codec: exact round trips, odd values, random access and the size of games
+void testAttemptCodec() {
+    assert(unzigzag(zigzag(-5)) == -5 && zigzag(-1) == 1 && zigzag(1) == 2);
+    
+    // Games: the setter's attempts, each landed one matched by the other player soon after
+    std::vector<AttemptEvent> events;
+    SimRng rng(11);
+    int64_t time = 1700000000;
+    while (events.size() < static_cast<size_t>(2 * kCodecBlockEvents + 777)) {
+        uint32_t players[2] = {static_cast<uint32_t>(rng.below(5000)), static_cast<uint32_t>(rng.below(5000))};
+        int setter = 0;
+        for (int round = 0; round < 25; round++) {
+            int trick = rng.below(kDefaultTrickCount);
+            AttemptEvent set = {players[setter], static_cast<TrickId>(trick),
+                                static_cast<uint8_t>(kDefaultTricks[trick].difficulty),
+                                static_cast<uint8_t>(rng.roll() <= kDefaultTricks[trick].threshold ? 1 : 0),
+                                static_cast<uint8_t>(ROLE_SETTER), time += 5 + rng.below(30)};
+            events.push_back(set);
+            if (!set.landed) {
+                setter = 1 - setter;
+                continue;
+            }
+            AttemptEvent match = set;
+            match.actor = players[1 - setter];
+            match.role = ROLE_RESPONDER;
+            match.landed = static_cast<uint8_t>(rng.roll() <= kDefaultTricks[trick].threshold ? 1 : 0);
+            match.time = time += 5 + rng.below(30);
+            events.push_back(match);
+        }
+    }
+    // Values that do not fit the symbols: big tricks and players, long and backward gaps, a new difficulty
+    AttemptEvent odd = {4000000000u, 300, 9, 1, ROLE_SETTER, time + 86400 * 30};
+    events.push_back(odd);
+    odd.trick = 1;
+    odd.difficulty = 7;
+    odd.time = -12345;
+    events.push_back(odd);
+    
+    std::ostringstream out;
+    AttemptEncoder encoder(out);
+    assert(encoder.actor("Amy") == 0 && encoder.actor("Jon") == 1 && encoder.actor("Amy") == 0);
+    for (const AttemptEvent& event : events) {
+        encoder.add(event);
+    }
+    assert(encoder.finish());
+    std::string bytes = out.str();
+    assert(bytes.size() < events.size() * 2); // the text log takes about 20 bytes an attempt
+    
+    AttemptArchive archive;
+    assert(archive.load(std::vector<uint8_t>(bytes.begin(), bytes.end())));
+    assert(archive.events() == events.size() && archive.blocks() == 3);
+    assert(archive.playerCount() == 2 && archive.actorName(1) == "Jon" && archive.actor("Amy") == 0);
+    std::vector<AttemptEvent> decoded;
+    assert(archive.read(0, events.size(), decoded));
+    assert(decoded.size() == events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        const AttemptEvent& a = events[i];
+        const AttemptEvent& b = decoded[i];
+        assert(a.actor == b.actor && a.trick == b.trick && a.difficulty == b.difficulty && a.landed == b.landed &&
+               a.role == b.role && a.time == b.time);
+    }
+    
+    // Reading across a block boundary decodes only the blocks needed
+    std::vector<AttemptEvent> middle;
+    assert(archive.read(kCodecBlockEvents - 10, 20, middle));
+    assert(middle.size() == 20 && middle[15].time == events[kCodecBlockEvents + 5].time);
+    assert(!archive.read(events.size() - 1, 2, middle));
+    
+    // A cut-off archive is turned away
+    std::vector<uint8_t> cut(bytes.begin(), bytes.end() - 1);
+    assert(!archive.load(cut));
+    
+    // A damaged block is reported, not decoded forever: zero the op stream of a 100-attempt archive
+    std::ostringstream small;
+    AttemptEncoder smallEncoder(small);
+    for (size_t i = 0; i < 100; i++) {
+        smallEncoder.add(events[i]);
+    }
+    assert(smallEncoder.finish());
+    std::vector<uint8_t> damaged;
+    for (char c : small.str()) {
+        damaged.push_back(static_cast<uint8_t>(c));
+    }
+    const uint8_t* header = damaged.data() + sizeof(kCodecMagic);
+    const uint8_t* headerEnd = damaged.data() + damaged.size();
+    uint64_t value;
+    uint64_t lengths[3];
+    assert(getVarint(header, headerEnd, value) && value == 100 && getVarint(header, headerEnd, value));
+    for (int k = 0; k < 3; k++) {
+        uint64_t present;
+        assert(getVarint(header, headerEnd, present));
+        for (uint64_t i = 0; i < present; i++) {
+            header++;
+            assert(getVarint(header, headerEnd, value));
+        }
+        assert(getVarint(header, headerEnd, lengths[k]));
+    }
+    assert(getVarint(header, headerEnd, value));
+    size_t opsAt = static_cast<size_t>(header - damaged.data());
+    std::vector<AttemptEvent> none;
+    assert(archive.load(damaged) && archive.decodeBlock(0, none) && none.size() == 100);
+    std::fill(damaged.begin() + opsAt, damaged.begin() + opsAt + lengths[0], 0);
+    none.clear();
+    assert(archive.load(damaged) && !archive.decodeBlock(0, none));
+    
+    // Streams that are empty or coded with an empty table stop as well
+    RansTable empty;
+    std::memset(&empty, 0, sizeof(empty));
+    RansDecoder decoder;
+    assert(!decoder.start(empty, damaged.data(), damaged.data()));
+    uint8_t state[4] = {0, 0, 0x80, 0};
+    assert(decoder.start(empty, state, state + 4));
+    for (int i = 0; i < 10; i++) {
+        decoder.next();
+    }
+    assert(!decoder.finished());
+    
+    std::cout << "✅ Attempt codec test passed" << std::endl;
+}
+
+// Plays a game the way the console game does and records it
+Replay playReplayGame(const HouseRules& rules, uint64_t seed, SimRng& choices) {
+    CompiledRules table = compileHouseRules(rules);
+    Replay replay;
+    replay.seed = seed;
+    replay.rules = rules;
+    replay.names[0] = "Amy";
+    replay.names[1] = "Jon";
+    for (int p = 0; p < 2; p++) {
+        for (size_t t = 0; t < kDefaultCatalog.size(); t++) {
+            replay.chances[p].push_back(std::min(99, table.thresholds[t] + p * 5));
+        }
+    }
+    int position = 0;
+    uint32_t attempt = 0;
+    while (table.winner[position] < 0) {
+        TrickId trick = static_cast<TrickId>(table.tricks[choices.below(static_cast<int>(table.tricks.size()))]);
+        int setter = table.positions[position].setter;
+        int rolls = 0;
+        int landed = 0;
+        int event = HOUSE_SETTER_MISSED;
+        if (replayRoll(seed, attempt + rolls++) <= replay.chances[setter][trick]) {
+            landed = 1;
+            event = table.missEvent[table.settable(trick)];
+            for (int t = 0; t < table.tries[position]; t++) {
+                if (replayRoll(seed, attempt + rolls++) <= replay.chances[1 - setter][trick]) {
+                    landed |= 1 << (rolls - 1);
+                    event = HOUSE_BOTH_LANDED;
+                    break;
+                }
+            }
+        }
+        recordRound(replay, position, attempt, trick, rolls, landed);
+        attempt += rolls;
+        position = table.after(position, event);
+    }
+    replay.winner = table.winner[position];
+    return replay;
+}
+
+void testReplay() {
+    // Each attempt's roll is the roll SimRng would give it in turn
+    SimRng dice(42);
+    for (uint64_t attempt = 0; attempt < 1000; attempt++) {
+        assert(replayRoll(42, attempt) == dice.roll());
+    }
+    
+    HouseRules rules;
+    rules.word = "HORSE";
+    rules.lastLetterTries = 2;
+    rules.setterPenalty = 1;
+    rules.maxDifficulty = 8;
+    rules.award[9] = 2;
+    CompiledRules table = compileHouseRules(rules);
+    SimRng choices(7);
+    std::vector<Replay> replays;
+    for (uint64_t seed = 1; seed <= 200; seed++) {
+        replays.push_back(playReplayGame(rules, seed * 1000003, choices));
+    }
+    
+    const Replay& game = replays[0];
+    assert(verifyReplay(game).ok && game.rounds.size() > static_cast<size_t>(kReplayCheckpointInterval));
+    assert(game.checkpoints.size() == (game.rounds.size() + kReplayCheckpointInterval - 1) / kReplayCheckpointInterval);
+    
+    // Seeking from a checkpoint lands where stepping from the start does
+    ReplayState stepped = {0, 0, 0};
+    for (uint32_t round = 0; round <= game.rounds.size(); round++) {
+        ReplayState seeked = seekReplay(game, table, round);
+        assert(seeked.round == round && seeked.attempt == stepped.attempt && seeked.position == stepped.position);
+        if (round < game.rounds.size()) {
+            stepped.attempt += game.rounds[round].rolls;
+            stepped.position = table.after(stepped.position, roundEvent(table, game.rounds[round]));
+        }
+    }
+    assert(table.winner[stepped.position] == game.winner);
+    
+    // Saved and read back, many games to a file
+    std::stringstream file;
+    for (const Replay& replay : replays) {
+        saveReplay(file, replay);
+    }
+    std::vector<Replay> loaded;
+    Replay replay;
+    while (loadReplay(file, replay)) {
+        loaded.push_back(replay);
+    }
+    assert(loaded.size() == replays.size());
+    assert(loaded[3].seed == replays[3].seed && loaded[3].rules.award[9] == 2 && loaded[3].names[1] == "Jon");
+    assert(loaded[3].rounds.size() == replays[3].rounds.size() && loaded[3].rounds[1].landed == replays[3].rounds[1].landed);
+    
+    std::vector<ReplayVerdict> verdicts = verifyReplays(loaded, 4);
+    for (const ReplayVerdict& verdict : verdicts) {
+        assert(verdict.ok);
+    }
+    
+    // Tampering is caught in the round it happened
+    Replay flipped = game;
+    flipped.rounds[5].landed ^= 1;
+    ReplayVerdict verdict = verifyReplay(flipped);
+    assert(!verdict.ok && verdict.round == 5);
+    Replay swapped = game;
+    for (TrickId trick = 0; table.settable(swapped.rounds[2].trick) >= 0; trick++) {
+        swapped.rounds[2].trick = trick; // the first trick harder than the rules allow
+    }
+    assert(!verifyReplay(swapped).ok && verifyReplay(swapped).round == 2);
+    Replay reseeded = game;
+    reseeded.seed++;
+    assert(!verifyReplay(reseeded).ok);
+    Replay claimed = game;
+    claimed.winner = 1 - claimed.winner;
+    assert(!verifyReplay(claimed).ok && verifyReplay(claimed).round == -1);
+    Replay banned = game;
+    banned.rules.maxDifficulty = 0;
+    assert(!verifyReplay(banned).ok);
+    
+    // A hand-edited file may not point outside the catalog or the rules table
+    std::ostringstream saved;
+    saveReplay(saved, game);
+    const std::string text = saved.str();
+    auto edited = [&](const std::string& from, const std::string& to) {
+        std::string changed = text;
+        size_t at = changed.find(from);
+        assert(at != std::string::npos);
+        changed.replace(at, from.size(), to);
+        std::istringstream in(changed);
+        Replay result;
+        return loadReplay(in, result);
+    };
+    std::string firstRound = text.substr(text.find("rounds ") + 7);
+    firstRound = firstRound.substr(0, firstRound.find(':') + 1);
+    std::string firstCheckpoint = text.substr(text.find("checkpoints ") + 12, 4);
+    assert(edited("rounds ", "rounds "));
+    assert(!edited("rounds " + firstRound, "rounds 999:"));
+    assert(!edited("rounds " + firstRound, "rounds -1:"));
+    assert(!edited("checkpoints " + firstCheckpoint, "checkpoints 0:0:60000 " + firstCheckpoint));
+    assert(!edited("skate-replay " + std::to_string(game.seed) + " 0", "skate-replay " + std::to_string(game.seed) + " 2"));
+    assert(!edited(" 2 1\nchances", " 9 1\nchances")); // 9 letters for missing a difficulty 9 trick
+    
+    std::cout << "✅ Replay test passed" << std::endl;
+}
+
+void testTrickOdds() {
+    // A big made-up catalog, so the odds come in several chunks
+    const size_t tricks = 3 * kOddsChunkTricks + 17;
+    std::vector<std::vector<int>> chances(2);
+    SimRng rng(3);
+    for (size_t t = 0; t < tricks; t++) {
+        chances[0].push_back(20 + rng.below(75));
+        chances[1].push_back(20 + rng.below(75));
+    }
+    RuleSet rules;
+    parseRuleSet("horse:retry", rules);
+    
+    std::mutex lock;
+    std::condition_variable arrived;
+    std::vector<double> odds(tricks, -1.0);
+    std::vector<long> requests;
+    size_t received = 0;
+    TrickOddsWorker worker([&](long request, size_t first, const std::vector<double>& values) {
+        std::lock_guard<std::mutex> guard(lock);
+        requests.push_back(request);
+        std::copy(values.begin(), values.end(), odds.begin() + first);
+        received += values.size();
+        arrived.notify_all();
+    });
+    worker.setMatchup(chances, rules, true);
+    BotState state = {{1, 3}, 1};
+    long request = worker.request(state);
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        arrived.wait(guard, [&]() { return received == tricks; });
+        assert(requests.size() == (tricks + kOddsChunkTricks - 1) / kOddsChunkTricks);
+        for (long r : requests) {
+            assert(r == request);
+        }
+    }
+    SolvedMatchup solved = solveMatchup(chances, rules, true);
+    std::vector<double> exact = trickWinChances(chances, solved, state);
+    for (size_t t = 0; t < tricks; t++) {
+        assert(std::fabs(odds[t] - exact[t]) < 1e-12);
+    }
+    
+    // Positions asked for in a burst: the last one is always answered in full
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        requests.clear();
+        received = 0;
+    }
+    BotState latest = state;
+    for (int i = 0; i < 20; i++) {
+        latest = {{i % 4, (i / 4) % 4}, i % 2};
+        request = worker.request(latest);
+    }
+    exact = trickWinChances(chances, solved, latest);
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        arrived.wait(guard, [&]() {
+            return std::count(requests.begin(), requests.end(), request) ==
+                   static_cast<long>((tricks + kOddsChunkTricks - 1) / kOddsChunkTricks);
+        });
+    }
+    for (size_t t = 0; t < tricks; t++) {
+        assert(std::fabs(odds[t] - exact[t]) < 1e-12);
+    }
+    
+    std::cout << "✅ Trick odds test passed" << std::endl;
+}
+
+void testHandicap() {
+    std::vector<int> difficulties;
+    std::vector<std::vector<int>> chances(2);
+    for (int trick = 0; trick < kDefaultTrickCount; trick++) {
+        difficulties.push_back(kDefaultTricks[trick].difficulty);
+        // The stronger skater is a lot better at the hard tricks
+        chances[0].push_back(kDefaultTricks[trick].threshold - 5);
+        chances[1].push_back(kDefaultTricks[trick].threshold + 3 * kDefaultTricks[trick].difficulty);
+    }
+    RuleSet rules;
+    
+    // No handicap is the plain solver
+    BotState start = {{0, 0}, 0};
+    double even = handicapWinChance(chances, difficulties, rules, Handicap());
+    assert(std::fabs(even - solveMatchup(chances, rules).winChance(start)) < 1e-9);
+    
+    // Each kind of handicap helps the weaker player
+    Handicap letters;
+    letters.startLetters[1] = 2;
+    Handicap tries;
+    tries.tries[0] = 2;
+    Handicap capped = tries; // the weaker player's extra tries make hard tricks worth setting
+    capped.maxDifficulty[1] = 3;
+    Handicap first;
+    first.firstSetter = 1;
+    double withTries = handicapWinChance(chances, difficulties, rules, tries);
+    assert(handicapWinChance(chances, difficulties, rules, letters) > even);
+    assert(withTries > even);
+    assert(handicapWinChance(chances, difficulties, rules, capped) > withTries);
+    assert(handicapWinChance(chances, difficulties, rules, first) < even);
+    
+    HandicapResult result = balanceHandicap(chances, difficulties, rules, 4);
+    assert(result.weaker == 0 && result.evenChance < 0.2);
+    assert(std::fabs(result.winChance - 0.5) < 0.01);
+    assert(std::fabs(handicapWinChance(chances, difficulties, rules, result.handicap) - result.winChance) < 1e-12);
+    // Only the stronger player is held back, and player 0 already sets first
+    assert(result.handicap.startLetters[0] == 0 && result.handicap.tries[1] == 1 && result.handicap.firstSetter == 0);
+    
+    // The same answer on one thread
+    HandicapResult single = balanceHandicap(chances, difficulties, rules, 1);
+    assert(single.winChance == result.winChance && single.evaluated == result.evaluated);
+    
+    std::cout << "✅ Handicap test passed" << std::endl;
+}
+
+void testSimWorkers() {
+    static_assert(sizeof(CachePadded<std::atomic<uint64_t>>) == kCacheLine, "one counter per cache line");
+    static_assert(alignof(CachePadded<SimWorkerStats>) == kCacheLine, "worker stats start a cache line");
+    
+    std::vector<int> cpus = spreadCpus();
+#ifdef __linux__
+    assert(!cpus.empty());
+    std::vector<int> sorted = cpus;
+    std::sort(sorted.begin(), sorted.end());
+    assert(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+    cpu_set_t before;
+    sched_getaffinity(0, sizeof(before), &before);
+#endif
+    
+    std::vector<SimWorkerStats> workers = runWorkers(4, true, [](int worker) { return 1000L * (worker + 1); });
+    assert(workers.size() == 4);
+    for (int w = 0; w < 4; w++) {
+        assert(workers[w].games == 1000L * (w + 1) && workers[w].seconds >= 0.0);
+#ifdef __linux__
+        // Pinned workers finish on the CPU they were given
+        assert(workers[w].cpu == cpus[w % cpus.size()]);
+#endif
+    }
+#ifdef __linux__
+    // The calling thread ran worker 0 and may use all its CPUs again
+    cpu_set_t after;
+    sched_getaffinity(0, sizeof(after), &after);
+    assert(CPU_EQUAL(&before, &after));
+#endif
+    
+    // Pinned or not, and on any number of workers, an estimate comes out the same (up to rounding)
+    Matchup matchup = defaultMatchup();
+    SimOptions options;
+    options.games = 40000;
+    options.threads = 1;
+    WinEstimate single = estimateWinProbability(matchup, options);
+    options.threads = 3;
+    options.pin = true;
+    WinEstimate pinned = estimateWinProbability(matchup, options);
+    assert(std::fabs(single.value - pinned.value) < 1e-9 && single.games == pinned.games);
+    assert(pinned.workers.size() == 3);
+    long games = 0;
+    for (const SimWorkerStats& worker : pinned.workers) {
+        games += worker.games;
+    }
+    assert(games == pinned.games);
+    
+    std::cout << "✅ Simulation workers test passed" << std::endl;
+}
+
+void testTrace() {
+#ifndef SKATE_TRACE
+    // Built without -DSKATE_TRACE the macros are gone, argument and all
+    SKATE_TRACE_SCOPE(notDeclaredAnywhere);
+    SKATE_TRACE_THREAD(notDeclaredEither);
+#endif
+    
+    auto count = [](const std::string& text, const std::string& what) {
+        size_t n = 0;
+        for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) {
+            n++;
+        }
+        return n;
+    };
+    
+    // Each thread writes its own ring, which keeps its newest events
+    std::thread tracer([]() {
+        traceThreadName("tracer");
+        for (int i = 0; i < 10; i++) {
+            TraceScope scope("oldest");
+        }
+        for (size_t i = 0; i < kTraceRingEvents; i++) {
+            TraceScope scope("newest");
+        }
+    });
+    tracer.join();
+    {
+        TraceScope outer("outer \"quoted\"");
+        TraceScope inner("inner");
+    }
+    
+    std::ostringstream out;
+    out << 1.5;
+    writeChromeTrace(out);
+    std::string trace = out.str();
+    assert(trace.compare(0, 3, "1.5") == 0 && trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 3);
+    assert(trace.substr(trace.size() - 4) == "\n]}\n");
+    assert(count(trace, "\"name\":\"oldest\"") == 0);
+    assert(count(trace, "\"name\":\"newest\"") == kTraceRingEvents);
+    assert(count(trace, "\"ph\":\"M\",\"pid\":1,\"tid\":") >= 1 && count(trace, "\"args\":{\"name\":\"tracer\"}") == 1);
+    assert(count(trace, "\"name\":\"outer \\\"quoted\\\"\"") == 1 && count(trace, "\"name\":\"inner\"") == 1);
+    
+    // The inner scope closes first and lies within the outer one
+    size_t innerAt = trace.find("\"name\":\"inner\"");
+    size_t outerAt = trace.find("\"name\":\"outer");
+    assert(innerAt < outerAt);
+    auto field = [&](size_t from, const char* name) {
+        return std::stod(trace.substr(trace.find(name, from) + std::strlen(name)));
+    };
+    double innerStart = field(innerAt, "\"ts\":");
+    double outerStart = field(outerAt, "\"ts\":");
+    assert(outerStart <= innerStart && innerStart >= 0.0);
+    assert(innerStart + field(innerAt, "\"dur\":") <= outerStart + field(outerAt, "\"dur\":") + 0.001);
+    // Writing left the stream's number format alone
+    out.str("");
+    out << 1.5;
+    assert(out.str() == "1.5");
+    
+    // Threads started for every batch reuse the rings of threads gone before them
+    auto batch = []() {
+        for (int i = 0; i < 100; i++) {
+            std::thread worker([i]() {
+                traceThreadName(("worker " + std::to_string(i)).c_str());
+                TraceScope scope("batch");
+            });
+            worker.join();
+        }
+    };
+    size_t rings = TraceRecorder::instance().ringCount();
+    batch();
+    assert(TraceRecorder::instance().ringCount() <= rings + kTraceKeptRings + 1);
+    out.str("");
+    writeChromeTrace(out);
+    // The latest exited threads are in the trace; the rings of earlier ones went to later ones
+    assert(count(out.str(), "\"name\":\"batch\"") == kTraceKeptRings && count(out.str(), "worker 99") == 1);
+    rings = TraceRecorder::instance().ringCount();
+    batch();
+    assert(TraceRecorder::instance().ringCount() == rings);
+    
+    std::cout << "✅ Trace test passed" << std::endl;
+}
+
+void testLatencyMonitor() {
+    typedef LatencyMonitor::Clock Clock;
+    auto at = [](double ms) {
+        return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms)));
+    };
+    std::ostringstream log;
+    LatencyMonitor monitor;
+    monitor.logTo(&log);
+    
+    // A paint with no input waiting measures nothing
+    assert(!monitor.painted(at(5.0)));
+    // Two inputs before the next frame: measured from the first
+    assert(!monitor.waiting());
+    monitor.input(at(10.0));
+    monitor.input(at(12.0));
+    assert(monitor.waiting());
+    assert(monitor.painted(at(18.0)) && !monitor.waiting());
+    assert(!monitor.painted(at(20.0)));
+    for (int i = 1; i <= 19; i++) {
+        monitor.input(at(100.0 * i));
+        assert(monitor.painted(at(100.0 * i + i)));
+    }
+    LatencySummary clicks = monitor.inputLatency();
+    assert(clicks.count == 20 && std::fabs(clicks.last - 19.0) < 1e-6 && std::fabs(clicks.max - 19.0) < 1e-6);
+    assert(std::fabs(clicks.median - 9.0) < 1e-6 && std::fabs(clicks.p95 - 18.0) < 1e-6);
+    
+    // Heartbeats on time are no stall, one 200 ms late is
+    Clock::time_point beat = at(5000.0);
+    for (int i = 0; i < 10; i++) {
+        assert(!monitor.heartbeat(beat));
+        beat += std::chrono::milliseconds(kHeartbeatMs + 2);
+    }
+    beat += std::chrono::milliseconds(200);
+    assert(monitor.heartbeat(beat));
+    LatencySummary stalls = monitor.stallLength();
+    assert(stalls.count == 1 && std::fabs(stalls.max - 202.0) < 1e-3);
+    
+    // Every sample is logged as it happens
+    std::istringstream lines(log.str());
+    std::string line;
+    int inputs = 0;
+    int stallLines = 0;
+    while (std::getline(lines, line)) {
+        inputs += line.find("\tinput\t") != std::string::npos ? 1 : 0;
+        stallLines += line.find("\tstall\t") != std::string::npos ? 1 : 0;
+    }
+    assert(inputs == 20 && stallLines == 1);
+    assert(log.str().find("\tinput\t8.000\n") != std::string::npos);
+    
+    // An input that paints nothing is dropped after a whole beat, not charged to a later paint
+    monitor.input(beat + std::chrono::milliseconds(1));
+    assert(!monitor.heartbeat(beat + std::chrono::milliseconds(kHeartbeatMs)) && monitor.waiting());
+    assert(!monitor.heartbeat(beat + std::chrono::milliseconds(2 * kHeartbeatMs)) && !monitor.waiting());
+    assert(!monitor.painted(beat + std::chrono::milliseconds(2 * kHeartbeatMs + 5)) && monitor.unpainted() == 1);
+    // One whose slot stalls the loop is still painted after the late beat
+    beat += std::chrono::milliseconds(2 * kHeartbeatMs);
+    monitor.input(beat + std::chrono::milliseconds(1));
+    assert(monitor.heartbeat(beat + std::chrono::milliseconds(300)) && monitor.waiting());
+    assert(monitor.painted(beat + std::chrono::milliseconds(301)) && monitor.unpainted() == 1);
+    assert(std::fabs(monitor.inputLatency().last - 300.0) < 1e-3 && monitor.inputLatency().count == 21);
+    
+    // Only the latest samples count towards the percentiles
+    LatencySamples samples;
+    for (size_t i = 0; i < kLatencySamples; i++) {
+        samples.add(1000.0);
+    }
+    for (size_t i = 0; i < kLatencySamples; i++) {
+        samples.add(1.0);
+    }
+    LatencySummary recent = samples.summary();
+    assert(recent.count == 2 * kLatencySamples && recent.max == 1.0 && recent.last == 1.0);
+    
+    std::cout << "✅ Latency monitor test passed" << std::endl;
+}
+
+void testSessionArena() {
+    SlabPool pool;
+    {
+        SessionArena arena(pool);
+        // Blocks are aligned, rounded up to their class and reused once given back
+        void* a = arena.allocate(24);
+        void* b = arena.allocate(24);
+        assert(reinterpret_cast<uintptr_t>(a) % kArenaAlign == 0 && static_cast<char*>(b) - static_cast<char*>(a) == 32);
+        arena.deallocate(a, 24);
+        assert(arena.allocate(32) == a && arena.statistics().reused == 1);
+        void* big = arena.allocate(kArenaLargest + 1);
+        arena.deallocate(big, kArenaLargest + 1);
+        assert(arena.statistics().large == 1);
+        
+        // Filling more than a slab takes another; reset gives them all back
+        for (size_t i = 0; i < kSlabBytes / 1024 + 1; i++) {
+            arena.allocate(1024);
+        }
+        assert(arena.statistics().slabs == 2 && pool.allocated() == 2);
+        arena.reset();
+        assert(pool.idle() == 2 && arena.statistics().slabs == 0);
+        
+        // Containers work on top of it
+        std::vector<int, ArenaAllocator<int>> numbers{ArenaAllocator<int>(&arena)};
+        for (int i = 0; i < 1000; i++) {
+            numbers.push_back(i);
+        }
+        assert(numbers[999] == 999 && pool.allocated() == 2);
+    }
+    assert(pool.idle() == 2);
+    
+    // Matches coming and going reuse their slots and slabs: after the first wave the scheduler
+    // takes nothing more from the system
+    CompiledRules rules = compileHouseRules(houseRulesFor(RuleSet()));
+    std::vector<std::vector<int>> chances(2, rules.thresholds);
+    TurnScheduler scheduler;
+    const int kLive = 200;
+    size_t slabsAfterFirstWave = 0;
+    int winners[2] = {0, 0};
+    for (int wave = 0; wave < 5; wave++) {
+        std::vector<int> ids;
+        for (int i = 0; i < kLive; i++) {
+            ids.push_back(scheduler.start(rules, chances, wave * kLive + i + 1, i % 2));
+        }
+        assert(scheduler.matchCount() == static_cast<size_t>(kLive));
+        for (bool waiting = true; waiting;) {
+            scheduler.runReady();
+            scheduler.clearEvents();
+            waiting = false;
+            for (int id : ids) {
+                if (scheduler.isWaiting(id)) {
+                    scheduler.deliver(id, scheduler.waitingFor(id), id % kDefaultTrickCount);
+                    waiting = true;
+                }
+            }
+        }
+        for (int id : ids) {
+            assert(scheduler.isOver(id));
+            winners[scheduler.winner(id)]++;
+            assert(scheduler.release(id) && !scheduler.release(id));
+        }
+        if (wave == 0) {
+            slabsAfterFirstWave = scheduler.slabPool().allocated();
+        }
+        assert(scheduler.slabPool().allocated() == slabsAfterFirstWave);
+        assert(scheduler.slabPool().idle() == slabsAfterFirstWave);
+    }
+    ArenaStats memory = scheduler.memory();
+    // The coroutine frame and both players' chances of every match came from its arena
+    assert(memory.allocations >= 3 * 5 * kLive && memory.large == 0 && memory.resets == 5 * kLive);
+    assert(memory.slabs == 0 && winners[0] > 0 && winners[1] > 0);
+    
+    // A match still being played is not released
+    int id = scheduler.start(rules, chances, 1);
+    scheduler.runReady();
+    assert(!scheduler.release(id));
+    
+    std::cout << "✅ Session arena test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running SKATE game tests...\n" << std::endl;
     
@@ -193,8 +1934,36 @@ int main() {
     testAddLetter();
     testHasLost();
     testTrickSuccess();
+    testTrickCatalog();
     testGameFlow();
     testEdgeCases();
+    testBotRoundOutcomes();
+    testBotChoosesTrick();
+    testBotPlaysHouseRules();
+    testBotLastLetterRetry();
+    testSkillFitter();
+    testSkillLogAndModelFile();
+    testSimulateGame();
+    testVarianceReducedEstimate();
+    testSequentialStopping();
+    testBalanceSweep();
+    testRuleVariants();
+    testHouseRules();
+    testSolver();
+    testResultCache();
+    testSession();
+    testTurnEngine();
+    testSpectatorBroadcast();
+    testLeaderboard();
+    testAttemptStore();
+    testAttemptCodec();
+    testReplay();
+    testTrickOdds();
+    testHandicap();
+    testSimWorkers();
+    testTrace();
+    testLatencyMonitor();
+    testSessionArena();
     
     std::cout << "\nAll tests passed successfully!" << std::endl;
     return 0;
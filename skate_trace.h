@@ -0,0 +1,253 @@
+// Game of Skate - tracing
+// Shows where the time goes inside a round: trick selection, attempts, letters, role switches,
+// I/O and GUI slots, viewed as a timeline in chrome://tracing or ui.perfetto.dev.
+//
+// Mark a scope with SKATE_TRACE_SCOPE("name") and build with -DSKATE_TRACE. Without the flag
+// the macros expand to nothing, so the game is the same code as before. With it, a scope reads
+// the time stamp counter when it opens and when it closes and writes one event into its thread's
+// own ring buffer: no lock, no allocation, nothing shared with other threads. A ring keeps the
+// last kTraceRingEvents events of its thread.
+//
+// A thread that exits hands its ring back. The ring is kept, events and all, until the next
+// writeChromeTrace(), then given to a new thread; past kTraceKeptRings exited rings the oldest is
+// given away unwritten. So a traced server that starts workers for every batch holds one ring
+// per live thread plus at most kTraceKeptRings, not one for every thread it ever ran.
+//
+// writeChromeTrace() writes every ring as Chrome trace JSON; call it once the traced work is done.
+// Names must be string literals (or live as long as the trace).
+//
+// C++11, so the console game can use it.
+
+#ifndef SKATE_TRACE_H
+#define SKATE_TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+// Events each thread keeps (a power of two)
+const size_t kTraceRingEvents = 1 << 16;
+
+// Rings of exited threads kept for the next trace
+const size_t kTraceKeptRings = 16;
+
+#ifdef SKATE_TRACE
+const bool kTraceEnabled = true;
+#else
+const bool kTraceEnabled = false;
+#endif
+
+// Time stamp counter where there is one, nanoseconds elsewhere
+inline uint64_t traceClock() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Written only by its own thread
+struct TraceRing {
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> written;
+    int thread;
+    std::string name;
+
+    explicit TraceRing(int id) : events(kTraceRingEvents), written(0), thread(id) {}
+
+    void add(const char* event, uint64_t start, uint64_t end) {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        TraceEvent& slot = events[n & (kTraceRingEvents - 1)];
+        slot.name = event;
+        slot.start = start;
+        slot.end = end;
+        written.store(n + 1, std::memory_order_release);
+    }
+};
+
+class TraceRecorder {
+public:
+    static TraceRecorder& instance() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    // The calling thread's ring, taken on its first event and handed back when it exits
+    TraceRing& ring() {
+        static thread_local Lease mine;
+        if (!mine.ring) {
+            mine.ring = acquire();
+        }
+        return *mine.ring;
+    }
+
+    // Rings made so far, whoever has them
+    size_t ringCount() {
+        std::lock_guard<std::mutex> guard(lock);
+        return rings.size();
+    }
+
+    // Every ring as Chrome trace JSON, times in microseconds since the recorder started
+    void write(std::ostream& out) {
+        // Ticks per microsecond, measured over the whole run so far
+        uint64_t ticks = traceClock() - startTicks;
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+        double perMicro = micros > 0.0 && ticks > 0 ? ticks / micros : 1000.0;
+
+        std::lock_guard<std::mutex> guard(lock);
+        // To the nanosecond, however long the run
+        std::ios::fmtflags flags = out.flags(std::ios::fixed);
+        std::streamsize precision = out.precision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const std::unique_ptr<TraceRing>& ring : rings) {
+            if (isIdle(ring.get())) {
+                continue;
+            }
+            if (!ring->name.empty()) {
+                out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->thread
+                    << ",\"args\":{\"name\":\"" << escaped(ring->name.c_str()) << "\"}}";
+                first = false;
+            }
+            uint64_t written = ring->written.load(std::memory_order_acquire);
+            uint64_t from = written > kTraceRingEvents ? written - kTraceRingEvents : 0;
+            for (uint64_t i = from; i < written; i++) {
+                const TraceEvent& event = ring->events[i & (kTraceRingEvents - 1)];
+                out << (first ? "" : ",") << "\n{\"name\":\"" << escaped(event.name)
+                    << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread
+                    << ",\"ts\":" << static_cast<double>(event.start - startTicks) / perMicro
+                    << ",\"dur\":" << static_cast<double>(event.end - event.start) / perMicro << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+        out.flags(flags);
+        out.precision(precision);
+
+        // Exited threads are in this trace; their rings can go to new threads
+        idle.insert(idle.end(), exited.begin(), exited.end());
+        exited.clear();
+    }
+
+private:
+    // Hands the ring back when its thread exits
+    struct Lease {
+        TraceRing* ring;
+
+        Lease() : ring(nullptr) {}
+        ~Lease() {
+            if (ring) {
+                TraceRecorder::instance().release(ring);
+            }
+        }
+    };
+
+    TraceRecorder() : startTicks(traceClock()), startTime(std::chrono::steady_clock::now()), threads(0) {}
+
+    TraceRing* acquire() {
+        std::lock_guard<std::mutex> guard(lock);
+        TraceRing* ring;
+        if (!idle.empty()) {
+            ring = idle.back();
+            idle.pop_back();
+            ring->written.store(0, std::memory_order_relaxed);
+            ring->name.clear();
+            ring->thread = ++threads;
+        } else {
+            rings.push_back(std::unique_ptr<TraceRing>(new TraceRing(++threads)));
+            ring = rings.back().get();
+        }
+        return ring;
+    }
+
+    void release(TraceRing* ring) {
+        std::lock_guard<std::mutex> guard(lock);
+        exited.push_back(ring);
+        if (exited.size() > kTraceKeptRings) {
+            idle.push_back(exited.front());
+            exited.erase(exited.begin());
+        }
+    }
+
+    bool isIdle(const TraceRing* ring) const {
+        return std::find(idle.begin(), idle.end(), ring) != idle.end();
+    }
+
+    static std::string escaped(const char* text) {
+        std::string result;
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                result += '\\';
+            }
+            result += static_cast<unsigned char>(*c) < 0x20 ? ' ' : *c;
+        }
+        return result;
+    }
+
+    std::mutex lock; // taken when a thread starts or stops tracing, and to write the trace
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    std::vector<TraceRing*> exited; // oldest first, waiting for the next trace
+    std::vector<TraceRing*> idle;   // free for the next thread
+    uint64_t startTicks;
+    std::chrono::steady_clock::time_point startTime;
+    int threads; // thread ids handed out, so a reused ring shows as a new thread
+};
+
+// One event from construction to destruction
+class TraceScope {
+public:
+    explicit TraceScope(const char* event) : ring(TraceRecorder::instance().ring()), name(event), start(traceClock()) {}
+
+    ~TraceScope() {
+        ring.add(name, start, traceClock());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceRing& ring;
+    const char* name;
+    uint64_t start;
+};
+
+// Name the calling thread in the trace
+inline void traceThreadName(const char* name) {
+    TraceRecorder::instance().ring().name = name;
+}
+
+inline void writeChromeTrace(std::ostream& out) {
+    TraceRecorder::instance().write(out);
+}
+
+#ifdef SKATE_TRACE
+#define SKATE_TRACE_JOIN2(a, b) a##b
+#define SKATE_TRACE_JOIN(a, b) SKATE_TRACE_JOIN2(a, b)
+#define SKATE_TRACE_SCOPE(name) TraceScope SKATE_TRACE_JOIN(traceScope, __LINE__)(name)
+#define SKATE_TRACE_THREAD(name) traceThreadName(name)
+#else
+#define SKATE_TRACE_SCOPE(name)
+#define SKATE_TRACE_THREAD(name)
+#endif
+
+#endif // SKATE_TRACE_H
@@ -0,0 +1,447 @@
+// Game of Skate - turn engine
+// The rounds of Game::playRound written as C++20 coroutines, so one thread can host any
+// number of interactive matches. A match suspends whenever it needs a player (the setter's
+// trick, the responder's go at matching it) and the scheduler resumes it once the front end
+// delivers the input, or once the player's time to answer runs out. A waiting match is just
+// its coroutine frame and a slot in the scheduler - no thread, no stack.
+//
+// Front ends (console, socket, GUI) call deliver() with who sent what, then
+// runReady() and fireTimers(), and read what happened from events(). Rules come from a
+// compiled house rules table, so the built-in variants and house rules both work.
+//
+// Everything a match allocates (its players' chances, its coroutine frame) lives in the match's
+// own arena (see skate_arena.h). release() frees a finished match in one go and lets the next
+// start() reuse its slot, so a server that keeps matches coming and going stops calling malloc.
+//
+// Needs -std=c++20.
+
+#ifndef SKATE_TURNS_H
+#define SKATE_TURNS_H
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "skate_arena.h"
+#include "skate_core.h"
+#include "skate_house.h"
+#include "skate_sim.h"
+
+// What the engine reports to the front end
+enum TurnEventType {
+    TURN_CHOOSE_TRICK,   // player is to set a trick
+    TURN_INVALID_TRICK,  // player asked for a trick the rules do not allow
+    TURN_SET_LANDED,     // setter landed trick
+    TURN_SET_MISSED,     // setter missed trick
+    TURN_ATTEMPT,        // player is to try to match trick (value: which try)
+    TURN_MATCH_LANDED,   // responder landed trick
+    TURN_MATCH_MISSED,   // responder missed trick (value: which try)
+    TURN_LETTERS,        // player now holds value letters
+    TURN_SETTER_CHANGED, // player sets from now on
+    TURN_TIMED_OUT,      // player did not answer in time
+    TURN_GAME_OVER,      // player won
+    TURN_MATCH_CLOSED    // the match was released; its id may be given to a new one
+};
+
+struct TurnEvent {
+    int match;
+    TurnEventType type;
+    int player; // 0 or 1
+    TrickId trick;
+    int value;
+};
+
+// What a player sent: a trick to set, or anything to go for the match
+struct TurnInput {
+    bool given; // false if the player ran out of time
+    int value;
+};
+
+// Coroutine of one match. It starts suspended; the scheduler resumes it.
+struct MatchTask {
+    struct promise_type {
+        // The frame of TurnScheduler::playMatch(id) goes in the match's arena, any other in the
+        // heap; a header before the frame remembers which
+        template <typename Host>
+        static void* operator new(std::size_t size, Host& host, int id) {
+            return framed(&host.arenaOf(id), size);
+        }
+
+        static void* operator new(std::size_t size) {
+            return framed(nullptr, size);
+        }
+
+        static void operator delete(void* frame, std::size_t size) {
+            FrameHeader* header = static_cast<FrameHeader*>(frame) - 1;
+            if (header->arena) {
+                header->arena->deallocate(header, sizeof(FrameHeader) + size);
+            } else {
+                ::operator delete(header);
+            }
+        }
+
+        struct alignas(kArenaAlign) FrameHeader {
+            SessionArena* arena;
+        };
+
+        static void* framed(SessionArena* arena, std::size_t size) {
+            size_t bytes = sizeof(FrameHeader) + size;
+            void* block = arena ? arena->allocate(bytes) : ::operator new(bytes);
+            FrameHeader* header = static_cast<FrameHeader*>(block);
+            header->arena = arena;
+            return header + 1;
+        }
+
+        MatchTask get_return_object() {
+            return MatchTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    MatchTask() : handle(nullptr) {}
+    explicit MatchTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    MatchTask(MatchTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    MatchTask& operator=(MatchTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    MatchTask(const MatchTask&) = delete;
+    MatchTask& operator=(const MatchTask&) = delete;
+    ~MatchTask() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+};
+
+class TurnScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // answerMs: how long a player has to answer; 0 waits forever
+    explicit TurnScheduler(int answerMs = 0) : answerMs(answerMs), clock(Clock::now()) {}
+
+    // Starts a match between two players; chances[player][trick] in percent over the full trick
+    // list, as Game::trickChance gives them. `rules` must outlive the match.
+    // The id of a released match is given to a later one.
+    int start(const CompiledRules& rules, const std::vector<std::vector<int>>& chances, uint64_t seed,
+              int firstSetter = 0) {
+        int id;
+        if (!released.empty()) {
+            id = released.back();
+            released.pop_back();
+        } else {
+            id = static_cast<int>(matches.size());
+            matches.emplace_back(slabs);
+        }
+        Match& match = matches[id];
+        match.rules = &rules;
+        match.chances[0].assign(chances[0].begin(), chances[0].end());
+        match.chances[1].assign(chances[1].begin(), chances[1].end());
+        match.rng = SimRng(seed);
+        match.position = firstSetter;
+        match.winner = -1;
+        match.turn = -1;
+        match.hasInput = false;
+        match.timedOut = false;
+        match.task = playMatch(id);
+        ready.push_back(match.task.handle);
+        return id;
+    }
+
+    // Frees a finished match's memory all at once; false if it is still being played.
+    // Reports TURN_MATCH_CLOSED, so spectators of the id let go of the old match.
+    bool release(int id) {
+        Match& match = matches[id];
+        if (match.winner < 0 || !match.task.handle) {
+            return false;
+        }
+        emit(id, TURN_MATCH_CLOSED, match.winner, 0, 0);
+        match.task = MatchTask();
+        for (int player = 0; player < 2; player++) {
+            ChanceList(ArenaAllocator<int>(&match.arena)).swap(match.chances[player]);
+        }
+        match.arena.reset();
+        released.push_back(id);
+        return true;
+    }
+
+    // What `player` entered; false, and ignored, unless the match is waiting for that player.
+    // Only the latest input is kept until the match takes it.
+    bool deliver(int id, int player, int value) {
+        Match& match = matches[id];
+        if (player != match.turn) {
+            return false;
+        }
+        match.input = value;
+        match.hasInput = true;
+        wake(match);
+        return true;
+    }
+
+    // Resumes every match that has something to do; returns how many were resumed.
+    // A player asked for input now has until `now` plus their time to answer.
+    size_t runReady(Clock::time_point now) {
+        clock = now;
+        size_t resumed = 0;
+        while (!ready.empty()) {
+            // Matches woken meanwhile queue up for the next pass; both lists keep their memory
+            running.swap(ready);
+            for (std::coroutine_handle<> handle : running) {
+                handle.resume();
+                resumed++;
+            }
+            running.clear();
+        }
+        return resumed;
+    }
+
+    size_t runReady() {
+        return runReady(Clock::now());
+    }
+
+    // Times out the players whose time to answer is up by `now`
+    void fireTimers(Clock::time_point now) {
+        while (!timers.empty() && timers.top().deadline <= now) {
+            Timer timer = timers.top();
+            timers.pop();
+            Match& match = matches[timer.match];
+            if (match.waiting && match.waits == timer.wait) {
+                match.timedOut = true;
+                wake(match);
+            }
+        }
+    }
+
+    void fireTimers() {
+        fireTimers(Clock::now());
+    }
+
+    // Is the match waiting for a player?
+    bool isWaiting(int id) const {
+        return matches[id].waiting != nullptr;
+    }
+
+    bool isOver(int id) const {
+        return matches[id].winner >= 0;
+    }
+
+    int winner(int id) const {
+        return matches[id].winner;
+    }
+
+    // Whose input the match is waiting for
+    int waitingFor(int id) const {
+        return matches[id].turn;
+    }
+
+    int position(int id) const {
+        return matches[id].position;
+    }
+
+    size_t matchCount() const {
+        return matches.size();
+    }
+
+    // Memory of every match slot, and the slabs behind it
+    ArenaStats memory() const {
+        ArenaStats total = {0, 0, 0, 0, 0};
+        for (const Match& match : matches) {
+            total.add(match.arena.statistics());
+        }
+        return total;
+    }
+
+    const SlabPool& slabPool() const {
+        return slabs;
+    }
+
+    // Everything that happened since the last clearEvents(), in order
+    const std::vector<TurnEvent>& events() const {
+        return eventLog;
+    }
+
+    void clearEvents() {
+        eventLog.clear();
+    }
+
+private:
+    friend struct MatchTask::promise_type;
+
+    typedef std::vector<int, ArenaAllocator<int>> ChanceList;
+
+    struct Match {
+        explicit Match(SlabPool& slabs)
+            : arena(slabs), chances{ChanceList(ArenaAllocator<int>(&arena)), ChanceList(ArenaAllocator<int>(&arena))} {}
+
+        SessionArena arena; // before everything kept in it
+        const CompiledRules* rules = nullptr;
+        ChanceList chances[2];
+        SimRng rng{0};
+        int position = 0;
+        int winner = -1;
+        int turn = -1;     // player the match is waiting for
+        int input = 0;
+        bool hasInput = false;
+        bool timedOut = false;
+        uint64_t waits = 0; // count of suspensions, to tell stale timers apart
+        std::coroutine_handle<> waiting;
+        MatchTask task;
+    };
+
+    struct Timer {
+        Clock::time_point deadline;
+        int match;
+        uint64_t wait;
+
+        bool operator<(const Timer& other) const {
+            return deadline > other.deadline; // earliest on top
+        }
+    };
+
+    // Suspends the match until `player` sends something or runs out of time
+    struct InputAwaiter {
+        TurnScheduler* scheduler;
+        int id;
+        int player;
+
+        bool await_ready() {
+            Match& match = scheduler->matches[id];
+            match.turn = player;
+            return match.hasInput;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            Match& match = scheduler->matches[id];
+            match.waiting = handle;
+            match.waits++;
+            if (scheduler->answerMs > 0) {
+                Timer timer = {scheduler->clock + std::chrono::milliseconds(scheduler->answerMs), id, match.waits};
+                scheduler->timers.push(timer);
+            }
+        }
+
+        TurnInput await_resume() {
+            Match& match = scheduler->matches[id];
+            match.turn = -1;
+            TurnInput result = {match.hasInput, match.input};
+            if (!match.hasInput && match.timedOut) {
+                scheduler->emit(id, TURN_TIMED_OUT, player, 0, 0);
+            }
+            match.hasInput = false;
+            match.timedOut = false;
+            return result;
+        }
+    };
+
+    SessionArena& arenaOf(int id) {
+        return matches[id].arena;
+    }
+
+    InputAwaiter input(int id, int player) {
+        return InputAwaiter{this, id, player};
+    }
+
+    void wake(Match& match) {
+        if (match.waiting) {
+            ready.push_back(match.waiting);
+            match.waiting = nullptr;
+        }
+    }
+
+    void emit(int id, TurnEventType type, int player, int trick, int value) {
+        TurnEvent event = {id, type, player, static_cast<TrickId>(trick), value};
+        eventLog.push_back(event);
+    }
+
+    // Random number between 1-100, like attemptTrick
+    bool lands(Match& match, int player, int trick) {
+        return match.rng.roll() <= match.chances[player][trick];
+    }
+
+    // Same rounds as Game::playRound, with the house rules table deciding what happens next
+    MatchTask playMatch(int id) {
+        Match& match = matches[id];
+        const CompiledRules& rules = *match.rules;
+        while (rules.winner[match.position] < 0) {
+            int position = match.position;
+            int setter = rules.positions[position].setter;
+            int responder = 1 - setter;
+
+            emit(id, TURN_CHOOSE_TRICK, setter, 0, 0);
+            int trick = -1;
+            while (trick < 0) {
+                TurnInput choice = co_await input(id, setter);
+                if (!choice.given) {
+                    break; // out of time: the set counts as missed
+                }
+                if (rules.settable(choice.value) >= 0) {
+                    trick = choice.value;
+                } else {
+                    emit(id, TURN_INVALID_TRICK, setter, 0, choice.value);
+                }
+            }
+
+            int event = HOUSE_SETTER_MISSED;
+            if (trick >= 0 && !lands(match, setter, trick)) {
+                emit(id, TURN_SET_MISSED, setter, trick, 0);
+            } else if (trick >= 0) {
+                emit(id, TURN_SET_LANDED, setter, trick, 0);
+                int tries = rules.tries[position];
+                event = HOUSE_BOTH_LANDED;
+                for (int attempt = 1; attempt <= tries; attempt++) {
+                    emit(id, TURN_ATTEMPT, responder, trick, attempt);
+                    co_await input(id, responder); // out of time still attempts
+                    if (lands(match, responder, trick)) {
+                        emit(id, TURN_MATCH_LANDED, responder, trick, attempt);
+                        break;
+                    }
+                    emit(id, TURN_MATCH_MISSED, responder, trick, attempt);
+                    if (attempt == tries) {
+                        event = rules.missEvent[rules.settable(trick)];
+                    }
+                }
+            }
+
+            int next = rules.after(position, event);
+            for (int player = 0; player < 2; player++) {
+                if (rules.positions[next].letters[player] != rules.positions[position].letters[player]) {
+                    emit(id, TURN_LETTERS, player, 0, rules.positions[next].letters[player]);
+                }
+            }
+            match.position = next;
+            if (rules.winner[next] < 0 && rules.positions[next].setter != setter) {
+                emit(id, TURN_SETTER_CHANGED, rules.positions[next].setter, 0, 0);
+            }
+        }
+        match.winner = rules.winner[match.position];
+        emit(id, TURN_GAME_OVER, match.winner, 0, 0);
+    }
+
+    int answerMs;
+    Clock::time_point clock; // time of the last runReady(), where answer times count from
+    SlabPool slabs; // before the matches, whose arenas give their slabs back to it
+    std::deque<Match> matches; // a deque, so a match never moves while its coroutine runs
+    std::vector<int> released; // slots free for the next match
+    std::vector<std::coroutine_handle<>> ready;
+    std::vector<std::coroutine_handle<>> running;
+    std::priority_queue<Timer> timers;
+    std::vector<TurnEvent> eventLog;
+};
+
+#endif // SKATE_TURNS_H
@@ -0,0 +1,181 @@
+// Game of Skate - simulation workers
+// Runs one simulation worker per hardware thread without the workers getting in each other's way
+// on big multi-socket machines.
+//
+// - Workers can be pinned, one to a CPU, taking the NUMA nodes in turn. A pinned worker
+//   allocates what it writes (its copy of the matchup, its sums) itself after pinning, so
+//   first-touch allocation puts that memory on the worker's own node.
+// - Anything workers share sits on a cache line of its own (CachePadded), and their sums are
+//   only merged at the end of a batch, so no two workers write to one line while playing.
+// - Every worker reports its CPU, node, games and time, so one that falls behind shows up.
+//
+// Pinning and nodes need Linux; elsewhere workers run wherever the system puts them.
+
+#ifndef SKATE_WORKERS_H
+#define SKATE_WORKERS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skate_trace.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+// Size of a cache line on the machines we run on (x86-64 and most ARM servers)
+const size_t kCacheLine = 64;
+
+// A value alone on its cache line(s)
+template <typename T>
+struct alignas(kCacheLine) CachePadded {
+    T value;
+};
+
+struct SimWorkerStats {
+    int cpu;        // CPU the worker finished on, or -1 if unknown
+    int node;       // NUMA node of that CPU, or -1 if unknown
+    long games;
+    double seconds;
+
+    double gamesPerSecond() const {
+        return seconds > 0.0 ? games / seconds : 0.0;
+    }
+};
+
+// NUMA node of a CPU, or -1
+inline int cpuNode(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) {
+        return -1;
+    }
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return -1;
+    }
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = std::atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+inline int currentCpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+// The CPUs this process may run on, ordered so that consecutive workers take the NUMA nodes in
+// turn: with fewer workers than CPUs every node still gets its share
+inline std::vector<int> spreadCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return cpus;
+    }
+    std::vector<std::vector<int>> byNode;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            size_t node = static_cast<size_t>(std::max(0, cpuNode(cpu)));
+            if (byNode.size() <= node) {
+                byNode.resize(node + 1);
+            }
+            byNode[node].push_back(cpu);
+        }
+    }
+    for (size_t i = 0; cpus.size() < static_cast<size_t>(CPU_COUNT(&allowed)); i++) {
+        for (const std::vector<int>& node : byNode) {
+            if (i < node.size()) {
+                cpus.push_back(node[i]);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+// Pins the calling thread to one CPU
+inline bool pinToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Runs body(worker) on `threads` workers, the calling thread being worker 0; body returns the
+// games it played. With `pin` every worker is pinned before body starts, and the calling thread
+// gets its old CPUs back afterwards.
+template <typename F>
+inline std::vector<SimWorkerStats> runWorkers(int threads, bool pin, F body) {
+    threads = std::max(1, threads);
+    std::vector<int> cpus = pin ? spreadCpus() : std::vector<int>();
+    std::vector<CachePadded<SimWorkerStats>> stats(static_cast<size_t>(threads));
+    auto run = [&](int worker) {
+        if (worker > 0) {
+            SKATE_TRACE_THREAD(("sim worker " + std::to_string(worker)).c_str());
+        }
+        if (!cpus.empty()) {
+            pinToCpu(cpus[static_cast<size_t>(worker) % cpus.size()]);
+        }
+        auto start = std::chrono::steady_clock::now();
+        long games = body(worker);
+        SimWorkerStats& mine = stats[static_cast<size_t>(worker)].value;
+        mine.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        mine.games = games;
+        mine.cpu = currentCpu();
+        mine.node = cpuNode(mine.cpu);
+    };
+
+#ifdef __linux__
+    cpu_set_t callerCpus;
+    bool restore = !cpus.empty() && pthread_getaffinity_np(pthread_self(), sizeof(callerCpus), &callerCpus) == 0;
+#endif
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(run, t);
+    }
+    run(0);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+#ifdef __linux__
+    if (restore) {
+        pthread_setaffinity_np(pthread_self(), sizeof(callerCpus), &callerCpus);
+    }
+#endif
+
+    std::vector<SimWorkerStats> result;
+    for (const auto& slot : stats) {
+        result.push_back(slot.value);
+    }
+    return result;
+}
+
+#endif // SKATE_WORKERS_H